@@ -0,0 +1,189 @@
+/*!
+ * \file            bloom_filter.c
+ * \brief           Implementation of blocked Bloom filter data structure.
+ * \details         The filter is split into 512-bit blocks, each aligned
+ * to a 64-byte cache line. All the bits for a key are set within a single
+ * block chosen by its hash, so a query touches exactly one cache line, at
+ * the cost of a slightly higher false positive rate than a classic Bloom
+ * filter of the same size. Keys are supplied as 64-bit hashes, which
+ * should be well mixed.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_bloom_filter.h"
+
+
+/*!
+ * \brief           Size of a filter block in bytes.
+ */
+
+#define BLOCK_BYTES 64
+
+
+/*!
+ * \brief           Number of 64-bit words in a filter block.
+ */
+
+#define BLOCK_WORDS (BLOCK_BYTES / sizeof(uint64_t))
+
+
+/*!
+ * \brief           Struct for a filter block.
+ */
+
+typedef struct bloom_block_t {
+    uint64_t words[BLOCK_WORDS];        /*!< Bits of the block */
+} bloom_block_t;
+
+
+/*!
+ * \brief           Struct to contain a filter.
+ */
+
+typedef struct bloom_filter_t {
+    bloom_block_t * blocks;     /*!< Pointer to aligned blocks */
+    void * memory;              /*!< Pointer to allocated memory */
+    size_t num_blocks;          /*!< Number of blocks */
+    size_t capacity;            /*!< Number of keys the filter is sized for */
+    unsigned int num_probes;    /*!< Number of bits set per key */
+} bloom_filter_t;
+
+
+/*!
+ * \brief           Returns the block for a hash.
+ * \details         Maps the high 32 bits of the hash onto the range of
+ * blocks with a multiply and shift, avoiding a division.
+ * \param filter    A pointer to the filter.
+ * \param hash      The hash.
+ * \returns         A pointer to the block.
+ */
+
+static bloom_block_t * block_for_hash(const bloom_filter filter,
+                                      const uint64_t hash) {
+    const uint64_t blocks = filter->num_blocks;
+    return &filter->blocks[((hash >> 32) * blocks) >> 32];
+}
+
+
+/*!
+ * \brief           Initializes a new filter.
+ * \param capacity  The number of keys the filter is expected to hold.
+ * More keys may be added, at the cost of a higher false positive rate.
+ * \param bits_per_key  The number of bits of filter per key. 10 bits per
+ * key gives a false positive rate of around 1%.
+ * \returns         A pointer to the new filter.
+ */
+
+bloom_filter bloom_filter_init(const size_t capacity,
+                               const size_t bits_per_key) {
+    const size_t bits = (capacity ? capacity : 1) *
+                        (bits_per_key ? bits_per_key : 1);
+    bloom_filter new_filter = term_malloc(sizeof(*new_filter));
+
+    new_filter->num_blocks = (bits + BLOCK_BYTES * 8 - 1) / (BLOCK_BYTES * 8);
+    new_filter->capacity = capacity;
+
+    /*  The optimal number of probes is ln(2) bits per key  */
+
+    new_filter->num_probes = (unsigned int) ((bits_per_key * 69 + 50) / 100);
+    if ( new_filter->num_probes < 1 ) {
+        new_filter->num_probes = 1;
+    } else if ( new_filter->num_probes > 16 ) {
+        new_filter->num_probes = 16;
+    }
+
+    /*  Over-allocate so the blocks can be aligned to a cache line  */
+
+    new_filter->memory = term_malloc(new_filter->num_blocks * BLOCK_BYTES +
+                                     BLOCK_BYTES - 1);
+    const uintptr_t addr = (uintptr_t) new_filter->memory;
+    new_filter->blocks = (bloom_block_t *) ((addr + BLOCK_BYTES - 1) &
+                                            ~((uintptr_t) BLOCK_BYTES - 1));
+    bloom_filter_clear(new_filter);
+
+    return new_filter;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a filter.
+ * \param filter    A pointer to the filter to free.
+ */
+
+void bloom_filter_free(bloom_filter filter) {
+    free(filter->memory);
+    free(filter);
+}
+
+
+/*!
+ * \brief           Returns the number of keys a filter was sized for.
+ * \param filter    A pointer to the filter.
+ * \returns         The capacity of the filter.
+ */
+
+size_t bloom_filter_capacity(const bloom_filter filter) {
+    return filter->capacity;
+}
+
+
+/*!
+ * \brief           Removes all keys from a filter.
+ * \param filter    A pointer to the filter.
+ */
+
+void bloom_filter_clear(bloom_filter filter) {
+    memset(filter->blocks, 0, filter->num_blocks * BLOCK_BYTES);
+}
+
+
+/*!
+ * \brief           Adds a key to a filter.
+ * \param filter    A pointer to the filter.
+ * \param hash      The hash of the key.
+ */
+
+void bloom_filter_add(bloom_filter filter, const uint64_t hash) {
+    bloom_block_t * block = block_for_hash(filter, hash);
+    uint32_t probe = (uint32_t) hash;
+    const uint32_t delta = (probe >> 17) | (probe << 15) | 1;
+
+    for ( unsigned int i = 0; i < filter->num_probes; ++i ) {
+        const unsigned int bit = probe % (BLOCK_BYTES * 8);
+        block->words[bit / 64] |= (uint64_t) 1 << (bit % 64);
+        probe += delta;
+    }
+}
+
+
+/*!
+ * \brief           Queries a filter for a key.
+ * \param filter    A pointer to the filter.
+ * \param hash      The hash of the key.
+ * \returns         `false` if the key is definitely not in the filter,
+ * `true` if it may be.
+ */
+
+bool bloom_filter_query(const bloom_filter filter, const uint64_t hash) {
+    const bloom_block_t * block = block_for_hash(filter, hash);
+    uint32_t probe = (uint32_t) hash;
+    const uint32_t delta = (probe >> 17) | (probe << 15) | 1;
+
+    for ( unsigned int i = 0; i < filter->num_probes; ++i ) {
+        const unsigned int bit = probe % (BLOCK_BYTES * 8);
+        if ( !(block->words[bit / 64] & ((uint64_t) 1 << (bit % 64))) ) {
+            return false;
+        }
+        probe += delta;
+    }
+
+    return true;
+}
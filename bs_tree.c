@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include <paulgrif/chelpers.h>
 #include "cds_common.h"
+#include "cds_bloom_filter.h"
 #include "bs_tree.h"
 
 
@@ -20,6 +21,58 @@
 #endif
 
 
+/*!
+ * \brief           Number of membership filter bits per element.
+ */
+
+#define FILTER_BITS_PER_KEY 10
+
+
+/*!
+ * \brief           Free function for intrusive trees given none.
+ * \param data      A pointer to the container, which is left alone.
+ */
+
+static void free_nothing(void * data) {
+    (void) data;
+}
+
+
+/*!
+ * \brief           Creates a node for data to be inserted in a tree.
+ * \details         Intrusive trees take caller-provided nodes only, so
+ * inserting data into one is a fatal error.
+ * \param tree      A pointer to the tree.
+ * \param data      The data for the new node.
+ * \returns         A pointer to the newly created node.
+ */
+
+static bs_tree_node data_node(bs_tree tree, void * data) {
+    if ( tree->intrusive ) {
+        fputs("cdatastruct error: data inserted into intrusive tree",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    return bs_tree_new_node(data);
+}
+
+
+/*!
+ * \brief           Releases a node that has been removed from a tree.
+ * \details         Nodes of an intrusive tree belong to their containers,
+ * so are left alone.
+ * \param tree      A pointer to the tree.
+ * \param node      A pointer to the node.
+ */
+
+static void release_node(bs_tree tree, bs_tree_node node) {
+    if ( !tree->intrusive ) {
+        free(node);
+    }
+}
+
+
 /*!
  * \brief           Initializes a new binary search tree.
  * \param cfunc     A pointer to a compare function. The function should
@@ -42,6 +95,12 @@ bs_tree bs_tree_init(int (*cfunc)(const void *, const void *),
     new_tree->root = NULL;
     new_tree->length = 0;
     new_tree->cfunc = cfunc;
+    new_tree->filter = NULL;
+    new_tree->hfunc = NULL;
+    new_tree->wal = NULL;
+    new_tree->intern = NULL;
+    new_tree->intrusive = false;
+    new_tree->offset = 0;
     if ( free_func ) {
         new_tree->free_func = free_func;
     } else {
@@ -60,6 +119,35 @@ bs_tree bs_tree_init(int (*cfunc)(const void *, const void *),
 }
 
 
+/*!
+ * \brief           Initializes a new intrusive binary search tree.
+ * \details         An intrusive tree links nodes embedded in the elements
+ * themselves, so inserting an element allocates nothing. Elements are
+ * inserted with bs_tree_insert_node(), and the data of each node, as
+ * passed to the compare, free and traversal functions and returned by
+ * bs_tree_search_data(), is the element containing it. Use
+ * `cds_container_of()` to get from a node to its element.
+ * \param cfunc     A pointer to a compare function, as for bs_tree_init().
+ * \param free_func A pointer to a function for freeing an element when
+ * it is deleted from the tree. If `NULL` is specified, elements are left
+ * alone, which suits elements the caller frees, or that are not
+ * dynamically allocated.
+ * \param offset    The offset of the node within each element, as given
+ * by `offsetof()`.
+ * \returns         A pointer to the new tree.
+ */
+
+bs_tree bs_tree_init_intrusive(int (*cfunc)(const void *, const void *),
+                               void (*free_func)(void *),
+                               const size_t offset) {
+    bs_tree new_tree = bs_tree_init(cfunc,
+                                    free_func ? free_func : free_nothing);
+    new_tree->intrusive = true;
+    new_tree->offset = offset;
+    return new_tree;
+}
+
+
 /*!
  * \brief           Frees the resources associated with a tree.
  * \param tree      A pointer to the tree to free.
@@ -67,6 +155,7 @@ bs_tree bs_tree_init(int (*cfunc)(const void *, const void *),
 
 void bs_tree_free(bs_tree tree) {
     bs_tree_free_subtree(tree, tree->root);
+    bs_tree_detach_filter(tree);
 
 #ifdef CDS_THREAD_SUPPORT
     int status = pthread_mutex_destroy(&tree->mutex);
@@ -151,6 +240,77 @@ bool bs_tree_insert(bs_tree tree, void * data) {
 }
 
 
+/*!
+ * \brief           Inserts a node into an intrusive tree.
+ * \details         A node comparing equal to the new one is replaced by
+ * it, as for bs_tree_insert(), but is returned rather than freed, since
+ * its element belongs to the caller.
+ * \param tree      A pointer to the tree.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a tree.
+ * \returns         A pointer to the node replaced, which is no longer in
+ * the tree, or `NULL` if there was none.
+ */
+
+bs_tree_node_t * bs_tree_insert_node(bs_tree tree, bs_tree_node_t * node) {
+    if ( !tree->intrusive ) {
+        fputs("cdatastruct error: node inserted into non-intrusive tree",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    node->data = (char *) node - tree->offset;
+    node->left = NULL;
+    node->right = NULL;
+
+    bs_tree_node * p_node = &tree->root;
+    while ( *p_node ) {
+        int compare = tree->cfunc(node->data, (*p_node)->data);
+        if ( !compare ) {
+            bs_tree_node old_node = *p_node;
+            node->left = old_node->left;
+            node->right = old_node->right;
+            old_node->left = NULL;
+            old_node->right = NULL;
+            *p_node = node;
+            return old_node;
+        } else if ( compare < 0 ) {
+            p_node = &(*p_node)->left;
+        } else {
+            p_node = &(*p_node)->right;
+        }
+    }
+
+    *p_node = node;
+    ++tree->length;
+    bs_tree_filter_add(tree, node->data);
+    return NULL;
+}
+
+
+/*!
+ * \brief           Deletes data from a tree.
+ * \details         Any memory consumed by the deleted data is freed
+ * with the tree's free function.
+ * \param tree      A pointer to the tree.
+ * \param data      The data to delete.
+ * \returns         `true` if the data was found and deleted, `false`
+ * if it was not present.
+ */
+
+bool bs_tree_delete(bs_tree tree, const void * data) {
+    bs_tree_node rm_node = bs_tree_remove(tree, data);
+
+    if ( rm_node == NULL ) {
+        return false;
+    }
+
+    tree->free_func(rm_node->data);
+    release_node(tree, rm_node);
+    return true;
+}
+
+
 /*!
  * \brief           Performs a preorder left-to-right traversal of a bs_tree.
  * \param tree      A pointer to the tree.
@@ -241,6 +401,100 @@ void bs_tree_postorder_right_traverse(bs_tree tree,
 }
 
 
+/*!
+ * \brief           Adds an element to a tree's filter during a traversal.
+ * \param data      A pointer to the element.
+ * \param arg       A pointer to the tree.
+ */
+
+static void filter_add_data(void * data, void * arg) {
+    bs_tree_filter_add(arg, data);
+}
+
+
+/*!
+ * \brief           Attaches a membership filter to a tree.
+ * \details         Searches for elements which are not in the tree are
+ * then usually rejected by the filter, in a single cache line access,
+ * without descending the tree. The filter is updated as elements are
+ * inserted and grows automatically, but elements are not removed from it
+ * when deleted, so after many deletions bs_tree_rebuild_filter() should
+ * be called to restore its effectiveness. Any existing filter is replaced,
+ * and the filter statistics are reset.
+ * \param tree      A pointer to the tree.
+ * \param hfunc     A pointer to a hash function. The function should
+ * return a well mixed `uint64_t` hash of its `void *` parameter, and
+ * must return equal hashes for elements which compare equal.
+ * \param capacity  The number of elements the filter should initially
+ * be sized for. The filter is never sized for fewer elements than the
+ * tree currently contains.
+ */
+
+void bs_tree_attach_filter(bs_tree tree,
+        uint64_t (*hfunc)(const void *), const size_t capacity) {
+    bs_tree_detach_filter(tree);
+
+    tree->hfunc = hfunc;
+    tree->filter = bloom_filter_init(capacity > tree->length ?
+                                     capacity : tree->length,
+                                     FILTER_BITS_PER_KEY);
+    tree->fstats.queries = 0;
+    tree->fstats.rejected = 0;
+    tree->fstats.hits = 0;
+    tree->fstats.false_positives = 0;
+
+    bs_tree_inorder_left_traverse_int(tree, tree->root,
+                                      filter_add_data, tree);
+}
+
+
+/*!
+ * \brief           Detaches and frees a tree's membership filter, if any.
+ * \param tree      A pointer to the tree.
+ */
+
+void bs_tree_detach_filter(bs_tree tree) {
+    if ( tree->filter ) {
+        bloom_filter_free(tree->filter);
+        tree->filter = NULL;
+        tree->hfunc = NULL;
+    }
+}
+
+
+/*!
+ * \brief           Rebuilds a tree's membership filter from its elements.
+ * \details         This clears deleted elements from the filter. The
+ * filter statistics are retained. Nothing is done if the tree has no
+ * filter.
+ * \param tree      A pointer to the tree.
+ */
+
+void bs_tree_rebuild_filter(bs_tree tree) {
+    if ( tree->filter ) {
+        const size_t capacity = bloom_filter_capacity(tree->filter);
+        bloom_filter_free(tree->filter);
+        tree->filter = bloom_filter_init(capacity > tree->length ?
+                                         capacity : tree->length,
+                                         FILTER_BITS_PER_KEY);
+        bs_tree_inorder_left_traverse_int(tree, tree->root,
+                                          filter_add_data, tree);
+    }
+}
+
+
+/*!
+ * \brief           Gets the statistics for a tree's membership filter.
+ * \param tree      A pointer to the tree.
+ * \param stats     A pointer to a struct to populate with the statistics.
+ */
+
+void bs_tree_filter_stats(const bs_tree tree,
+                          bs_tree_filter_stats_t * stats) {
+    *stats = tree->fstats;
+}
+
+
 /*!
  * \brief           Locks a tree's mutex.
  * \param tree      A pointer to the tree.
@@ -294,17 +548,21 @@ bs_tree_node bs_tree_new_node(void * data) {
 
 /*!
  * \brief           Frees the resources associated with a subtree.
- * \details         This function frees the node recursively.
+ * \details         This function frees the node recursively. The
+ * children are fetched first, since freeing the data of an intrusive
+ * tree may free the node with it.
  * \param tree      A pointer to the tree.
  * \param node      A pointer to the tree node at the root of the subtree.
  */
 
 void bs_tree_free_subtree(bs_tree tree, bs_tree_node node) {
     if ( node ) {
+        bs_tree_node left = node->left;
+        bs_tree_node right = node->right;
         tree->free_func(node->data);
-        bs_tree_free_subtree(tree, node->left);
-        bs_tree_free_subtree(tree, node->right);
-        free(node);
+        release_node(tree, node);
+        bs_tree_free_subtree(tree, left);
+        bs_tree_free_subtree(tree, right);
     }
 }
 
@@ -322,6 +580,14 @@ bs_tree_node bs_tree_search_node(const bs_tree tree, const void * data) {
     bool found = false;
     int compare;
 
+    if ( tree->filter ) {
+        ++tree->fstats.queries;
+        if ( !bloom_filter_query(tree->filter, tree->hfunc(data)) ) {
+            ++tree->fstats.rejected;
+            return NULL;
+        }
+    }
+
     while ( !found && searchnode ) {
         compare = tree->cfunc(data, searchnode->data);
         if ( !compare ) {
@@ -333,6 +599,14 @@ bs_tree_node bs_tree_search_node(const bs_tree tree, const void * data) {
         }
     }
 
+    if ( tree->filter ) {
+        if ( found ) {
+            ++tree->fstats.hits;
+        } else {
+            ++tree->fstats.false_positives;
+        }
+    }
+
     return searchnode;
 }
 
@@ -359,7 +633,7 @@ bool bs_tree_insert_subtree(bs_tree tree, bs_tree_node * p_node, void * data) {
         bs_tree_node node = bs_tree_insert_search(tree, data, &duplicate);
 
         if ( !duplicate ) {
-            bs_tree_node new_node = bs_tree_new_node(data);
+            bs_tree_node new_node = data_node(tree, data);
             int compare = tree->cfunc(data, node->data);
             if ( compare < 0 ) {
                 node->left = new_node;
@@ -367,6 +641,7 @@ bool bs_tree_insert_subtree(bs_tree tree, bs_tree_node * p_node, void * data) {
                 node->right = new_node;
             }
             ++tree->length;
+            bs_tree_filter_add(tree, data);
         } else {
             tree->free_func(node->data);
             node->data = data;
@@ -375,15 +650,42 @@ bool bs_tree_insert_subtree(bs_tree tree, bs_tree_node * p_node, void * data) {
         
         /*  Tree is empty  */
 
-        bs_tree_node new_node = bs_tree_new_node(data);
+        bs_tree_node new_node = data_node(tree, data);
         *p_node = new_node;
         ++tree->length;
+        bs_tree_filter_add(tree, data);
     }
 
     return duplicate;
 }
 
 
+/*!
+ * \brief           Adds a newly inserted element to a tree's filter.
+ * \details         If the tree has grown to twice the number of elements
+ * the filter was sized for, the filter is rebuilt at double the size, so
+ * its false positive rate stays bounded at an amortized O(1) cost per
+ * insertion. Nothing is done if the tree has no filter.
+ * \param tree      A pointer to the tree.
+ * \param data      A pointer to the new element.
+ */
+
+void bs_tree_filter_add(bs_tree tree, const void * data) {
+    if ( tree->filter ) {
+        const size_t capacity = bloom_filter_capacity(tree->filter);
+        if ( tree->length > capacity * 2 ) {
+            bloom_filter_free(tree->filter);
+            tree->filter = bloom_filter_init(tree->length * 2,
+                                             FILTER_BITS_PER_KEY);
+            bs_tree_inorder_left_traverse_int(tree, tree->root,
+                                              filter_add_data, tree);
+        } else {
+            bloom_filter_add(tree->filter, tree->hfunc(data));
+        }
+    }
+}
+
+
 /*!
  * \brief       Searches a tree for insertion purposes.
  * \details     The function searches the tree for a piece of data,
@@ -429,6 +731,195 @@ bs_tree_node bs_tree_insert_search(bs_tree tree, void * data, bool * found) {
 }
 
 
+/*!
+ * \brief           Builds a balanced subtree from sorted elements.
+ * \param data      A pointer to the elements, in order.
+ * \param n         The number of elements.
+ * \returns         A pointer to the root of the new subtree.
+ */
+
+static bs_tree_node build_sorted_subtree(void ** data, const size_t n) {
+    if ( n == 0 ) {
+        return NULL;
+    }
+
+    const size_t mid = n / 2;
+    bs_tree_node node = bs_tree_new_node(data[mid]);
+    node->left = build_sorted_subtree(data, mid);
+    node->right = build_sorted_subtree(data + mid + 1, n - mid - 1);
+    return node;
+}
+
+
+/*!
+ * \brief           Builds a tree from sorted elements.
+ * \details         The tree is built perfectly balanced in O(n) time,
+ * without any comparisons, rather than by inserting each element in turn,
+ * which for sorted input would build a degenerate tree in O(n^2) time.
+ * \param tree      A pointer to the tree, which must be empty, and which
+ * must not be intrusive, since nodes are allocated for the elements.
+ * \param data      A pointer to the elements, in strictly increasing
+ * order. The tree takes ownership of the elements, but not the array.
+ * \param n         The number of elements.
+ */
+
+void bs_tree_build_sorted(bs_tree tree, void ** data, const size_t n) {
+    if ( tree->intrusive ) {
+        fputs("cdatastruct error: data inserted into intrusive tree",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    if ( tree->root ) {
+        fputs("cdatastruct error: building into non-empty tree.", stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    tree->root = build_sorted_subtree(data, n);
+    tree->length = n;
+
+    if ( tree->filter ) {
+        bs_tree_rebuild_filter(tree);
+    }
+}
+
+
+/*!
+ * \brief           Links sorted nodes into a balanced subtree.
+ * \param nodes     A pointer to the nodes, in order.
+ * \param n         The number of nodes.
+ * \returns         A pointer to the root of the subtree.
+ */
+
+static bs_tree_node link_sorted_subtree(bs_tree_node * nodes,
+                                        const size_t n) {
+    if ( n == 0 ) {
+        return NULL;
+    }
+
+    const size_t mid = n / 2;
+    bs_tree_node node = nodes[mid];
+    node->left = link_sorted_subtree(nodes, mid);
+    node->right = link_sorted_subtree(nodes + mid + 1, n - mid - 1);
+    return node;
+}
+
+
+/*!
+ * \brief           Relinks a tree from sorted nodes.
+ * \details         The tree's existing structure is discarded and the
+ * nodes linked perfectly balanced in O(n) time, without allocating or
+ * comparing.
+ * \param tree      A pointer to the tree.
+ * \param nodes     A pointer to the nodes, in strictly increasing order,
+ * which must include every node currently in the tree. The tree takes
+ * ownership of the nodes, but not the array.
+ * \param n         The number of nodes.
+ */
+
+void bs_tree_relink_sorted(bs_tree tree, bs_tree_node * nodes,
+                           const size_t n) {
+    tree->root = link_sorted_subtree(nodes, n);
+    tree->length = n;
+
+    if ( tree->filter ) {
+        bs_tree_rebuild_filter(tree);
+    }
+}
+
+
+/*!
+ * \brief           Gets the nodes of a subtree in order.
+ * \param node      A pointer to the root of the subtree.
+ * \param nodes     A pointer to the array to populate.
+ * \returns         The number of nodes populated.
+ */
+
+static size_t collect_subtree(bs_tree_node node, bs_tree_node * nodes) {
+    size_t count = 0;
+
+    while ( node ) {
+        count += collect_subtree(node->left, nodes + count);
+        nodes[count++] = node;
+        node = node->right;
+    }
+
+    return count;
+}
+
+
+/*!
+ * \brief           Gets the nodes of a tree in order.
+ * \param tree      A pointer to the tree.
+ * \param nodes     A pointer to an array of at least the tree's length
+ * to populate with the nodes.
+ */
+
+void bs_tree_collect_nodes(const bs_tree tree, bs_tree_node * nodes) {
+    collect_subtree(tree->root, nodes);
+}
+
+
+/*!
+ * \brief           Removes, but does not delete, the node containing
+ * a piece of data.
+ * \details         A node with two children is replaced by its inorder
+ * successor, which is relinked rather than having its data copied, so
+ * that pointers to other nodes remain valid.
+ * \param tree      A pointer to the tree.
+ * \param data      A pointer to the data for which to search.
+ * \returns         A pointer to the removed node, or `NULL` if the data
+ * was not found. The node should be `free()`d by the caller, along with
+ * its data, if necessary.
+ */
+
+bs_tree_node bs_tree_remove(bs_tree tree, const void * data) {
+    bs_tree_node * p_node = &tree->root;
+
+    while ( *p_node ) {
+        int compare = tree->cfunc(data, (*p_node)->data);
+        if ( !compare ) {
+            break;
+        } else if ( compare < 0 ) {
+            p_node = &(*p_node)->left;
+        } else {
+            p_node = &(*p_node)->right;
+        }
+    }
+
+    bs_tree_node rm_node = *p_node;
+    if ( rm_node == NULL ) {
+        return NULL;
+    }
+
+    if ( rm_node->left == NULL ) {
+        *p_node = rm_node->right;
+    } else if ( rm_node->right == NULL ) {
+        *p_node = rm_node->left;
+    } else {
+
+        /*  Splice out inorder successor and put it in place of node  */
+
+        bs_tree_node * p_succ = &rm_node->right;
+        while ( (*p_succ)->left ) {
+            p_succ = &(*p_succ)->left;
+        }
+
+        bs_tree_node succ = *p_succ;
+        *p_succ = succ->right;
+        succ->left = rm_node->left;
+        succ->right = rm_node->right;
+        *p_node = succ;
+    }
+
+    rm_node->left = NULL;
+    rm_node->right = NULL;
+    --tree->length;
+
+    return rm_node;
+}
+
+
 /*!
  * \brief           Performs a preorder left-to-right traversal of a bs_tree.
  * \details         This function is called internally by the matching
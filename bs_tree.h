@@ -11,6 +11,7 @@
 #define PG_CDS_BINARY_SEARCH_TREE_DEV_H
 
 #include <stddef.h>
+#include <stdbool.h>
 #include "cds_bs_tree.h"
 
 
@@ -37,6 +38,13 @@ typedef struct bs_tree_t {
     size_t length;                      /*!< Length of list */
     int (*cfunc)();                     /*!< Pointer to compare function */
     void (*free_func)();                /*!< Pointer to node free function */
+    struct bloom_filter_t * filter;     /*!< Pointer to membership filter */
+    uint64_t (*hfunc)();                /*!< Pointer to filter hash function */
+    bs_tree_filter_stats_t fstats;      /*!< Membership filter statistics */
+    struct bst_wal_t * wal;             /*!< Pointer to write-ahead log */
+    struct intern_table_t * intern;     /*!< Pointer to key interning table */
+    bool intrusive;                     /*!< Nodes embedded in elements */
+    size_t offset;                      /*!< Offset of node in element */
 } sl_list_t;
 
 
@@ -58,6 +66,12 @@ void bs_tree_free_subtree(bs_tree tree, bs_tree_node node);
 bs_tree_node bs_tree_search_node(const bs_tree tree, const void * key);
 bool bs_tree_insert_subtree(bs_tree tree, bs_tree_node * p_node, void * data);
 bs_tree_node bs_tree_insert_search(bs_tree tree, void * key, bool * found);
+bs_tree_node bs_tree_remove(bs_tree tree, const void * data);
+void bs_tree_build_sorted(bs_tree tree, void ** data, const size_t n);
+void bs_tree_relink_sorted(bs_tree tree, bs_tree_node * nodes,
+                           const size_t n);
+void bs_tree_collect_nodes(const bs_tree tree, bs_tree_node * nodes);
+void bs_tree_filter_add(bs_tree tree, const void * data);
 
 void bs_tree_preorder_left_traverse_int(bs_tree tree, bs_tree_node node,
         void (*dfunc)(void *, void *), void * arg);
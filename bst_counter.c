@@ -0,0 +1,359 @@
+/*!
+ * \file            bst_counter.c
+ * \brief           Implementation of binary search tree counter map data
+ * structure.
+ * \details         Each distinct key is held in a single allocation along
+ * with its count, so counting a new key costs one allocation, and counting
+ * an existing key costs one descent of the tree and no allocation.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_bst_counter.h"
+#include "bs_tree.h"
+
+
+/*!
+ * \brief           Counter entry struct.
+ */
+
+typedef struct counter_entry_t {
+    uint64_t count;             /*!< Count for key */
+    char key[];                 /*!< Key string */
+} counter_entry_t;
+
+
+/*!
+ * \brief           Typedef for counter entry pointer.
+ */
+
+typedef struct counter_entry_t * counter_entry;
+
+
+/*!
+ * \brief           Struct for passing traversal state to a callback.
+ */
+
+typedef struct counter_traverse_t {
+    void (*cfunc)(const char *, uint64_t, void *);  /*!< User callback */
+    void * arg;                 /*!< Argument for user callback */
+} counter_traverse_t;
+
+
+/*!
+ * \brief           Struct for selecting the top entries.
+ * \details         The selected entries are held in a binary min-heap,
+ * so the least of them is at the root, ready to be displaced.
+ */
+
+typedef struct counter_top_t {
+    counter_entry * heap;       /*!< Heap of selected entries */
+    size_t size;                /*!< Number of entries in heap */
+    size_t k;                   /*!< Number of entries to select */
+} counter_top_t;
+
+
+/*!
+ * \brief           Compare the keys of two counter entries.
+ * \param data      `void` pointer to entry to be compared.
+ * \param cmp       `void` pointer to comparison entry.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * of data is less than, equal to or greater than the key of cmp.
+ */
+
+static int compare_entry(const void * data, const void * cmp) {
+    return strcmp(((const counter_entry_t *) data)->key,
+                  ((const counter_entry_t *) cmp)->key);
+}
+
+
+/*!
+ * \brief           Checks if one entry ranks below another.
+ * \details         Entries rank by descending count, and entries with
+ * equal counts by ascending key.
+ * \param a         A pointer to the first entry.
+ * \param b         A pointer to the second entry.
+ * \returns         `true` if `a` ranks below `b`, `false` otherwise.
+ */
+
+static bool ranks_below(const counter_entry_t * a, const counter_entry_t * b) {
+    if ( a->count != b->count ) {
+        return a->count < b->count;
+    }
+    return strcmp(a->key, b->key) > 0;
+}
+
+
+/*!
+ * \brief           Restores the heap property below a heap position.
+ * \param top       A pointer to the selection state.
+ * \param i         The position.
+ */
+
+static void heap_sift_down(counter_top_t * top, size_t i) {
+    while ( true ) {
+        size_t least = i;
+        const size_t left = 2 * i + 1;
+        const size_t right = left + 1;
+
+        if ( left < top->size &&
+             ranks_below(top->heap[left], top->heap[least]) ) {
+            least = left;
+        }
+        if ( right < top->size &&
+             ranks_below(top->heap[right], top->heap[least]) ) {
+            least = right;
+        }
+        if ( least == i ) {
+            break;
+        }
+
+        counter_entry temp = top->heap[i];
+        top->heap[i] = top->heap[least];
+        top->heap[least] = temp;
+        i = least;
+    }
+}
+
+
+/*!
+ * \brief           Offers an entry for selection during a traversal.
+ * \param data      A pointer to the entry.
+ * \param arg       A pointer to the selection state.
+ */
+
+static void top_offer(void * data, void * arg) {
+    counter_top_t * top = arg;
+    counter_entry entry = data;
+
+    if ( top->size < top->k ) {
+
+        /*  Heap not yet full, so sift new entry up  */
+
+        size_t i = top->size++;
+        while ( i > 0 && ranks_below(entry, top->heap[(i - 1) / 2]) ) {
+            top->heap[i] = top->heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        top->heap[i] = entry;
+    } else if ( ranks_below(top->heap[0], entry) ) {
+        top->heap[0] = entry;
+        heap_sift_down(top, 0);
+    }
+}
+
+
+/*!
+ * \brief           Passes an entry to a user callback during a traversal.
+ * \param data      A pointer to the entry.
+ * \param arg       A pointer to the traversal state.
+ */
+
+static void traverse_entry(void * data, void * arg) {
+    const counter_traverse_t * state = arg;
+    counter_entry entry = data;
+    state->cfunc(entry->key, entry->count, state->arg);
+}
+
+
+/*!
+ * \brief           Initializes a new counter map.
+ * \returns         A pointer to the new counter map.
+ */
+
+bst_counter bst_counter_init(void) {
+    return bs_tree_init(compare_entry, NULL);
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a counter map.
+ * \param counter   A pointer to the counter map to free.
+ */
+
+void bst_counter_free(bst_counter counter) {
+    bs_tree_free(counter);
+}
+
+
+/*!
+ * \brief           Returns the number of keys in a counter map.
+ * \param counter   A pointer to the counter map.
+ * \returns         The number of keys in the counter map.
+ */
+
+size_t bst_counter_length(const bst_counter counter) {
+    return bs_tree_length(counter);
+}
+
+
+/*!
+ * \brief           Checks if a counter map is empty.
+ * \param counter   A pointer to the counter map.
+ * \returns         `true` if the counter map is empty, otherwise `false`.
+ */
+
+bool bst_counter_isempty(const bst_counter counter) {
+    return bs_tree_isempty(counter);
+}
+
+
+/*!
+ * \brief           Adds to the count for a key.
+ * \details         The tree is descended once, and the count updated in
+ * place if the key is found, or a new entry linked in where the descent
+ * ended if it is not.
+ * \param counter   A pointer to the counter map.
+ * \param key       The key.
+ * \param delta     The amount to add to the count.
+ * \returns         The new count for the key.
+ */
+
+uint64_t bst_counter_increment(bst_counter counter, const char * key,
+                               const uint64_t delta) {
+    bs_tree_node * p_node = &counter->root;
+
+    while ( *p_node ) {
+        counter_entry entry = (*p_node)->data;
+        const int compare = strcmp(key, entry->key);
+
+        if ( compare == 0 ) {
+            entry->count += delta;
+            return entry->count;
+        } else if ( compare < 0 ) {
+            p_node = &(*p_node)->left;
+        } else {
+            p_node = &(*p_node)->right;
+        }
+    }
+
+    const size_t key_size = strlen(key) + 1;
+    counter_entry new_entry = term_malloc(sizeof(*new_entry) + key_size);
+    new_entry->count = delta;
+    memcpy(new_entry->key, key, key_size);
+
+    *p_node = bs_tree_new_node(new_entry);
+    ++counter->length;
+    bs_tree_filter_add(counter, new_entry);
+
+    return delta;
+}
+
+
+/*!
+ * \brief           Returns the count for a key.
+ * \param counter   A pointer to the counter map.
+ * \param key       The key.
+ * \returns         The count for the key, or zero if the key is not in
+ * the counter map.
+ */
+
+uint64_t bst_counter_get(const bst_counter counter, const char * key) {
+    bs_tree_node node = counter->root;
+
+    while ( node ) {
+        counter_entry entry = node->data;
+        const int compare = strcmp(key, entry->key);
+
+        if ( compare == 0 ) {
+            return entry->count;
+        } else if ( compare < 0 ) {
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief           Visits each key and count in a counter map in key order.
+ * \param counter   A pointer to the counter map.
+ * \param cfunc     A pointer to the function to invoke for each key. The
+ * function is passed the key, the count, and `arg`.
+ * \param arg       A pointer to the argument to pass to `cfunc()`.
+ */
+
+void bst_counter_traverse(bst_counter counter,
+        void (*cfunc)(const char *, uint64_t, void *), void * arg) {
+    counter_traverse_t state = {cfunc, arg};
+    bs_tree_inorder_left_traverse(counter, traverse_entry, &state);
+}
+
+
+/*!
+ * \brief           Gets the keys with the highest counts.
+ * \details         The counter map is traversed once, keeping the best
+ * entries seen so far in a min-heap of size `k`, taking O(n log k) time.
+ * Keys with equal counts are ranked in key order.
+ * \param counter   A pointer to the counter map.
+ * \param k         The maximum number of keys to get.
+ * \param keys      An array of at least `k` elements to populate with
+ * the keys, in descending order of count. The keys remain owned by the
+ * counter map.
+ * \param counts    An array of at least `k` elements to populate with
+ * the counts. This parameter is ignored if set to NULL.
+ * \returns         The number of keys populated, which is the lesser of
+ * `k` and the number of keys in the counter map.
+ */
+
+size_t bst_counter_top(const bst_counter counter, const size_t k,
+                       const char ** keys, uint64_t * counts) {
+    if ( k == 0 ) {
+        return 0;
+    }
+
+    counter_top_t top;
+    top.k = k < counter->length ? k : counter->length;
+    top.size = 0;
+    top.heap = term_malloc(sizeof(*top.heap) * (top.k ? top.k : 1));
+
+    bs_tree_inorder_left_traverse(counter, top_offer, &top);
+
+    /*  Pop the least selected entry into each position from the back  */
+
+    const size_t selected = top.size;
+    while ( top.size > 0 ) {
+        counter_entry entry = top.heap[0];
+        keys[top.size - 1] = entry->key;
+        if ( counts ) {
+            counts[top.size - 1] = entry->count;
+        }
+
+        top.heap[0] = top.heap[--top.size];
+        heap_sift_down(&top, 0);
+    }
+
+    free(top.heap);
+    return selected;
+}
+
+
+/*!
+ * \brief           Locks a counter map's mutex.
+ * \param counter   A pointer to the counter map.
+ */
+
+void bst_counter_lock(bst_counter counter) {
+    bs_tree_lock(counter);
+}
+
+
+/*!
+ * \brief           Unlocks a counter map's mutex.
+ * \param counter   A pointer to the counter map.
+ */
+
+void bst_counter_unlock(bst_counter counter) {
+    bs_tree_unlock(counter);
+}
@@ -0,0 +1,385 @@
+/*!
+ * \file            bst_kmap.c
+ * \brief           Implementation of binary search tree map data structure
+ * with integer or binary keys.
+ * \details         Integer keys are stored inline in the key-value pair and
+ * compared directly, and binary keys are stored inline after the pair and
+ * compared with `memcmp()`, so neither requires conversion to a string or
+ * a separate allocation for the key.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_bst_kmap.h"
+#include "bs_tree.h"
+
+
+/*!
+ * \brief           Integer key-value pair struct.
+ */
+
+typedef struct ikvpair_t {
+    int64_t key;                /*!< Integer key */
+    void * value;               /*!< Pointer to data */
+} ikvpair_t;
+
+
+/*!
+ * \brief           Typedef for integer kvpair pointer.
+ */
+
+typedef struct ikvpair_t * ikvpair;
+
+
+/*!
+ * \brief           Binary key-value pair struct.
+ */
+
+typedef struct bkvpair_t {
+    void * value;               /*!< Pointer to data */
+    size_t len;                 /*!< Length of key */
+    unsigned char key[];        /*!< Key bytes */
+} bkvpair_t;
+
+
+/*!
+ * \brief           Typedef for binary kvpair pointer.
+ */
+
+typedef struct bkvpair_t * bkvpair;
+
+
+/*!
+ * \brief           Frees resources used by an integer kvpair.
+ * \param pair      A pointer to the kvpair to free.
+ */
+
+static void free_ikvpair(void * pair) {
+    ikvpair rm_pair = pair;
+    free(rm_pair->value);
+    free(rm_pair);
+}
+
+
+/*!
+ * \brief           Frees resources used by a binary kvpair.
+ * \param pair      A pointer to the kvpair to free.
+ */
+
+static void free_bkvpair(void * pair) {
+    bkvpair rm_pair = pair;
+    free(rm_pair->value);
+    free(rm_pair);
+}
+
+
+/*!
+ * \brief           Compare the keys of two integer kvpairs.
+ * \param data      `void` pointer to kvpair to be compared.
+ * \param cmp       `void` pointer to comparison kvpair.
+ * \returns         -1 if the key of data is less than the key of cmp,
+ * 1 if the key of data is greater than the key of cmp, and 0 if the
+ * two keys are equal.
+ */
+
+static int compare_ikvpair(const void * data, const void * cmp) {
+    const int64_t key_data = ((const ikvpair_t *) data)->key;
+    const int64_t key_cmp = ((const ikvpair_t *) cmp)->key;
+    return (key_data > key_cmp) - (key_data < key_cmp);
+}
+
+
+/*!
+ * \brief           Compares a binary key to the key of a binary kvpair.
+ * \details         Keys are compared bytewise over their common length,
+ * and a key which is a prefix of a longer key compares less.
+ * \param key       A pointer to the key to be compared.
+ * \param len       The length of the key.
+ * \param pair      A pointer to the comparison kvpair.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * is less than, equal to or greater than the key of the pair.
+ */
+
+static int compare_bin_key(const void * key, const size_t len,
+                           const bkvpair_t * pair) {
+    const size_t common = (len < pair->len) ? len : pair->len;
+    int compare = memcmp(key, pair->key, common);
+
+    if ( compare == 0 ) {
+        compare = (len > pair->len) - (len < pair->len);
+    }
+
+    return compare;
+}
+
+
+/*!
+ * \brief           Compare the keys of two binary kvpairs.
+ * \param data      `void` pointer to kvpair to be compared.
+ * \param cmp       `void` pointer to comparison kvpair.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * of data is less than, equal to or greater than the key of cmp.
+ */
+
+static int compare_bkvpair(const void * data, const void * cmp) {
+    const bkvpair_t * pair_data = data;
+    return compare_bin_key(pair_data->key, pair_data->len, cmp);
+}
+
+
+/*!
+ * \brief           Aborts if a map does not hold the expected key type.
+ * \param map       A pointer to the map.
+ * \param cfunc     The compare function for the expected key type.
+ */
+
+static void check_keytype(const bst_kmap map,
+                          int (*cfunc)(const void *, const void *)) {
+    if ( map->cfunc != cfunc ) {
+        fputs("cdatastruct error: map key type mismatch.", stderr);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/*!
+ * \brief           Searches a map for an integer key.
+ * \details         The keys are compared directly rather than through
+ * the tree's compare function.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the node in which the key was found,
+ * or `NULL` if the key was not found.
+ */
+
+static bs_tree_node search_int_node(const bst_kmap map, const int64_t key) {
+    bs_tree_node node = map->root;
+
+    while ( node ) {
+        const int64_t node_key = ((ikvpair) node->data)->key;
+        if ( key < node_key ) {
+            node = node->left;
+        } else if ( key > node_key ) {
+            node = node->right;
+        } else {
+            break;
+        }
+    }
+
+    return node;
+}
+
+
+/*!
+ * \brief           Searches a map for a binary key.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \param len       The length of the key.
+ * \returns         A pointer to the node in which the key was found,
+ * or `NULL` if the key was not found.
+ */
+
+static bs_tree_node search_bin_node(const bst_kmap map, const void * key,
+                                    const size_t len) {
+    bs_tree_node node = map->root;
+
+    while ( node ) {
+        const int compare = compare_bin_key(key, len, node->data);
+        if ( compare < 0 ) {
+            node = node->left;
+        } else if ( compare > 0 ) {
+            node = node->right;
+        } else {
+            break;
+        }
+    }
+
+    return node;
+}
+
+
+/*!
+ * \brief           Initializes a new map.
+ * \param type      The type of keys the map will hold.
+ * \returns         A pointer to the new map.
+ */
+
+bst_kmap bst_kmap_init(const bst_kmap_keytype type) {
+    bst_kmap new_map;
+
+    if ( type == BST_KMAP_INTEGER ) {
+        new_map = bs_tree_init(compare_ikvpair, free_ikvpair);
+    } else {
+        new_map = bs_tree_init(compare_bkvpair, free_bkvpair);
+    }
+
+    return new_map;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a map.
+ * \param map       A pointer to the map to free.
+ */
+
+void bst_kmap_free(bst_kmap map) {
+    bs_tree_free(map);
+}
+
+
+/*!
+ * \brief           Returns the number of elements in a map.
+ * \param map       A pointer to the map.
+ * \returns         The number of elements in the map.
+ */
+
+size_t bst_kmap_length(const bst_kmap map) {
+    return bs_tree_length(map);
+}
+
+
+/*!
+ * \brief           Checks if a map is empty.
+ * \param map       A pointer to the map.
+ * \returns         `true` if the map is empty, otherwise `false`.
+ */
+
+bool bst_kmap_isempty(const bst_kmap map) {
+    return bs_tree_isempty(map);
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into an integer-keyed map.
+ * \details         The value is replaced if the key is already found
+ * in the map. Any memory consumed by the old value is automatically
+ * `free()`d.
+ * \param map       A pointer to the map.
+ * \param key       The key of the new value to insert.
+ * \param value     A pointer to the new value to insert.
+ * \returns         `true` if the key was already in the tree and the
+ * value has been replaced, `false` if the key was not present.
+ */
+
+bool bst_kmap_insert_int(bst_kmap map, const int64_t key, void * value) {
+    check_keytype(map, compare_ikvpair);
+
+    ikvpair new_pair = term_malloc(sizeof(*new_pair));
+    new_pair->key = key;
+    new_pair->value = value;
+    return bs_tree_insert_subtree(map, &map->root, new_pair);
+}
+
+
+/*!
+ * \brief           Determines if a key is in an integer-keyed map.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool bst_kmap_search_int(const bst_kmap map, const int64_t key) {
+    check_keytype(map, compare_ikvpair);
+    return search_int_node(map, key) ? true : false;
+}
+
+
+/*!
+ * \brief           Searches an integer-keyed map for a value matching
+ * a key and returns it.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * bst_kmap_search_int_data(const bst_kmap map, const int64_t key) {
+    check_keytype(map, compare_ikvpair);
+    bs_tree_node node = search_int_node(map, key);
+    return node ? ((ikvpair) node->data)->value : NULL;
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into a binary-keyed map.
+ * \details         The key is copied into the map and may contain any
+ * bytes, including embedded NULs. The value is replaced if the key is
+ * already found in the map. Any memory consumed by the old value is
+ * automatically `free()`d.
+ * \param map       A pointer to the map.
+ * \param key       A pointer to the key of the new value to insert.
+ * \param len       The length of the key.
+ * \param value     A pointer to the new value to insert.
+ * \returns         `true` if the key was already in the tree and the
+ * value has been replaced, `false` if the key was not present.
+ */
+
+bool bst_kmap_insert_bin(bst_kmap map, const void * key,
+                         const size_t len, void * value) {
+    check_keytype(map, compare_bkvpair);
+
+    bkvpair new_pair = term_malloc(sizeof(*new_pair) + len);
+    new_pair->value = value;
+    new_pair->len = len;
+    memcpy(new_pair->key, key, len);
+    return bs_tree_insert_subtree(map, &map->root, new_pair);
+}
+
+
+/*!
+ * \brief           Determines if a key is in a binary-keyed map.
+ * \param map       A pointer to the map.
+ * \param key       A pointer to the key for which to search.
+ * \param len       The length of the key.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool bst_kmap_search_bin(const bst_kmap map, const void * key,
+                         const size_t len) {
+    check_keytype(map, compare_bkvpair);
+    return search_bin_node(map, key, len) ? true : false;
+}
+
+
+/*!
+ * \brief           Searches a binary-keyed map for a value matching a
+ * key and returns it.
+ * \param map       A pointer to the map.
+ * \param key       A pointer to the key for which to search.
+ * \param len       The length of the key.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * bst_kmap_search_bin_data(const bst_kmap map, const void * key,
+                                const size_t len) {
+    check_keytype(map, compare_bkvpair);
+    bs_tree_node node = search_bin_node(map, key, len);
+    return node ? ((bkvpair) node->data)->value : NULL;
+}
+
+
+/*!
+ * \brief           Locks a map's mutex.
+ * \param map       A pointer to the map.
+ */
+
+void bst_kmap_lock(bst_kmap map) {
+    bs_tree_lock(map);
+}
+
+
+/*!
+ * \brief           Unlocks a map's mutex.
+ * \param map       A pointer to the map.
+ */
+
+void bst_kmap_unlock(bst_kmap map) {
+    bs_tree_unlock(map);
+}
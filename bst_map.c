@@ -12,8 +12,30 @@
 #include <stdbool.h>
 #include <paulgrif/chelpers.h>
 #include "cds_common.h"
+#include "cds_general.h"
 #include "cds_bst_map.h"
+#include "cds_intern.h"
+#include "bst_map.h"
 #include "bs_tree.h"
+#include "bst_wal.h"
+
+#ifdef CDS_THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+
+/*!
+ * \brief           Batch length below which halves are sorted serially.
+ */
+
+#define PARALLEL_SORT_MIN 8192
+
+
+/*!
+ * \brief           Depth to which batch sorting is split across threads.
+ */
+
+#define PARALLEL_SORT_DEPTH 2
 
 
 /*!
@@ -33,16 +55,55 @@ typedef struct kvpair_t {
 typedef struct kvpair_t * kvpair;
 
 
+/*!
+ * \brief           Map cursor struct.
+ * \details         Binary search tree nodes have no parent pointers, so
+ * the cursor keeps a stack of the nodes whose pairs are still to be
+ * visited, each on the path from the root to the next pair.
+ */
+
+typedef struct bst_map_cursor_t {
+    bs_tree_node * stack;       /*!< Stack of pending nodes */
+    size_t depth;               /*!< Number of nodes on stack */
+    size_t capacity;            /*!< Capacity of stack */
+    bool reverse;               /*!< `true` for descending key order */
+} bst_map_cursor_t;
+
+
+/*!
+ * \brief           Struct for a batch sorting job.
+ */
+
+typedef struct batch_sort_t {
+    size_t * order;             /*!< Batch positions to sort */
+    size_t * tmp;               /*!< Scratch space for merging */
+    size_t n;                   /*!< Number of positions */
+    const char ** keys;         /*!< Batch keys */
+    int depth;                  /*!< Remaining depth for threads */
+} batch_sort_t;
+
+
 /*!
  * \brief           Constructs a new kvpair.
+ * \param map       A pointer to the map, whose key interning table, if
+ * any, supplies the key.
  * \param key       The key for the new pair.
  * \param value     Pointer to the value for the new pair.
  * \returns         A pointer for the new pair.
  */
 
-static void * new_kvpair(const char * key, void * value) {
+static void * new_kvpair(const bst_map map, const char * key,
+                         void * value) {
     kvpair pair = term_malloc(sizeof(*pair));
-    pair->key = term_strdup(key);
+    if ( map->intern ) {
+
+        /*  Interned keys are owned by the table, so the cast is safe,
+            since free_interned_kvpair() never frees them.  */
+
+        pair->key = (char *) intern_string(map->intern, key);
+    } else {
+        pair->key = term_strdup(key);
+    }
     pair->value = value;
     return pair;
 }
@@ -61,6 +122,18 @@ static void free_kvpair(void * pair) {
 }
 
 
+/*!
+ * \brief           Frees resources used by a kvpair with an interned key.
+ * \param pair      A pointer to the kvpair to free.
+ */
+
+static void free_interned_kvpair(void * pair) {
+    kvpair rm_kvpair = pair;
+    free(rm_kvpair->value);
+    free(rm_kvpair);
+}
+
+
 /*!
  * \brief           Compare the keys of two kvpairs.
  * \param data      `void` pointer to kvpair to be compared.
@@ -77,6 +150,234 @@ static int compare_kvpair(const void * data, const void * cmp) {
 }
 
 
+/*!
+ * \brief           Compare the interned keys of two kvpairs.
+ * \details         Equal interned keys are the same pointer, so equality
+ * is found without comparing the strings. A search key need not be
+ * interned, and is compared as a string unless it is the same pointer.
+ * \param data      `void` pointer to kvpair to be compared.
+ * \param cmp       `void` pointer to comparison kvpair.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * of data is less than, equal to or greater than the key of cmp.
+ */
+
+static int compare_interned_kvpair(const void * data, const void * cmp) {
+    const kvpair pair_data = (const kvpair) data;
+    const kvpair pair_cmp = (const kvpair) cmp;
+
+    if ( pair_data->key == pair_cmp->key ) {
+        return 0;
+    }
+    return strcmp(pair_data->key, pair_cmp->key);
+}
+
+
+/*!
+ * \brief           Calculates the hash of the key of a kvpair.
+ * \param data      `void` pointer to the kvpair.
+ * \returns         The hash of the key.
+ */
+
+static uint64_t hash_kvpair(const void * data) {
+    return cds_filter_hash_string(((const kvpair_t *) data)->key);
+}
+
+
+/*!
+ * \brief           Visits, in key order, each pair in a subtree.
+ * \param node      A pointer to the node at the root of the subtree.
+ * \param kvfunc    A pointer to the function to invoke for each pair.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+static void traverse_int(bs_tree_node node,
+        void (*kvfunc)(const char *, void *, void *), void * arg) {
+    while ( node ) {
+        const kvpair pair = (kvpair) node->data;
+        traverse_int(node->left, kvfunc, arg);
+        kvfunc(pair->key, pair->value, arg);
+        node = node->right;
+    }
+}
+
+
+/*!
+ * \brief           Pushes a node and the nodes down its leading edge
+ * onto a cursor's stack.
+ * \details         For a forward cursor the leading edge is the chain of
+ * left children, and for a reverse cursor the chain of right children,
+ * so that the top of the stack is always the next pair to visit.
+ * \param cursor    A pointer to the cursor.
+ * \param node      A pointer to the node.
+ */
+
+static void cursor_push_edge(bst_map_cursor cursor, bs_tree_node node) {
+    while ( node ) {
+        if ( cursor->depth == cursor->capacity ) {
+            cursor->capacity = cursor->capacity ? cursor->capacity * 2 : 16;
+            cursor->stack = term_realloc(cursor->stack,
+                    sizeof(*cursor->stack) * cursor->capacity);
+        }
+
+        cursor->stack[cursor->depth++] = node;
+        node = cursor->reverse ? node->right : node->left;
+    }
+}
+
+
+/*!
+ * \brief           Creates a new cursor positioned before the first pair.
+ * \param map       A pointer to the map.
+ * \param reverse   `true` to visit pairs in descending key order.
+ * \returns         A pointer to the new cursor.
+ */
+
+static bst_map_cursor cursor_init(const bst_map map, const bool reverse) {
+    bst_map_cursor new_cursor = term_malloc(sizeof(*new_cursor));
+    new_cursor->stack = NULL;
+    new_cursor->depth = 0;
+    new_cursor->capacity = 0;
+    new_cursor->reverse = reverse;
+    cursor_push_edge(new_cursor, map->root);
+    return new_cursor;
+}
+
+
+/*!
+ * \brief           Visits, in key order, each pair in a subtree whose key
+ * begins with a prefix.
+ * \details         All keys beginning with the prefix form a contiguous
+ * range in key order, so subtrees lying wholly before or after that range
+ * are skipped without being visited.
+ * \param node      A pointer to the node at the root of the subtree.
+ * \param prefix    The prefix to match.
+ * \param len       The length of the prefix.
+ * \param kvfunc    A pointer to the function to invoke for each pair.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+static void prefix_traverse_int(bs_tree_node node, const char * prefix,
+        const size_t len, void (*kvfunc)(const char *, void *, void *),
+        void * arg) {
+    while ( node ) {
+        const kvpair pair = (kvpair) node->data;
+        const int compare = strncmp(pair->key, prefix, len);
+
+        if ( compare < 0 ) {
+            node = node->right;
+        } else if ( compare > 0 ) {
+            node = node->left;
+        } else {
+            prefix_traverse_int(node->left, prefix, len, kvfunc, arg);
+            kvfunc(pair->key, pair->value, arg);
+            node = node->right;
+        }
+    }
+}
+
+
+/*!
+ * \brief           Checks if one batch position sorts before another.
+ * \details         Positions sort by key, and positions with equal keys
+ * in batch order.
+ * \param keys      The batch keys.
+ * \param a         The first position.
+ * \param b         The second position.
+ * \returns         `true` if `a` sorts before `b`, `false` otherwise.
+ */
+
+static bool batch_before(const char ** keys, const size_t a,
+                         const size_t b) {
+    const int compare = strcmp(keys[a], keys[b]);
+    return compare < 0 || (compare == 0 && a < b);
+}
+
+
+static void sort_batch(batch_sort_t * job);
+
+
+#ifdef CDS_THREAD_SUPPORT
+
+/*!
+ * \brief           Runs a batch sorting job in a thread.
+ * \param arg       A pointer to the job.
+ * \returns         `NULL`.
+ */
+
+static void * sort_batch_thread(void * arg) {
+    sort_batch(arg);
+    return NULL;
+}
+
+#endif
+
+
+/*!
+ * \brief           Merge sorts batch positions by key.
+ * \details         With thread support, the first half of a large batch
+ * is sorted in a new thread while the second half is sorted in this one.
+ * \param job       A pointer to the job.
+ */
+
+static void sort_batch(batch_sort_t * job) {
+    size_t * order = job->order;
+    const size_t n = job->n;
+
+    if ( n <= 16 ) {
+        for ( size_t i = 1; i < n; ++i ) {
+            const size_t pos = order[i];
+            size_t j = i;
+            while ( j > 0 && batch_before(job->keys, pos, order[j - 1]) ) {
+                order[j] = order[j - 1];
+                --j;
+            }
+            order[j] = pos;
+        }
+        return;
+    }
+
+    const size_t half = n / 2;
+    batch_sort_t left = {order, job->tmp, half, job->keys, job->depth - 1};
+    batch_sort_t right = {order + half, job->tmp + half, n - half,
+                          job->keys, job->depth - 1};
+    bool threaded = false;
+
+#ifdef CDS_THREAD_SUPPORT
+    pthread_t thread;
+    if ( job->depth > 0 && n >= PARALLEL_SORT_MIN ) {
+        threaded = pthread_create(&thread, NULL,
+                                  sort_batch_thread, &left) == 0;
+    }
+#endif
+
+    if ( !threaded ) {
+        sort_batch(&left);
+    }
+    sort_batch(&right);
+
+#ifdef CDS_THREAD_SUPPORT
+    if ( threaded ) {
+        pthread_join(thread, NULL);
+    }
+#endif
+
+    size_t i = 0;
+    size_t j = half;
+    size_t k = 0;
+    while ( i < half && j < n ) {
+        if ( batch_before(job->keys, order[j], order[i]) ) {
+            job->tmp[k++] = order[j++];
+        } else {
+            job->tmp[k++] = order[i++];
+        }
+    }
+    while ( i < half ) {
+        job->tmp[k++] = order[i++];
+    }
+    memcpy(order, job->tmp, sizeof(*order) * k);
+}
+
+
 /*!
  * \brief           Initializes a new binary search tree map.
  * \returns         A pointer to the new map.
@@ -88,12 +389,37 @@ bst_map bst_map_init(void) {
 }
 
 
+/*!
+ * \brief           Initializes a new binary search tree map with interned
+ * keys.
+ * \details         Keys are stored as their canonical copies in an
+ * interning table, rather than copied for each map, so maps sharing a
+ * table share the memory for their keys, and equal keys compare equal
+ * by pointer. Only insertion uses the table, so searches and deletions
+ * take neither its lock nor the time to hash the key, and the canonical
+ * copy of a key, if passed, is found by pointer comparison alone.
+ * \param table     A pointer to the interning table, which must outlive
+ * the map.
+ * \returns         A pointer to the new map.
+ */
+
+bst_map bst_map_init_interned(intern_table table) {
+    bst_map new_map = bs_tree_init(compare_interned_kvpair,
+                                   free_interned_kvpair);
+    new_map->intern = table;
+    return new_map;
+}
+
+
 /*!
  * \brief           Frees the resources associated with a BST map.
  * \param map       A pointer to the map to free.
  */
 
 void bst_map_free(bst_map map) {
+    if ( map->wal ) {
+        bst_wal_close(map->wal);
+    }
     bs_tree_free(map);
 }
 
@@ -171,7 +497,7 @@ void * bst_map_search_data(const bst_map map, const char * key) {
  * \brief           Inserts a key-value pair into a map.
  * \details         The value is replaced if the key is already found
  * in the map. Any memory consumed by the old value is automatically
- * `free()`d.
+ * `free()`d. If a write-ahead log is attached, the insertion is logged.
  * \param map       A pointer to the map.
  * \param key       The key of the new value to insert.
  * \param value     A pointer to the new value to insert.
@@ -180,11 +506,312 @@ void * bst_map_search_data(const bst_map map, const char * key) {
  */
 
 bool bst_map_insert(bst_map map, const char * key, void * value) {
-    kvpair new_pair = new_kvpair(key, value);
+    if ( map->wal ) {
+        bst_wal_log_insert(map->wal, key, value);
+    }
+
+    kvpair new_pair = new_kvpair(map, key, value);
     return bs_tree_insert_subtree(map, &map->root, new_pair);
 }
 
 
+/*!
+ * \brief           Inserts a batch of key-value pairs into a map.
+ * \details         The result is the same as inserting the pairs one at
+ * a time in order, so for a key repeated in the batch the last value
+ * wins, and replaced values are `free()`d. The batch is sorted, with
+ * thread support in parallel for a large batch, and merged with the
+ * pairs already in the map in a single ordered sweep, reusing the
+ * existing nodes, after which the whole tree is relinked balanced. This
+ * takes O(m + n log n) time for a map of m pairs, against as much as
+ * O(n(m + n)) for separate insertions into an unbalanced tree.
+ * \param map       A pointer to the map.
+ * \param keys      The keys of the pairs.
+ * \param values    The values of the pairs. The map takes ownership of
+ * the values, but not the array.
+ * \param n         The number of pairs.
+ * \param duplicates An array of at least `n` elements to populate with,
+ * for each pair, `true` if its key was already in the map or earlier in
+ * the batch, as bst_map_insert() would have returned, and `false`
+ * otherwise. This parameter is ignored if set to NULL.
+ * \returns         The number of pairs whose key was a duplicate.
+ */
+
+size_t bst_map_insert_batch(bst_map map, const char ** keys,
+                            void ** values, const size_t n,
+                            bool * duplicates) {
+    if ( n == 0 ) {
+        return 0;
+    }
+
+    if ( map->wal ) {
+        for ( size_t i = 0; i < n; ++i ) {
+            bst_wal_log_insert(map->wal, keys[i], values[i]);
+        }
+    }
+
+    size_t * order = term_malloc(sizeof(*order) * 2 * n);
+    for ( size_t i = 0; i < n; ++i ) {
+        order[i] = i;
+    }
+    batch_sort_t job = {order, order + n, n, keys, PARALLEL_SORT_DEPTH};
+    sort_batch(&job);
+
+    /*  Existing nodes, then merged nodes, share one allocation  */
+
+    const size_t m = map->length;
+    bs_tree_node * existing = term_malloc(sizeof(*existing) * (2 * m + n));
+    bs_tree_node * merged = existing + m;
+    bs_tree_collect_nodes(map, existing);
+
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+    size_t num_duplicates = 0;
+
+    while ( j < n ) {
+        const char * key = keys[order[j]];
+        kvpair pair = i < m ? existing[i]->data : NULL;
+        const int compare = pair ? strcmp(pair->key, key) : 1;
+
+        if ( compare < 0 ) {
+            merged[count++] = existing[i++];
+            continue;
+        }
+
+        /*  Of a run of equal keys, the last in the batch wins  */
+
+        size_t end = j + 1;
+        while ( end < n && strcmp(keys[order[end]], key) == 0 ) {
+            ++end;
+        }
+        void * value = values[order[end - 1]];
+
+        if ( compare == 0 ) {
+            free(pair->value);
+            pair->value = value;
+            merged[count++] = existing[i++];
+        } else {
+            merged[count++] = bs_tree_new_node(new_kvpair(map, key, value));
+        }
+
+        for ( size_t k = j; k < end; ++k ) {
+            const bool duplicate = k > j || compare == 0;
+            if ( duplicates ) {
+                duplicates[order[k]] = duplicate;
+            }
+            if ( duplicate ) {
+                ++num_duplicates;
+            }
+            if ( k < end - 1 ) {
+                free(values[order[k]]);
+            }
+        }
+
+        j = end;
+    }
+
+    while ( i < m ) {
+        merged[count++] = existing[i++];
+    }
+
+    bs_tree_relink_sorted(map, merged, count);
+
+    free(existing);
+    free(order);
+    return num_duplicates;
+}
+
+
+/*!
+ * \brief           Deletes a key and its value from a map.
+ * \details         Any memory consumed by the value is automatically
+ * `free()`d. If a write-ahead log is attached, the deletion is logged.
+ * \param map       A pointer to the map.
+ * \param key       The key to delete.
+ * \returns         `true` if the key was found and deleted, `false` if
+ * the key was not present.
+ */
+
+bool bst_map_delete(bst_map map, const char * key) {
+
+    /*  key is cast to (char *) to match data member of kvpair,
+        safe since `pair` itself is declared `const`, and passed
+        to bs_tree_delete() which accepts a `const` pointer.  */
+
+    const kvpair_t pair = {(char *) key, NULL};
+    const bool found = bs_tree_delete(map, &pair);
+
+    if ( found && map->wal ) {
+        bst_wal_log_delete(map->wal, key);
+    }
+
+    return found;
+}
+
+
+/*!
+ * \brief           Visits each key-value pair in a map in key order.
+ * \details         `kvfunc()` must not modify the map.
+ * \param map       A pointer to the map.
+ * \param kvfunc    A pointer to the function to invoke for each pair.
+ * The function is passed the key, the value, and `arg`.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+void bst_map_traverse(bst_map map,
+        void (*kvfunc)(const char *, void *, void *), void * arg) {
+    if ( map ) {
+        traverse_int(map->root, kvfunc, arg);
+    }
+}
+
+
+/*!
+ * \brief           Visits, in key order, each pair whose key begins with
+ * a specified prefix.
+ * \details         The tree is descended directly to the first matching
+ * key, and the traversal stops at the first key past the matching range,
+ * so only O(log n + k) nodes are visited for k matching pairs in a
+ * reasonably balanced tree. An empty prefix visits every pair.
+ * \param map       A pointer to the map.
+ * \param prefix    The prefix to match.
+ * \param kvfunc    A pointer to the function to invoke for each matching
+ * pair. The function is passed the key, the value, and `arg`.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+void bst_map_prefix_traverse(bst_map map, const char * prefix,
+        void (*kvfunc)(const char *, void *, void *), void * arg) {
+    if ( map ) {
+        prefix_traverse_int(map->root, prefix, strlen(prefix), kvfunc, arg);
+    }
+}
+
+
+/*!
+ * \brief           Creates a cursor to visit a map's pairs in ascending
+ * key order.
+ * \details         The map must not be modified while the cursor is in
+ * use. Each pair is reached in amortized O(1) steps.
+ * \param map       A pointer to the map.
+ * \returns         A pointer to the new cursor, positioned before the
+ * first pair. The cursor should be freed with bst_map_cursor_free().
+ */
+
+bst_map_cursor bst_map_cursor_forward(const bst_map map) {
+    return cursor_init(map, false);
+}
+
+
+/*!
+ * \brief           Creates a cursor to visit a map's pairs in descending
+ * key order.
+ * \details         The map must not be modified while the cursor is in
+ * use. Each pair is reached in amortized O(1) steps.
+ * \param map       A pointer to the map.
+ * \returns         A pointer to the new cursor, positioned before the
+ * last pair. The cursor should be freed with bst_map_cursor_free().
+ */
+
+bst_map_cursor bst_map_cursor_reverse(const bst_map map) {
+    return cursor_init(map, true);
+}
+
+
+/*!
+ * \brief           Advances a cursor to the next pair.
+ * \param cursor    A pointer to the cursor.
+ * \param key       A pointer to a `const char *` to populate with the
+ * key of the pair. This parameter is ignored if set to NULL.
+ * \param value     A pointer to a `void *` to populate with the value
+ * of the pair. This parameter is ignored if set to NULL.
+ * \returns         `true` if the cursor was advanced to a pair, `false`
+ * if there are no more pairs.
+ */
+
+bool bst_map_cursor_next(bst_map_cursor cursor,
+                         const char ** key, void ** value) {
+    if ( cursor->depth == 0 ) {
+        return false;
+    }
+
+    bs_tree_node node = cursor->stack[--cursor->depth];
+    const kvpair pair = (kvpair) node->data;
+    cursor_push_edge(cursor, cursor->reverse ? node->left : node->right);
+
+    if ( key ) {
+        *key = pair->key;
+    }
+
+    if ( value ) {
+        *value = pair->value;
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a cursor.
+ * \param cursor    A pointer to the cursor to free.
+ */
+
+void bst_map_cursor_free(bst_map_cursor cursor) {
+    free(cursor->stack);
+    free(cursor);
+}
+
+
+/*!
+ * \brief           Attaches a membership filter to a map.
+ * \details         Searches for keys which are not in the map are then
+ * usually rejected by the filter without descending the tree. The filter
+ * is updated on insertion, but deleted keys remain in it until
+ * bst_map_rebuild_filter() is called.
+ * \param map       A pointer to the map.
+ * \param capacity  The number of keys the filter should initially be
+ * sized for. The filter grows automatically as keys are added.
+ */
+
+void bst_map_attach_filter(bst_map map, const size_t capacity) {
+    bs_tree_attach_filter(map, hash_kvpair, capacity);
+}
+
+
+/*!
+ * \brief           Detaches and frees a map's membership filter, if any.
+ * \param map       A pointer to the map.
+ */
+
+void bst_map_detach_filter(bst_map map) {
+    bs_tree_detach_filter(map);
+}
+
+
+/*!
+ * \brief           Rebuilds a map's membership filter, clearing any
+ * deleted keys from it.
+ * \param map       A pointer to the map.
+ */
+
+void bst_map_rebuild_filter(bst_map map) {
+    bs_tree_rebuild_filter(map);
+}
+
+
+/*!
+ * \brief           Gets the statistics for a map's membership filter.
+ * \param map       A pointer to the map.
+ * \param stats     A pointer to a struct to populate with the statistics.
+ */
+
+void bst_map_filter_stats(const bst_map map,
+                          bs_tree_filter_stats_t * stats) {
+    bs_tree_filter_stats(map, stats);
+}
+
+
 /*!
  * \brief           Locks a map's mutex.
  * \param map       A pointer to the map.
@@ -203,3 +830,28 @@ void bst_map_lock(bst_map map) {
 void bst_map_unlock(bst_map map) {
     bs_tree_unlock(map);
 }
+
+
+/*!
+ * \brief           Builds a map from key-value pairs in key order.
+ * \details         The map is built balanced in linear time, rather than
+ * by inserting each pair in turn.
+ * \param map       A pointer to the map, which must be empty.
+ * \param keys      A pointer to the keys, in strictly increasing order.
+ * The keys are copied.
+ * \param values    A pointer to the values. The map takes ownership of
+ * the values, but not the array.
+ * \param n         The number of pairs.
+ */
+
+void bst_map_build_sorted(bst_map map, const char ** keys,
+                          void ** values, const size_t n) {
+    void ** pairs = term_malloc(sizeof(*pairs) * (n ? n : 1));
+
+    for ( size_t i = 0; i < n; ++i ) {
+        pairs[i] = new_kvpair(map, keys[i], values[i]);
+    }
+
+    bs_tree_build_sorted(map, pairs, n);
+    free(pairs);
+}
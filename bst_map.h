@@ -0,0 +1,32 @@
+/*!
+ * \file            bst_map.h
+ * \brief           Developer interface to binary search tree map data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_BINARY_SEARCH_TREE_MAP_DEV_H
+#define PG_CDS_BINARY_SEARCH_TREE_MAP_DEV_H
+
+#include <stddef.h>
+#include "cds_bst_map.h"
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void bst_map_build_sorted(bst_map map, const char ** keys,
+                          void ** values, const size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_BINARY_SEARCH_TREE_MAP_DEV_H  */
@@ -0,0 +1,639 @@
+/*!
+ * \file            bst_wal.c
+ * \brief           Implementation of binary search tree map write-ahead
+ * log.
+ * \details         Once a log is attached to a map, every insertion and
+ * deletion appends a record to it. Records are gathered in memory and
+ * written and `fsync()`ed together at most once per sync interval, so
+ * that a busy map pays for one `fsync()` per interval rather than per
+ * operation, at the cost of losing at most the last interval's changes
+ * in a crash.
+ *
+ * Each record is a 32-bit CRC of the rest of the record, an operation
+ * byte, the 32-bit key and value lengths, the key and a terminating NUL,
+ * and the value. An insertion of a `NULL` value has an operation of its
+ * own, so that it replays as `NULL` rather than as an empty value. All
+ * integers are little-endian. Replay stops at the
+ * first incomplete or corrupt record, which is where a crash during a
+ * write leaves the log.
+ *
+ * Replay does not insert the logged operations one by one. It sorts the
+ * records by key, keeping their log order within each key, takes the
+ * last operation on each key, and builds a balanced map directly from
+ * the surviving pairs in linear time.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+/*!
+ * \brief           Enable POSIX library.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_bst_map.h"
+#include "cds_bst_wal.h"
+#include "bst_map.h"
+#include "bst_wal.h"
+#include "bs_tree.h"
+
+
+/*!
+ * \brief           Size of a record header.
+ */
+
+#define RECORD_HEADER_SIZE 13
+
+
+/*!
+ * \brief           Buffered size at which records are written out.
+ */
+
+#define WRITE_THRESHOLD (64 * 1024)
+
+
+/*!
+ * \brief           Enumeration of record operations.
+ */
+
+enum wal_op {
+    WAL_INSERT = 1,             /*!< Insertion of a key-value pair */
+    WAL_DELETE = 2,             /*!< Deletion of a key */
+    WAL_INSERT_NULL = 3         /*!< Insertion of a key with no value */
+};
+
+
+/*!
+ * \brief           Struct to contain a write-ahead log.
+ */
+
+typedef struct bst_wal_t {
+    int fd;                     /*!< File descriptor of log */
+    char * filename;            /*!< Name of log file */
+    unsigned char * buffer;     /*!< Records not yet written */
+    size_t len;                 /*!< Length of buffered records */
+    size_t cap;                 /*!< Capacity of buffer */
+    unsigned int interval;      /*!< Sync interval in milliseconds */
+    uint64_t last_sync;         /*!< Time of last sync in milliseconds */
+    bool failed;                /*!< Set if a write has failed */
+    const void * (*vfunc)(const void *, size_t *);  /*!< Value serializer */
+} bst_wal_t;
+
+
+/*!
+ * \brief           Struct for a record read during replay.
+ */
+
+typedef struct wal_record_t {
+    const char * key;           /*!< Pointer to key */
+    const unsigned char * value;    /*!< Pointer to value */
+    size_t len;                 /*!< Length of value */
+    size_t seq;                 /*!< Position in log */
+    int op;                     /*!< Operation */
+} wal_record_t;
+
+
+/*!
+ * \brief           Returns the monotonic time.
+ * \returns         The monotonic time in milliseconds.
+ */
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+
+/*!
+ * \brief           Calculates a CRC-32 checksum.
+ * \param data      A pointer to the data.
+ * \param len       The length of the data.
+ * \returns         The IEEE 802.3 CRC-32 of the data.
+ */
+
+static uint32_t crc32(const unsigned char * data, const size_t len) {
+    uint32_t crc = 0xffffffffU;
+
+    for ( size_t i = 0; i < len; ++i ) {
+        crc ^= data[i];
+        for ( int bit = 0; bit < 8; ++bit ) {
+            crc = (crc >> 1) ^ (0xedb88320U & (0U - (crc & 1U)));
+        }
+    }
+
+    return ~crc;
+}
+
+
+/*!
+ * \brief           Stores a little-endian 32-bit integer.
+ * \param p         A pointer to the destination.
+ * \param value     The integer.
+ */
+
+static void put_u32(unsigned char * p, const uint32_t value) {
+    for ( int i = 0; i < 4; ++i ) {
+        p[i] = (unsigned char) (value >> (8 * i));
+    }
+}
+
+
+/*!
+ * \brief           Reads a little-endian 32-bit integer.
+ * \param p         A pointer to the integer.
+ * \returns         The integer.
+ */
+
+static uint32_t get_u32(const unsigned char * p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 |
+           (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+
+/*!
+ * \brief           Writes out a log's buffered records.
+ * \param wal       A pointer to the log.
+ */
+
+static void write_buffer(bst_wal_t * wal) {
+    size_t written = 0;
+
+    while ( written < wal->len ) {
+        const ssize_t n = write(wal->fd, wal->buffer + written,
+                                wal->len - written);
+        if ( n < 0 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            wal->failed = true;
+            break;
+        }
+        written += (size_t) n;
+    }
+
+    wal->len = 0;
+}
+
+
+/*!
+ * \brief           Writes out and syncs a log's buffered records.
+ * \param wal       A pointer to the log.
+ */
+
+static void sync_wal(bst_wal_t * wal) {
+    write_buffer(wal);
+    if ( fsync(wal->fd) != 0 ) {
+        wal->failed = true;
+    }
+    wal->last_sync = monotonic_ms();
+}
+
+
+/*!
+ * \brief           Appends a record to a log.
+ * \details         The record is written out with any others buffered
+ * once the sync interval has elapsed since the last sync.
+ * \param wal       A pointer to the log.
+ * \param op        The operation.
+ * \param key       The key.
+ * \param value     A pointer to the serialized value.
+ * \param len       The length of the serialized value.
+ */
+
+static void log_record(bst_wal_t * wal, const int op, const char * key,
+                       const void * value, const size_t len) {
+    const size_t key_len = strlen(key);
+    const size_t size = RECORD_HEADER_SIZE + key_len + 1 + len;
+
+    if ( wal->len + size > wal->cap ) {
+        size_t new_cap = wal->cap ? wal->cap * 2 : 4096;
+        while ( new_cap < wal->len + size ) {
+            new_cap *= 2;
+        }
+        wal->buffer = term_realloc(wal->buffer, new_cap);
+        wal->cap = new_cap;
+    }
+
+    unsigned char * record = wal->buffer + wal->len;
+    record[4] = (unsigned char) op;
+    put_u32(record + 5, (uint32_t) key_len);
+    put_u32(record + 9, (uint32_t) len);
+    memcpy(record + RECORD_HEADER_SIZE, key, key_len + 1);
+    if ( len ) {
+        memcpy(record + RECORD_HEADER_SIZE + key_len + 1, value, len);
+    }
+    put_u32(record, crc32(record + 4, size - 4));
+    wal->len += size;
+
+    if ( wal->interval == 0 ||
+         monotonic_ms() - wal->last_sync >= wal->interval ) {
+        sync_wal(wal);
+    } else if ( wal->len >= WRITE_THRESHOLD ) {
+        write_buffer(wal);
+    }
+}
+
+
+/*!
+ * \brief           Appends an insertion record for a pair during a
+ * map traversal.
+ * \param key       The key.
+ * \param value     A pointer to the value.
+ * \param arg       A pointer to the log.
+ */
+
+static void log_pair(const char * key, void * value, void * arg) {
+    bst_wal_log_insert(arg, key, value);
+}
+
+
+/*!
+ * \brief           Compares two replayed records by key, then by position
+ * in the log.
+ * \param a         A pointer to the first record.
+ * \param b         A pointer to the second record.
+ * \returns         Less than zero, zero or greater than zero if the first
+ * record sorts before, with, or after the second.
+ */
+
+static int compare_record(const void * a, const void * b) {
+    const wal_record_t * rec_a = a;
+    const wal_record_t * rec_b = b;
+    const int compare = strcmp(rec_a->key, rec_b->key);
+
+    if ( compare ) {
+        return compare;
+    }
+    return (rec_a->seq > rec_b->seq) - (rec_a->seq < rec_b->seq);
+}
+
+
+/*!
+ * \brief           Reads a whole file into memory.
+ * \param filename  The name of the file.
+ * \param p_size    A pointer to populate with the size of the file.
+ * \returns         A pointer to the contents, which should be `free()`d
+ * by the caller, or `NULL` on failure. A file which does not exist is
+ * read as empty.
+ */
+
+static unsigned char * read_file(const char * filename, size_t * p_size) {
+    FILE * fp = fopen(filename, "rb");
+    if ( fp == NULL ) {
+        if ( errno == ENOENT ) {
+            *p_size = 0;
+            return term_malloc(1);
+        }
+        return NULL;
+    }
+
+    unsigned char * contents = NULL;
+    long size;
+
+    if ( fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) >= 0 &&
+         fseek(fp, 0, SEEK_SET) == 0 ) {
+        contents = term_malloc(size ? (size_t) size : 1);
+        if ( fread(contents, 1, (size_t) size, fp) == (size_t) size ) {
+            *p_size = (size_t) size;
+        } else {
+            free(contents);
+            contents = NULL;
+        }
+    }
+
+    fclose(fp);
+    return contents;
+}
+
+
+/*!
+ * \brief           Attaches a write-ahead log to a map.
+ * \details         Records are appended to any existing log file, so a
+ * map rebuilt with bst_map_replay_wal() can be reattached to the same log
+ * and carry on. Any log already attached is detached first.
+ * \param map       A pointer to the map.
+ * \param filename  The name of the log file, which is created if it does
+ * not exist.
+ * \param sync_interval The maximum time in milliseconds for which logged
+ * operations are buffered before being written and `fsync()`ed together.
+ * If this is zero, every operation is synced before it returns.
+ * \param vfunc     A pointer to a function to serialize a value. The
+ * function is passed a pointer to the value, and a pointer to a `size_t`
+ * to populate with the length of the serialized value, and should return
+ * a pointer to the serialized bytes, which must remain valid until the
+ * function is next called. If this is `NULL`, values are taken to be
+ * strings and logged with their terminating NULs.
+ * \returns         Zero on success, or `CDSERR_IO` if the log file could
+ * not be opened.
+ */
+
+int bst_map_attach_wal(bst_map map, const char * filename,
+        const unsigned int sync_interval,
+        const void * (*vfunc)(const void *, size_t *)) {
+    bst_map_detach_wal(map);
+
+    const int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if ( fd == -1 ) {
+        return CDSERR_IO;
+    }
+
+    bst_wal_t * wal = term_malloc(sizeof(*wal));
+    wal->fd = fd;
+    wal->filename = term_strdup(filename);
+    wal->buffer = NULL;
+    wal->len = 0;
+    wal->cap = 0;
+    wal->interval = sync_interval;
+    wal->last_sync = monotonic_ms();
+    wal->failed = false;
+    wal->vfunc = vfunc;
+
+    map->wal = wal;
+    return 0;
+}
+
+
+/*!
+ * \brief           Syncs and detaches a map's write-ahead log.
+ * \details         Nothing is done if the map has no log.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` if any write to the
+ * log has failed since it was attached.
+ */
+
+int bst_map_detach_wal(bst_map map) {
+    int status = 0;
+
+    if ( map->wal ) {
+        status = bst_wal_close(map->wal);
+        map->wal = NULL;
+    }
+
+    return status;
+}
+
+
+/*!
+ * \brief           Writes and syncs any buffered records in a map's
+ * write-ahead log.
+ * \details         Records are otherwise only synced when an operation
+ * is logged after the sync interval has elapsed, so a map which falls
+ * idle should be synced explicitly.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` if any write to the
+ * log has failed since it was attached.
+ */
+
+int bst_map_sync_wal(bst_map map) {
+    if ( map->wal == NULL ) {
+        return 0;
+    }
+
+    sync_wal(map->wal);
+    return map->wal->failed ? CDSERR_IO : 0;
+}
+
+
+/*!
+ * \brief           Replaces a map's write-ahead log with a snapshot of
+ * the map.
+ * \details         The new log holds one insertion record for each pair
+ * in the map, and atomically replaces the old log once it has been
+ * synced, so the log stops growing without bound and replays quickly.
+ * \param map       A pointer to the map, which must have a log attached.
+ * \returns         Zero on success, or `CDSERR_IO` on failure, in which
+ * case the old log remains attached.
+ */
+
+int bst_map_checkpoint_wal(bst_map map) {
+    bst_wal_t * wal = map->wal;
+    const size_t name_size = strlen(wal->filename) + 5;
+    char * tmp_name = term_malloc(name_size);
+    snprintf(tmp_name, name_size, "%s.tmp", wal->filename);
+
+    const int fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if ( fd == -1 ) {
+        free(tmp_name);
+        return CDSERR_IO;
+    }
+
+    /*  Write the snapshot through a temporary log on the new file  */
+
+    bst_wal_t snapshot = *wal;
+    snapshot.fd = fd;
+    snapshot.buffer = NULL;
+    snapshot.len = 0;
+    snapshot.cap = 0;
+    snapshot.interval = (unsigned int) -1;
+    snapshot.last_sync = monotonic_ms();
+    snapshot.failed = false;
+
+    bst_map_traverse(map, log_pair, &snapshot);
+    sync_wal(&snapshot);
+    free(snapshot.buffer);
+
+    if ( close(fd) != 0 || snapshot.failed ||
+         rename(tmp_name, wal->filename) != 0 ) {
+        remove(tmp_name);
+        free(tmp_name);
+        return CDSERR_IO;
+    }
+    free(tmp_name);
+
+    /*  Buffered records are already reflected in the snapshot  */
+
+    wal->len = 0;
+    const int new_fd = open(wal->filename, O_WRONLY | O_APPEND);
+    if ( new_fd == -1 ) {
+        wal->failed = true;
+        return CDSERR_IO;
+    }
+
+    close(wal->fd);
+    wal->fd = new_fd;
+    return 0;
+}
+
+
+/*!
+ * \brief           Rebuilds a map from a write-ahead log.
+ * \details         Replay stops at the first incomplete or corrupt
+ * record. If the map is then reattached to the same log, call
+ * bst_map_checkpoint_wal() so that new records do not follow such a
+ * record, where they would never be replayed.
+ * \param filename  The name of the log file. A log file which does not
+ * exist is replayed as empty.
+ * \param dfunc     A pointer to a function to deserialize a value. The
+ * function is passed a pointer to the serialized bytes and their length,
+ * and should return a pointer to a new value, which the map will own.
+ * If this is `NULL`, each value is a `malloc()`ed copy of its bytes.
+ * A key inserted with a `NULL` value is replayed with a `NULL` value,
+ * without calling the function.
+ * \returns         A pointer to the new map, or `NULL` if the log file
+ * could not be read.
+ */
+
+bst_map bst_map_replay_wal(const char * filename,
+        void * (*dfunc)(const void *, size_t)) {
+    size_t size;
+    unsigned char * contents = read_file(filename, &size);
+    if ( contents == NULL ) {
+        return NULL;
+    }
+
+    wal_record_t * records = NULL;
+    size_t num_records = 0;
+    size_t capacity = 0;
+    size_t pos = 0;
+
+    while ( size - pos >= RECORD_HEADER_SIZE ) {
+        const unsigned char * record = contents + pos;
+        const size_t key_len = get_u32(record + 5);
+        const size_t len = get_u32(record + 9);
+        const size_t avail = size - pos - RECORD_HEADER_SIZE;
+
+        if ( key_len >= avail || len > avail - key_len - 1 ) {
+            break;
+        }
+
+        const size_t record_size = RECORD_HEADER_SIZE + key_len + 1 + len;
+        if ( get_u32(record) != crc32(record + 4, record_size - 4) ||
+             record[RECORD_HEADER_SIZE + key_len] != '\0' ||
+             record[4] < WAL_INSERT || record[4] > WAL_INSERT_NULL ) {
+            break;
+        }
+
+        if ( num_records == capacity ) {
+            capacity = capacity ? capacity * 2 : 256;
+            records = term_realloc(records, sizeof(*records) * capacity);
+        }
+
+        wal_record_t * rec = &records[num_records];
+        rec->key = (const char *) record + RECORD_HEADER_SIZE;
+        rec->value = record + RECORD_HEADER_SIZE + key_len + 1;
+        rec->len = len;
+        rec->seq = num_records;
+        rec->op = record[4];
+        ++num_records;
+
+        pos += record_size;
+    }
+
+    if ( num_records ) {
+        qsort(records, num_records, sizeof(*records), compare_record);
+    }
+
+    /*  Keep the last operation on each key, if it was an insertion  */
+
+    const char ** keys = term_malloc(sizeof(*keys) *
+                                     (num_records ? num_records : 1));
+    void ** values = term_malloc(sizeof(*values) *
+                                 (num_records ? num_records : 1));
+    size_t num_pairs = 0;
+
+    for ( size_t i = 0; i < num_records; ++i ) {
+        const wal_record_t * rec = &records[i];
+
+        if ( (i + 1 < num_records &&
+              strcmp(rec->key, records[i + 1].key) == 0) ||
+             rec->op == WAL_DELETE ) {
+            continue;
+        }
+
+        keys[num_pairs] = rec->key;
+        if ( rec->op == WAL_INSERT_NULL ) {
+            values[num_pairs] = NULL;
+        } else if ( dfunc ) {
+            values[num_pairs] = dfunc(rec->value, rec->len);
+        } else {
+            values[num_pairs] = term_malloc(rec->len ? rec->len : 1);
+            memcpy(values[num_pairs], rec->value, rec->len);
+        }
+        ++num_pairs;
+    }
+
+    bst_map map = bst_map_init();
+    bst_map_build_sorted(map, keys, values, num_pairs);
+
+    free(keys);
+    free(values);
+    free(records);
+    free(contents);
+
+    return map;
+}
+
+
+/*!
+ * \brief           Logs an insertion.
+ * \param wal       A pointer to the log.
+ * \param key       The key.
+ * \param value     A pointer to the value, which may be `NULL`.
+ */
+
+void bst_wal_log_insert(struct bst_wal_t * wal,
+                        const char * key, const void * value) {
+    if ( value == NULL ) {
+        log_record(wal, WAL_INSERT_NULL, key, NULL, 0);
+        return;
+    }
+
+    const void * bytes;
+    size_t len;
+
+    if ( wal->vfunc ) {
+        bytes = wal->vfunc(value, &len);
+    } else {
+        bytes = value;
+        len = strlen(value) + 1;
+    }
+
+    log_record(wal, WAL_INSERT, key, bytes, bytes ? len : 0);
+}
+
+
+/*!
+ * \brief           Logs a deletion.
+ * \param wal       A pointer to the log.
+ * \param key       The key.
+ */
+
+void bst_wal_log_delete(struct bst_wal_t * wal, const char * key) {
+    log_record(wal, WAL_DELETE, key, NULL, 0);
+}
+
+
+/*!
+ * \brief           Syncs and closes a log, and frees its resources.
+ * \param wal       A pointer to the log.
+ * \returns         Zero on success, or `CDSERR_IO` if any write to the
+ * log has failed since it was attached.
+ */
+
+int bst_wal_close(struct bst_wal_t * wal) {
+    sync_wal(wal);
+
+    if ( close(wal->fd) != 0 ) {
+        wal->failed = true;
+    }
+
+    const int status = wal->failed ? CDSERR_IO : 0;
+    free(wal->buffer);
+    free(wal->filename);
+    free(wal);
+    return status;
+}
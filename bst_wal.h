@@ -0,0 +1,38 @@
+/*!
+ * \file            bst_wal.h
+ * \brief           Developer interface to binary search tree map
+ * write-ahead log.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_BST_MAP_WAL_DEV_H
+#define PG_CDS_BST_MAP_WAL_DEV_H
+
+#include "cds_bst_wal.h"
+
+
+/*  Forward declaration  */
+
+struct bst_wal_t;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void bst_wal_log_insert(struct bst_wal_t * wal,
+                        const char * key, const void * value);
+void bst_wal_log_delete(struct bst_wal_t * wal, const char * key);
+int bst_wal_close(struct bst_wal_t * wal);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_BST_MAP_WAL_DEV_H  */
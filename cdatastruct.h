@@ -22,6 +22,19 @@
 #include "cds_bst_map.h"
 #include "cds_ia_stack.h"
 #include "cds_da_stack.h"
+#include "cds_bst_kmap.h"
+#include "cds_shard_map.h"
+#include "cds_frozen_map.h"
+#include "cds_bloom_filter.h"
+#include "cds_bst_counter.h"
+#include "cds_lru_cache.h"
+#include "cds_ttl_map.h"
+#include "cds_sstable.h"
+#include "cds_lsm_map.h"
+#include "cds_bst_wal.h"
+#include "cds_mv_map.h"
+#include "cds_intern.h"
+#include "cds_ul_list.h"
 
 
 #endif          /*  PG_C_DATA_STRUCTURES_H  */
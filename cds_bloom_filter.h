@@ -0,0 +1,46 @@
+/*!
+ * \file            cds_bloom_filter.h
+ * \brief           User interface to blocked Bloom filter data structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_BLOOM_FILTER_H
+#define PG_CDS_BLOOM_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for filter pointer.
+ */
+
+typedef struct bloom_filter_t * bloom_filter;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bloom_filter bloom_filter_init(const size_t capacity,
+                               const size_t bits_per_key);
+void bloom_filter_free(bloom_filter filter);
+
+size_t bloom_filter_capacity(const bloom_filter filter);
+void bloom_filter_clear(bloom_filter filter);
+
+void bloom_filter_add(bloom_filter filter, const uint64_t hash);
+bool bloom_filter_query(const bloom_filter filter, const uint64_t hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_BLOOM_FILTER_H  */
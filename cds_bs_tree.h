@@ -11,6 +11,7 @@
 #define PG_CDS_BINARY_SEARCH_TREE_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /*!
  * \brief           Struct for binary search tree node.
@@ -23,6 +24,18 @@ typedef struct bs_tree_node_t {
 } bs_tree_node_t;
 
 
+/*!
+ * \brief           Struct for membership filter statistics.
+ */
+
+typedef struct bs_tree_filter_stats_t {
+    unsigned long long queries;         /*!< Searches checked by filter */
+    unsigned long long rejected;        /*!< Searches rejected by filter */
+    unsigned long long hits;            /*!< Searches passed and found */
+    unsigned long long false_positives; /*!< Searches passed, not found */
+} bs_tree_filter_stats_t;
+
+
 /*!
  * \brief           Typedef for tree pointer.
  */
@@ -38,12 +51,17 @@ extern "C" {
 
 bs_tree bs_tree_init(int (*cfunc)(const void *, const void *),
                      void (*free_func)(void *));
+bs_tree bs_tree_init_intrusive(int (*cfunc)(const void *, const void *),
+                               void (*free_func)(void *),
+                               const size_t offset);
 void bs_tree_free(bs_tree tree);
 
 bool bs_tree_isempty(const bs_tree tree);
 size_t bs_tree_length(const bs_tree tree);
 
 bool bs_tree_insert(bs_tree tree, void * data);
+bs_tree_node_t * bs_tree_insert_node(bs_tree tree, bs_tree_node_t * node);
+bool bs_tree_delete(bs_tree tree, const void * data);
 bool bs_tree_search(const bs_tree tree, const void * data);
 void * bs_tree_search_data(const bs_tree tree, const void * data);
 
@@ -60,6 +78,13 @@ void bs_tree_inorder_right_traverse(bs_tree tree,
 void bs_tree_postorder_right_traverse(bs_tree tree,
         void (*dfunc)(void *, void * arg), void * arg);
 
+void bs_tree_attach_filter(bs_tree tree,
+        uint64_t (*hfunc)(const void *), const size_t capacity);
+void bs_tree_detach_filter(bs_tree tree);
+void bs_tree_rebuild_filter(bs_tree tree);
+void bs_tree_filter_stats(const bs_tree tree,
+                          bs_tree_filter_stats_t * stats);
+
 void bs_tree_lock(bs_tree tree);
 void bs_tree_unlock(bs_tree tree);
 
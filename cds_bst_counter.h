@@ -0,0 +1,55 @@
+/*!
+ * \file            cds_bst_counter.h
+ * \brief           User interface to binary search tree counter map data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_BINARY_SEARCH_TREE_COUNTER_H
+#define PG_CDS_BINARY_SEARCH_TREE_COUNTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for counter map pointer.
+ */
+
+typedef struct bs_tree_t * bst_counter;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bst_counter bst_counter_init(void);
+void bst_counter_free(bst_counter counter);
+
+bool bst_counter_isempty(const bst_counter counter);
+size_t bst_counter_length(const bst_counter counter);
+
+uint64_t bst_counter_increment(bst_counter counter, const char * key,
+                               const uint64_t delta);
+uint64_t bst_counter_get(const bst_counter counter, const char * key);
+
+void bst_counter_traverse(bst_counter counter,
+        void (*cfunc)(const char *, uint64_t, void *), void * arg);
+size_t bst_counter_top(const bst_counter counter, const size_t k,
+                       const char ** keys, uint64_t * counts);
+
+void bst_counter_lock(bst_counter counter);
+void bst_counter_unlock(bst_counter counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_BINARY_SEARCH_TREE_COUNTER_H  */
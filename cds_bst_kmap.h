@@ -0,0 +1,67 @@
+/*!
+ * \file            cds_bst_kmap.h
+ * \brief           User interface to binary search tree map data structure
+ * with integer or binary keys.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_BINARY_SEARCH_TREE_KEY_MAP_H
+#define PG_CDS_BINARY_SEARCH_TREE_KEY_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Enumeration of map key types.
+ */
+
+typedef enum bst_kmap_keytype {
+    BST_KMAP_INTEGER,           /*!< Native 64-bit integer keys */
+    BST_KMAP_BINARY             /*!< Length-delimited binary keys */
+} bst_kmap_keytype;
+
+
+/*!
+ * \brief           Typedef for map pointer.
+ */
+
+typedef struct bs_tree_t * bst_kmap;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bst_kmap bst_kmap_init(const bst_kmap_keytype type);
+void bst_kmap_free(bst_kmap map);
+
+bool bst_kmap_isempty(const bst_kmap map);
+size_t bst_kmap_length(const bst_kmap map);
+
+bool bst_kmap_insert_int(bst_kmap map, const int64_t key, void * value);
+bool bst_kmap_search_int(const bst_kmap map, const int64_t key);
+void * bst_kmap_search_int_data(const bst_kmap map, const int64_t key);
+
+bool bst_kmap_insert_bin(bst_kmap map, const void * key,
+                         const size_t len, void * value);
+bool bst_kmap_search_bin(const bst_kmap map, const void * key,
+                         const size_t len);
+void * bst_kmap_search_bin_data(const bst_kmap map, const void * key,
+                                const size_t len);
+
+void bst_kmap_lock(bst_kmap map);
+void bst_kmap_unlock(bst_kmap map);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_BINARY_SEARCH_TREE_KEY_MAP_H  */
@@ -11,6 +11,8 @@
 #define PG_CDS_BINARY_SEARCH_TREE_MAP_H
 
 #include <stddef.h>
+#include "cds_bs_tree.h"
+#include "cds_intern.h"
 
 
 /*!
@@ -20,6 +22,13 @@
 typedef struct bs_tree_t * bst_map;
 
 
+/*!
+ * \brief           Typedef for map cursor pointer.
+ */
+
+typedef struct bst_map_cursor_t * bst_map_cursor;
+
+
 /*  Function declarations  */
 
 #ifdef __cplusplus
@@ -27,15 +36,37 @@ extern "C" {
 #endif
 
 bst_map bst_map_init(void);
+bst_map bst_map_init_interned(intern_table table);
 void bst_map_free(bst_map map);
 
 bool bst_map_isempty(const bst_map map);
 size_t bst_map_length(const bst_map map);
 
 bool bst_map_insert(bst_map map, const char * key, void * value);
+size_t bst_map_insert_batch(bst_map map, const char ** keys,
+                            void ** values, const size_t n,
+                            bool * duplicates);
+bool bst_map_delete(bst_map map, const char * key);
 bool bst_map_search(const bst_map map, const char * key);
 void * bst_map_search_data(const bst_map map, const char * key);
 
+void bst_map_traverse(bst_map map,
+        void (*kvfunc)(const char *, void *, void *), void * arg);
+void bst_map_prefix_traverse(bst_map map, const char * prefix,
+        void (*kvfunc)(const char *, void *, void *), void * arg);
+
+bst_map_cursor bst_map_cursor_forward(const bst_map map);
+bst_map_cursor bst_map_cursor_reverse(const bst_map map);
+bool bst_map_cursor_next(bst_map_cursor cursor,
+                         const char ** key, void ** value);
+void bst_map_cursor_free(bst_map_cursor cursor);
+
+void bst_map_attach_filter(bst_map map, const size_t capacity);
+void bst_map_detach_filter(bst_map map);
+void bst_map_rebuild_filter(bst_map map);
+void bst_map_filter_stats(const bst_map map,
+                          bs_tree_filter_stats_t * stats);
+
 void bst_map_lock(bst_map map);
 void bst_map_unlock(bst_map map);
 
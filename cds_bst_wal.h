@@ -0,0 +1,39 @@
+/*!
+ * \file            cds_bst_wal.h
+ * \brief           User interface to binary search tree map write-ahead
+ * log.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_BST_MAP_WAL_H
+#define PG_CDS_BST_MAP_WAL_H
+
+#include <stddef.h>
+#include "cds_bst_map.h"
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int bst_map_attach_wal(bst_map map, const char * filename,
+        const unsigned int sync_interval,
+        const void * (*vfunc)(const void *, size_t *));
+int bst_map_detach_wal(bst_map map);
+int bst_map_sync_wal(bst_map map);
+int bst_map_checkpoint_wal(bst_map map);
+
+bst_map bst_map_replay_wal(const char * filename,
+        void * (*dfunc)(const void *, size_t));
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_BST_MAP_WAL_H  */
@@ -10,6 +10,8 @@
 #ifndef PG_CDS_COMMON_H
 #define PG_CDS_COMMON_H
 
+#include <stddef.h>
+
 
 /*!
  * \brief           Enumeration of return error codes.
@@ -19,7 +21,21 @@ typedef enum cds_error {
     CDSERR_ERROR = -1,          /*!< Unspecified error */
     CDSERR_OUTOFRANGE = -2,     /*!< Index out of range */
     CDSERR_NOTFOUND = -3,       /*!< Data element not found */
-    CDSERR_BADITERATOR = -4     /*!< Invalid iterator */
+    CDSERR_BADITERATOR = -4,    /*!< Invalid iterator */
+    CDSERR_IO = -5              /*!< Input/output error */
 } cds_error;
 
+
+/*!
+ * \brief           Gets a pointer to the struct containing a member.
+ * \details         Used with intrusive structures, to get from an embedded
+ * node to the element containing it.
+ * \param ptr       A pointer to the member.
+ * \param type      The type of the containing struct.
+ * \param member    The name of the member within the struct.
+ */
+
+#define cds_container_of(ptr, type, member) \
+    ((type *) ((char *) (ptr) - offsetof(type, member)))
+
 #endif          /*  PG_CDS_COMMON_H  */
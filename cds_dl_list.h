@@ -11,9 +11,14 @@
 #define PG_CDS_DOUBLY_LINKED_LIST_H
 
 #include <stddef.h>
+#include <stdbool.h>
 
 /*!
  * \brief           Struct for double linked list node.
+ * \details         `next` and `prev` are NULL at either end of a list,
+ * except in a circular list, where they point to a sentinel node. Use
+ * dl_list_next() and dl_list_prev() to move between the elements of
+ * either kind of list, which return NULL at either end.
  */
 
 typedef struct dl_list_node_t {
@@ -45,6 +50,13 @@ extern "C" {
 
 dl_list dl_list_init(int (*cfunc)(const void *, const void *),
                      void (*free_func)(void *));
+dl_list dl_list_init_circular(int (*cfunc)(const void *, const void *),
+                              void (*free_func)(void *));
+dl_list dl_list_init_indexed(int (*cfunc)(const void *, const void *),
+                             void (*free_func)(void *));
+dl_list dl_list_init_intrusive(int (*cfunc)(const void *, const void *),
+                               void (*free_func)(void *),
+                               const size_t offset);
 void dl_list_free(dl_list list);
 
 size_t dl_list_length(const dl_list list);
@@ -56,12 +68,31 @@ int dl_list_insert_before(dl_list list, const dl_list_itr itr, void * data);
 int dl_list_insert_at(dl_list list, const size_t index, void * data);
 int dl_list_insert_after(dl_list list, const dl_list_itr itr, void * data);
 
+void dl_list_prepend_node(dl_list list, dl_list_node_t * node);
+void dl_list_append_node(dl_list list, dl_list_node_t * node);
+int dl_list_insert_node_before(dl_list list, const dl_list_itr itr,
+                               dl_list_node_t * node);
+int dl_list_insert_node_after(dl_list list, const dl_list_itr itr,
+                              dl_list_node_t * node);
+
 int dl_list_delete_at(dl_list list, const size_t index);
+int dl_list_delete_itr(dl_list list, dl_list_itr itr);
+void * dl_list_remove_itr(dl_list list, dl_list_itr itr);
+size_t dl_list_remove_if(dl_list list,
+        bool (*pfunc)(const void *, void *),
+        void (*sink)(void *, void *), void * arg);
+size_t dl_list_partition(dl_list list, dl_list dst,
+        bool (*pfunc)(const void *, void *), void * arg);
+int dl_list_splice(dl_list dst, dl_list_itr dst_itr, dl_list src,
+                   dl_list_itr first, dl_list_itr last);
 
 int dl_list_find_index(const dl_list list, const void * data);
 dl_list_itr dl_list_find_itr(const dl_list list, const void * data);
 void * dl_list_data(const dl_list list, const size_t index);
 
+void dl_list_sort(dl_list list);
+void dl_list_sort_by(dl_list list, int (*cfunc)(const void *, const void *));
+
 dl_list_itr dl_list_first(const dl_list list);
 dl_list_itr dl_list_last(const dl_list list);
 dl_list_itr dl_list_next(const dl_list_itr itr);
@@ -0,0 +1,45 @@
+/*!
+ * \file            cds_frozen_map.h
+ * \brief           User interface to frozen perfect hash map data structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_FROZEN_MAP_H
+#define PG_CDS_FROZEN_MAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cds_bst_map.h"
+
+
+/*!
+ * \brief           Typedef for frozen map pointer.
+ */
+
+typedef struct frozen_map_t * frozen_map;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+frozen_map bst_map_freeze(const bst_map map);
+void frozen_map_free(frozen_map fmap);
+
+bool frozen_map_isempty(const frozen_map fmap);
+size_t frozen_map_length(const frozen_map fmap);
+
+bool frozen_map_search(const frozen_map fmap, const char * key);
+void * frozen_map_search_data(const frozen_map fmap, const char * key);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_FROZEN_MAP_H  */
@@ -11,6 +11,8 @@
 #ifndef PG_CDS_GENERAL_H
 #define PG_CDS_GENERAL_H
 
+#include <stdint.h>
+
 
 /*  Function declarations  */
 
@@ -38,6 +40,9 @@ int cds_compare_float(const void * data, const void * cmp);
 int cds_compare_double(const void * data, const void * cmp);
 int cds_compare_string(const void * data, const void * cmp);
 
+uint64_t cds_hash_string(const char * str);
+uint64_t cds_filter_hash_string(const char * str);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,43 @@
+/*!
+ * \file            cds_intern.h
+ * \brief           User interface to string interning table.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_INTERN_H
+#define PG_CDS_INTERN_H
+
+#include <stddef.h>
+
+
+/*!
+ * \brief           Typedef for interning table pointer.
+ */
+
+typedef struct intern_table_t * intern_table;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+intern_table intern_table_init(void);
+void intern_table_free(intern_table table);
+
+const char * intern_string(intern_table table, const char * str);
+const char * intern_lookup(intern_table table, const char * str);
+
+size_t intern_table_length(intern_table table);
+size_t intern_table_bytes(intern_table table);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_INTERN_H  */
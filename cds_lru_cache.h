@@ -0,0 +1,54 @@
+/*!
+ * \file            cds_lru_cache.h
+ * \brief           User interface to least recently used cache data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_LRU_CACHE_H
+#define PG_CDS_LRU_CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for cache pointer.
+ */
+
+typedef struct lru_cache_t * lru_cache;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+lru_cache lru_cache_init(const size_t capacity,
+        void (*evict_func)(const char *, void *, void *), void * arg);
+void lru_cache_free(lru_cache cache);
+
+bool lru_cache_isempty(const lru_cache cache);
+size_t lru_cache_length(const lru_cache cache);
+size_t lru_cache_size(const lru_cache cache);
+size_t lru_cache_capacity(const lru_cache cache);
+
+bool lru_cache_put(lru_cache cache, const char * key,
+                   void * value, const size_t size);
+void * lru_cache_get(lru_cache cache, const char * key);
+void * lru_cache_peek(const lru_cache cache, const char * key);
+bool lru_cache_delete(lru_cache cache, const char * key);
+
+void lru_cache_lock(lru_cache cache);
+void lru_cache_unlock(lru_cache cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_LRU_CACHE_H  */
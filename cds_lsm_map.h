@@ -0,0 +1,49 @@
+/*!
+ * \file            cds_lsm_map.h
+ * \brief           User interface to log-structured merge map data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_LSM_MAP_H
+#define PG_CDS_LSM_MAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for log-structured merge map pointer.
+ */
+
+typedef struct lsm_map_t * lsm_map;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+lsm_map lsm_map_open(const char * dirname, const size_t memtable_size);
+int lsm_map_close(lsm_map map);
+
+int lsm_map_insert(lsm_map map, const char * key,
+                   const void * value, const size_t len);
+int lsm_map_delete(lsm_map map, const char * key);
+bool lsm_map_search(lsm_map map, const char * key);
+void * lsm_map_search_data(lsm_map map, const char * key, size_t * len);
+
+int lsm_map_flush(lsm_map map);
+int lsm_map_compact(lsm_map map);
+size_t lsm_map_num_runs(lsm_map map);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_LSM_MAP_H  */
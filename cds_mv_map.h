@@ -0,0 +1,60 @@
+/*!
+ * \file            cds_mv_map.h
+ * \brief           User interface to multiversion map data structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_MV_MAP_H
+#define PG_CDS_MV_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for multiversion map pointer.
+ */
+
+typedef struct mv_map_t * mv_map;
+
+
+/*!
+ * \brief           Typedef for multiversion map snapshot pointer.
+ */
+
+typedef struct mv_map_snapshot_t * mv_map_snapshot;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+mv_map mv_map_init(void);
+void mv_map_free(mv_map map);
+
+uint64_t mv_map_insert(mv_map map, const char * key, void * value);
+uint64_t mv_map_delete(mv_map map, const char * key);
+size_t mv_map_gc(mv_map map);
+
+mv_map_snapshot mv_map_snapshot_open(mv_map map);
+void mv_map_snapshot_close(mv_map_snapshot snapshot);
+uint64_t mv_map_snapshot_timestamp(const mv_map_snapshot snapshot);
+bool mv_map_snapshot_search(const mv_map_snapshot snapshot,
+                            const char * key);
+void * mv_map_snapshot_search_data(const mv_map_snapshot snapshot,
+                                   const char * key);
+void mv_map_snapshot_traverse(const mv_map_snapshot snapshot,
+        void (*kvfunc)(const char *, void *, void *), void * arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_MV_MAP_H  */
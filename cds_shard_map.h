@@ -0,0 +1,50 @@
+/*!
+ * \file            cds_shard_map.h
+ * \brief           User interface to sharded concurrent map data structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_SHARDED_MAP_H
+#define PG_CDS_SHARDED_MAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for sharded map pointer.
+ */
+
+typedef struct shard_map_t * shard_map;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+shard_map shard_map_init(const size_t num_shards);
+void shard_map_free(shard_map map);
+
+bool shard_map_isempty(const shard_map map);
+size_t shard_map_length(const shard_map map);
+size_t shard_map_num_shards(const shard_map map);
+
+bool shard_map_insert(shard_map map, const char * key, void * value);
+bool shard_map_delete(shard_map map, const char * key);
+bool shard_map_search(const shard_map map, const char * key);
+void * shard_map_search_data(const shard_map map, const char * key);
+
+void shard_map_traverse(shard_map map,
+        void (*kvfunc)(const char *, void *, void *), void * arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_SHARDED_MAP_H  */
@@ -45,22 +45,44 @@ extern "C" {
 
 sl_list sl_list_init(int (*cfunc)(const void *, const void *),
                      void (*free_func)(void *));
+sl_list sl_list_init_intrusive(int (*cfunc)(const void *, const void *),
+                               void (*free_func)(void *),
+                               const size_t offset);
 void sl_list_free(sl_list list);
 
 size_t sl_list_length(const sl_list list);
 bool sl_list_isempty(const sl_list list);
 
 void sl_list_prepend(sl_list list, void * data);
+void sl_list_append(sl_list list, void * data);
 int sl_list_insert_at(sl_list list, const size_t index, void * data);
 int sl_list_insert_after(sl_list list, const sl_list_itr itr, void * data);
 
+void sl_list_prepend_node(sl_list list, sl_list_node_t * node);
+void sl_list_append_node(sl_list list, sl_list_node_t * node);
+int sl_list_insert_node_after(sl_list list, const sl_list_itr itr,
+                              sl_list_node_t * node);
+
 int sl_list_delete_at(sl_list list, const size_t index);
+int sl_list_delete_after(sl_list list, const sl_list_itr itr);
+void * sl_list_remove_front(sl_list list);
+void * sl_list_remove_after(sl_list list, const sl_list_itr itr);
+size_t sl_list_remove_if(sl_list list,
+        bool (*pfunc)(const void *, void *),
+        void (*sink)(void *, void *), void * arg);
+size_t sl_list_partition(sl_list list, sl_list dst,
+        bool (*pfunc)(const void *, void *), void * arg);
+void sl_list_concat(sl_list dst, sl_list src);
 
 int sl_list_find_index(const sl_list list, const void * data);
 sl_list_itr sl_list_find_itr(const sl_list list, const void * data);
 void * sl_list_data(const sl_list list, const size_t index);
 
+void sl_list_sort(sl_list list);
+void sl_list_sort_by(sl_list list, int (*cfunc)(const void *, const void *));
+
 sl_list_itr sl_list_first(const sl_list list);
+sl_list_itr sl_list_last(const sl_list list);
 sl_list_itr sl_list_next(const sl_list_itr itr);
 sl_list_itr sl_list_itr_from_index(const sl_list list, const size_t index);
 
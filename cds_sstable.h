@@ -0,0 +1,70 @@
+/*!
+ * \file            cds_sstable.h
+ * \brief           User interface to sorted string table file data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_SSTABLE_H
+#define PG_CDS_SSTABLE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "cds_bst_map.h"
+
+
+/*!
+ * \brief           Typedef for sorted string table pointer.
+ */
+
+typedef struct sstable_t * sstable;
+
+
+/*!
+ * \brief           Typedef for sorted string table cursor pointer.
+ */
+
+typedef struct sstable_cursor_t * sstable_cursor;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int bst_map_write_sstable(const bst_map map, const char * filename,
+        const void * (*vfunc)(const void *, size_t *));
+
+sstable sstable_open(const char * filename);
+void sstable_close(sstable table);
+
+bool sstable_isempty(const sstable table);
+size_t sstable_length(const sstable table);
+
+bool sstable_search(const sstable table, const char * key);
+const void * sstable_search_data(const sstable table,
+                                 const char * key, size_t * len);
+
+void sstable_prefix_traverse(const sstable table, const char * prefix,
+        void (*kvfunc)(const char *, const void *, size_t, void *),
+        void * arg);
+void sstable_range_traverse(const sstable table,
+        const char * first, const char * last,
+        void (*kvfunc)(const char *, const void *, size_t, void *),
+        void * arg);
+
+sstable_cursor sstable_cursor_seek(const sstable table, const char * key);
+bool sstable_cursor_next(sstable_cursor cursor, const char ** key,
+                         const void ** value, size_t * len);
+void sstable_cursor_free(sstable_cursor cursor);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_SSTABLE_H  */
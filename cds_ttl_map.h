@@ -0,0 +1,52 @@
+/*!
+ * \file            cds_ttl_map.h
+ * \brief           User interface to expiring map data structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_TTL_MAP_H
+#define PG_CDS_TTL_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Typedef for expiring map pointer.
+ */
+
+typedef struct ttl_map_t * ttl_map;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ttl_map ttl_map_init(uint64_t (*clock_func)(void));
+void ttl_map_free(ttl_map map);
+
+bool ttl_map_isempty(const ttl_map map);
+size_t ttl_map_length(const ttl_map map);
+
+bool ttl_map_insert(ttl_map map, const char * key,
+                    void * value, const uint64_t ttl);
+bool ttl_map_delete(ttl_map map, const char * key);
+bool ttl_map_search(const ttl_map map, const char * key);
+void * ttl_map_search_data(const ttl_map map, const char * key);
+size_t ttl_map_reap(ttl_map map);
+
+void ttl_map_lock(ttl_map map);
+void ttl_map_unlock(ttl_map map);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_TTL_MAP_H  */
@@ -0,0 +1,99 @@
+/*!
+ * \file            cds_ul_list.h
+ * \brief           User interface to unrolled linked list data structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_UNROLLED_LINKED_LIST_H
+#define PG_CDS_UNROLLED_LINKED_LIST_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/*!
+ * \brief           Number of elements held by an unrolled list node.
+ * \details         Chosen so that a node on a 64-bit system fills two
+ * 64-byte cache lines.
+ */
+
+#define UL_LIST_NODE_CAPACITY 13
+
+
+/*!
+ * \brief           Struct for unrolled linked list node.
+ */
+
+typedef struct ul_list_node_t {
+    struct ul_list_node_t * next;   /*!< Pointer to next node */
+    struct ul_list_node_t * prev;   /*!< Pointer to previous node */
+    size_t count;                   /*!< Number of elements in node */
+    void * data[UL_LIST_NODE_CAPACITY];     /*!< Pointers to data */
+} ul_list_node_t;
+
+
+/*!
+ * \brief           Typedef for list pointer.
+ */
+
+typedef struct ul_list_t * ul_list;
+
+
+/*!
+ * \brief           Typedef for list iterator.
+ * \details         An iterator is passed by value, and refers to an
+ * element by its node and its position in the node. An iterator whose
+ * node is `NULL` refers to no element.
+ */
+
+typedef struct ul_list_itr_t {
+    struct ul_list_node_t * node;   /*!< Pointer to node */
+    size_t slot;                    /*!< Position in node */
+} ul_list_itr;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ul_list ul_list_init(int (*cfunc)(const void *, const void *),
+                     void (*free_func)(void *));
+void ul_list_free(ul_list list);
+
+size_t ul_list_length(const ul_list list);
+bool ul_list_isempty(const ul_list list);
+
+void ul_list_prepend(ul_list list, void * data);
+void ul_list_append(ul_list list, void * data);
+int ul_list_insert_before(ul_list list, const ul_list_itr itr, void * data);
+int ul_list_insert_at(ul_list list, const size_t index, void * data);
+int ul_list_insert_after(ul_list list, const ul_list_itr itr, void * data);
+
+int ul_list_delete_at(ul_list list, const size_t index);
+
+int ul_list_find_index(const ul_list list, const void * data);
+ul_list_itr ul_list_find_itr(const ul_list list, const void * data);
+void * ul_list_data(const ul_list list, const size_t index);
+
+ul_list_itr ul_list_first(const ul_list list);
+ul_list_itr ul_list_last(const ul_list list);
+ul_list_itr ul_list_next(const ul_list_itr itr);
+ul_list_itr ul_list_prev(const ul_list_itr itr);
+ul_list_itr ul_list_itr_from_index(const ul_list list, const size_t index);
+bool ul_list_itr_valid(const ul_list_itr itr);
+void * ul_list_itr_data(const ul_list_itr itr);
+
+void ul_list_lock(ul_list list);
+void ul_list_unlock(ul_list list);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_UNROLLED_LINKED_LIST_H  */
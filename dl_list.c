@@ -1,6 +1,34 @@
 /*!
  * \file            dl_list.c
  * \brief           Implementation of doubly linked list data structure.
+ * \details         Every list holds a head node, whose `next` and `prev`
+ * members point to the first and last nodes. The links past either end
+ * of the list hold the list's `end` pointer, which is NULL by default, so
+ * that callers may walk the nodes' own links until NULL. A circular list
+ * instead links its nodes in a ring through the head, which then serves
+ * as a sentinel: `end` points to the head and every node has both
+ * neighbours. Both kinds share the same code, which reaches the head
+ * through holder() wherever a neighbour may be missing, so linking and
+ * unlinking test for a missing neighbour in a circular list too, although
+ * the test never succeeds there. The head is recognised by its data
+ * pointer, so that the iterator functions return NULL at the ends of a
+ * circular list too.
+ *
+ * An indexed list also keeps a skip list over its nodes.
+ * Each level of the skip list links a sparser subset of the nodes than the
+ * level below, with the list itself as the bottom level, and each link
+ * records its span, the number of positions it skips. Positional lookup,
+ * insertion and deletion descend the levels summing spans, and so take
+ * O(log n) expected time instead of O(n).
+ *
+ * Only positional operations maintain the skip list. Any other change to
+ * the nodes, e.g. inserting after an iterator, sorting or splicing, marks
+ * it stale, and the next positional operation rebuilds it in O(n) time.
+ *
+ * Every list also remembers the last node it found by index, and finds
+ * the next index by walking from whichever of that node, the front and
+ * the back is closest, so a loop visiting indices in order takes O(n)
+ * time overall rather than O(n^2).
  * \author          Paul Griffiths
  * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
  * of the GNU General Public License. <http://www.gnu.org/licenses/>
@@ -10,6 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <paulgrif/chelpers.h>
 #include "cds_common.h"
 #include "dl_list.h"
@@ -20,6 +49,531 @@
 #endif
 
 
+/*!
+ * \brief           Data of every head node.
+ * \details         Only its address is used, to recognise heads.
+ */
+
+static char sentinel_data;
+
+
+/*!
+ * \brief           Returns the node holding a link to be updated.
+ * \details         A NULL neighbour stands for the end of a list which is
+ * not circular, and the links to the first and last nodes are then held
+ * by the head. The neighbours in a circular list are never NULL, so this
+ * always returns `node` for one.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the neighbour, or NULL.
+ * \returns         `node`, or the list's head if `node` is NULL.
+ */
+
+static dl_list_node holder(dl_list list, dl_list_node node) {
+    return node ? node : &list->head;
+}
+
+
+/*!
+ * \brief           Links a node in between two adjacent nodes.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, which must not be in a list.
+ * \param prev      A pointer to the node to link it after, or the list's
+ * `end` pointer to link it at the front.
+ * \param next      A pointer to the node to link it before, which must
+ * follow `prev`, or the list's `end` pointer to link it at the back.
+ */
+
+static void link_node(dl_list list, dl_list_node node,
+                      dl_list_node prev, dl_list_node next) {
+    node->prev = prev;
+    node->next = next;
+    holder(list, prev)->next = node;
+    holder(list, next)->prev = node;
+}
+
+
+/*!
+ * \brief           Unlinks a node from between its neighbours.
+ * \details         The node's links are cleared.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ */
+
+static void unlink_node(dl_list list, dl_list_node node) {
+    holder(list, node->prev)->next = node->next;
+    holder(list, node->next)->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+
+/*!
+ * \brief           Free function for intrusive lists given none.
+ * \param data      A pointer to the container, which is left alone.
+ */
+
+static void free_nothing(void * data) {
+    (void) data;
+}
+
+
+/*!
+ * \brief           Creates a node for data to be inserted in a list.
+ * \details         Intrusive lists take caller-provided nodes only, so
+ * inserting data into one is a fatal error.
+ * \param list      A pointer to the list.
+ * \param data      The data for the new node.
+ * \returns         A pointer to the newly created node.
+ */
+
+static dl_list_node data_node(dl_list list, void * data) {
+    if ( list->intrusive ) {
+        fputs("cdatastruct error: data inserted into intrusive list",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    return dl_list_new_node(data);
+}
+
+
+/*!
+ * \brief           Prepares a caller-provided node for insertion.
+ * \details         The node's data is set to its container. Only
+ * intrusive lists take caller-provided nodes, so passing one to any
+ * other list is a fatal error.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ * \returns         `node`.
+ */
+
+static dl_list_node adopt_node(dl_list list, dl_list_node node) {
+    if ( !list->intrusive ) {
+        fputs("cdatastruct error: node inserted into non-intrusive list",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    node->data = (char *) node - list->offset;
+    node->next = NULL;
+    node->prev = NULL;
+    return node;
+}
+
+
+/*!
+ * \brief           Releases a node that has been removed from a list.
+ * \details         Nodes of an intrusive list belong to their containers,
+ * so are left alone.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ */
+
+static void release_node(dl_list list, dl_list_node node) {
+    if ( !list->intrusive ) {
+        free(node);
+    }
+}
+
+
+/*!
+ * \brief           Maximum number of skip list levels above the list.
+ * \details         A node reaches each level with probability 1/4, so
+ * this suffices for lists of around four billion elements.
+ */
+
+#define INDEX_MAX_LEVELS 16
+
+
+/*!
+ * \brief           Distance beyond which an indexed list uses its skip
+ * list rather than walking to a position.
+ */
+
+#define INDEX_WALK_LIMIT 16
+
+
+/*!
+ * \brief           Struct for one level of a skip list tower.
+ */
+
+typedef struct dl_index_link_t {
+    struct dl_index_tower_t * next;     /*!< Pointer to next tower */
+    size_t span;                        /*!< Positions to next tower */
+} dl_index_link_t;
+
+
+/*!
+ * \brief           Struct for a skip list tower.
+ * \details         A tower stands on a list node and links it into one
+ * or more levels of the skip list. The head tower stands before the first
+ * node and has every level. The span of the last link on each level runs
+ * to the position one past the end of the list.
+ */
+
+typedef struct dl_index_tower_t {
+    dl_list_node node;                  /*!< Node, or NULL for the head */
+    dl_index_link_t links[];            /*!< Links, lowest level first */
+} dl_index_tower_t;
+
+
+/*!
+ * \brief           Struct to contain a list index.
+ */
+
+typedef struct dl_list_index_t {
+    dl_index_tower_t * head;            /*!< Pointer to head tower */
+    bool valid;                         /*!< `false` if index is stale */
+    uint64_t seed;                      /*!< Random tower height state */
+} dl_list_index_t;
+
+
+/*!
+ * \brief           Creates a new skip list tower.
+ * \param node      A pointer to the node the tower stands on.
+ * \param height    The number of levels in the tower.
+ * \returns         A pointer to the new tower.
+ */
+
+static dl_index_tower_t * new_tower(dl_list_node node, const size_t height) {
+    dl_index_tower_t * tower = term_malloc(sizeof(*tower) +
+                                           sizeof(*tower->links) * height);
+    tower->node = node;
+    return tower;
+}
+
+
+/*!
+ * \brief           Frees every tower in an index except the head.
+ * \param index     A pointer to the index.
+ */
+
+static void free_towers(dl_list_index_t * index) {
+    dl_index_tower_t * tower = index->head->links[0].next;
+
+    while ( tower ) {
+        dl_index_tower_t * next = tower->links[0].next;
+        free(tower);
+        tower = next;
+    }
+}
+
+
+/*!
+ * \brief           Chooses a height for a new tower.
+ * \details         Each level is reached with probability 1/4, using
+ * successive pairs of bits from an xorshift generator.
+ * \param index     A pointer to the index.
+ * \returns         The height, which is zero for a node which should get
+ * no tower.
+ */
+
+static size_t random_height(dl_list_index_t * index) {
+    uint64_t x = index->seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    index->seed = x;
+
+    size_t height = 0;
+    while ( height < INDEX_MAX_LEVELS && (x & 3) == 0 ) {
+        ++height;
+        x >>= 2;
+    }
+
+    return height;
+}
+
+
+/*!
+ * \brief           Marks a list's index as stale, if it has one.
+ * \param list      A pointer to the list.
+ */
+
+static void invalidate_index(dl_list list) {
+    if ( list->index ) {
+        list->index->valid = false;
+    }
+}
+
+
+/*!
+ * \brief           Forgets every node position a list has recorded.
+ * \details         This must be called whenever nodes are inserted or
+ * removed anywhere but the back of the list, or are reordered.
+ * \param list      A pointer to the list.
+ */
+
+static void invalidate_positions(dl_list list) {
+    list->cache_node = NULL;
+    invalidate_index(list);
+}
+
+
+/*!
+ * \brief           Rebuilds a list's index from its nodes, if stale.
+ * \param list      A pointer to the list, which must have an index.
+ */
+
+static void validate_index(dl_list list) {
+    dl_list_index_t * index = list->index;
+    if ( index->valid ) {
+        return;
+    }
+
+    free_towers(index);
+
+    dl_index_tower_t * last[INDEX_MAX_LEVELS];
+    size_t last_rank[INDEX_MAX_LEVELS];
+    for ( size_t l = 0; l < INDEX_MAX_LEVELS; ++l ) {
+        last[l] = index->head;
+        last_rank[l] = 0;
+    }
+
+    size_t rank = 0;
+    for ( dl_list_node node = list->head.next; node != list->end;
+          node = node->next ) {
+        const size_t height = random_height(index);
+        ++rank;
+
+        if ( height ) {
+            dl_index_tower_t * tower = new_tower(node, height);
+            for ( size_t l = 0; l < height; ++l ) {
+                last[l]->links[l].next = tower;
+                last[l]->links[l].span = rank - last_rank[l];
+                last[l] = tower;
+                last_rank[l] = rank;
+            }
+        }
+    }
+
+    for ( size_t l = 0; l < INDEX_MAX_LEVELS; ++l ) {
+        last[l]->links[l].next = NULL;
+        last[l]->links[l].span = list->length + 1 - last_rank[l];
+    }
+
+    index->valid = true;
+}
+
+
+/*!
+ * \brief           Descends a list's index towards a position.
+ * \details         Positions are counted from 1 for the first node, with
+ * the head tower at position 0.
+ * \param list      A pointer to the list, which must have a valid index.
+ * \param target    The position to descend towards.
+ * \param update    An array to populate with the last tower at or before
+ * `target` on each level.
+ * \param ranks     An array to populate with the positions of the towers
+ * in `update`.
+ */
+
+static void search_index(dl_list list, const size_t target,
+                         dl_index_tower_t ** update, size_t * ranks) {
+    dl_index_tower_t * tower = list->index->head;
+    size_t rank = 0;
+
+    for ( size_t l = INDEX_MAX_LEVELS; l-- > 0; ) {
+        while ( tower->links[l].next &&
+                rank + tower->links[l].span <= target ) {
+            rank += tower->links[l].span;
+            tower = tower->links[l].next;
+        }
+        update[l] = tower;
+        ranks[l] = rank;
+    }
+}
+
+
+/*!
+ * \brief           Walks the list from a tower to a position.
+ * \details         The head tower stands on the list's head node.
+ * \param list      A pointer to the list.
+ * \param tower     A pointer to the tower.
+ * \param rank      The position of the tower.
+ * \param target    The position to walk to, which must be at least 1,
+ * and no less than `rank`.
+ * \returns         A pointer to the node at `target`.
+ */
+
+static dl_list_node walk_from_tower(dl_list list, dl_index_tower_t * tower,
+                                    size_t rank, const size_t target) {
+    dl_list_node node = tower->node ? tower->node : &list->head;
+
+    while ( rank < target ) {
+        node = node->next;
+        ++rank;
+    }
+
+    return node;
+}
+
+
+/*!
+ * \brief           Inserts a node at an index of an indexed list.
+ * \param list      A pointer to the list, which must have an index.
+ * \param index     The index at which to insert, which must not exceed
+ * the length of the list.
+ * \param node      A pointer to the node to insert.
+ */
+
+static void index_insert_node(dl_list list, const size_t index,
+                              dl_list_node node) {
+    dl_index_tower_t * update[INDEX_MAX_LEVELS];
+    size_t ranks[INDEX_MAX_LEVELS];
+
+    validate_index(list);
+    search_index(list, index, update, ranks);
+
+    if ( index == 0 ) {
+        dl_list_insert_node_front(list, node);
+    } else if ( index == list->length ) {
+        dl_list_insert_node_back(list, node);
+    } else {
+        dl_list_insert_node_after_mid(list,
+                walk_from_tower(list, update[0], ranks[0], index), node);
+    }
+
+    /*  Link a tower for the new node into its levels, and widen the
+     *  links passing over it on the levels above                     */
+
+    const size_t rank = index + 1;
+    const size_t height = random_height(list->index);
+    dl_index_tower_t * tower = height ? new_tower(node, height) : NULL;
+
+    for ( size_t l = 0; l < INDEX_MAX_LEVELS; ++l ) {
+        dl_index_link_t * link = &update[l]->links[l];
+        if ( l < height ) {
+            tower->links[l].next = link->next;
+            tower->links[l].span = ranks[l] + link->span + 1 - rank;
+            link->next = tower;
+            link->span = rank - ranks[l];
+        } else {
+            ++link->span;
+        }
+    }
+
+    list->index->valid = true;
+}
+
+
+/*!
+ * \brief           Removes the node at an index of an indexed list.
+ * \param list      A pointer to the list, which must have an index.
+ * \param index     The index of the node, which must be in range.
+ * \returns         A pointer to the removed node.
+ */
+
+static dl_list_node index_remove_node(dl_list list, const size_t index) {
+    dl_index_tower_t * update[INDEX_MAX_LEVELS];
+    size_t ranks[INDEX_MAX_LEVELS];
+
+    validate_index(list);
+    search_index(list, index, update, ranks);
+
+    const size_t rank = index + 1;
+    dl_list_node node = walk_from_tower(list, update[0], ranks[0], rank);
+
+    /*  Unlink the node's tower, if it has one, and narrow the links
+     *  passing over it on the levels above                          */
+
+    dl_index_tower_t * tower = update[0]->links[0].next;
+    if ( tower == NULL || ranks[0] + update[0]->links[0].span != rank ) {
+        tower = NULL;
+    }
+
+    for ( size_t l = 0; l < INDEX_MAX_LEVELS; ++l ) {
+        dl_index_link_t * link = &update[l]->links[l];
+        if ( tower && link->next == tower ) {
+            link->span += tower->links[l].span - 1;
+            link->next = tower->links[l].next;
+        } else {
+            --link->span;
+        }
+    }
+    free(tower);
+
+    dl_list_remove_node(list, node);
+    list->index->valid = true;
+    return node;
+}
+
+
+/*!
+ * \brief           Merge sorts a chain of nodes.
+ * \details         Runs of length 1, 2, 4, ... are merged pairwise in
+ * successive passes over the chain, which needs no recursion and no
+ * extra memory. A node from the left run is taken first when the two
+ * compare equal, so the sort is stable.
+ * \param front     A pointer to the first node of the chain.
+ * \param cfunc     A pointer to the compare function.
+ * \param p_back    A pointer to populate with the last node of the
+ * sorted chain.
+ * \returns         A pointer to the first node of the sorted chain.
+ */
+
+static dl_list_node merge_sort_nodes(dl_list_node front,
+        int (*cfunc)(const void *, const void *), dl_list_node * p_back) {
+    size_t run = 1;
+
+    while ( true ) {
+        dl_list_node p = front;
+        dl_list_node tail = NULL;
+        size_t merges = 0;
+        front = NULL;
+
+        while ( p ) {
+            ++merges;
+
+            /*  Find the second run of the pair  */
+
+            dl_list_node q = p;
+            size_t p_size = 0;
+            while ( p_size < run && q ) {
+                ++p_size;
+                q = q->next;
+            }
+            size_t q_size = run;
+
+            while ( p_size > 0 || (q_size > 0 && q) ) {
+                dl_list_node e;
+                if ( p_size == 0 ) {
+                    e = q;
+                    q = q->next;
+                    --q_size;
+                } else if ( q_size == 0 || q == NULL ||
+                            cfunc(p->data, q->data) <= 0 ) {
+                    e = p;
+                    p = p->next;
+                    --p_size;
+                } else {
+                    e = q;
+                    q = q->next;
+                    --q_size;
+                }
+
+                if ( tail ) {
+                    tail->next = e;
+                } else {
+                    front = e;
+                }
+                e->prev = tail;
+                tail = e;
+            }
+
+            p = q;
+        }
+
+        tail->next = NULL;
+        if ( merges <= 1 ) {
+            *p_back = tail;
+            return front;
+        }
+        run *= 2;
+    }
+}
+
+
 /*!
  * \brief           Initializes a new doubly linked list.
  * \param cfunc     A pointer to a compare function. The function should
@@ -37,10 +591,17 @@ dl_list dl_list_init(int (*cfunc)(const void *, const void *),
                      void (*free_func)(void *)) {
     dl_list new_list = term_malloc(sizeof(*new_list));
 
-    new_list->front = NULL;
-    new_list->back = NULL;
+    new_list->head.data = &sentinel_data;
+    new_list->head.next = NULL;
+    new_list->head.prev = NULL;
+    new_list->end = NULL;
     new_list->length = 0;
     new_list->cfunc = cfunc;
+    new_list->index = NULL;
+    new_list->cache_node = NULL;
+    new_list->cache_index = 0;
+    new_list->intrusive = false;
+    new_list->offset = 0;
 
     if ( free_func) {
         new_list->free_func = free_func;
@@ -60,13 +621,111 @@ dl_list dl_list_init(int (*cfunc)(const void *, const void *),
 }
 
 
+/*!
+ * \brief           Initializes a new circular doubly linked list.
+ * \details         A circular list links its nodes in a ring through a
+ * sentinel node, so no node is ever missing a neighbour, and the test for
+ * one made on every link and unlink always fails and is well predicted.
+ * It is meant for lists pushed and popped at their ends at high rates,
+ * such as queues. Its public API is the same as
+ * any other list's, and dl_list_first(), dl_list_last(), dl_list_next()
+ * and dl_list_prev() still return NULL at the ends, but the `next` and
+ * `prev` members of the nodes at the ends point to the sentinel rather
+ * than being NULL.
+ * \param cfunc     A pointer to a compare function, as for dl_list_init().
+ * \param free_func A pointer to a function to free a node, as for
+ * dl_list_init().
+ * \returns         A pointer to the new list.
+ */
+
+dl_list dl_list_init_circular(int (*cfunc)(const void *, const void *),
+                              void (*free_func)(void *)) {
+    dl_list new_list = dl_list_init(cfunc, free_func);
+    new_list->head.next = &new_list->head;
+    new_list->head.prev = &new_list->head;
+    new_list->end = &new_list->head;
+    return new_list;
+}
+
+
+/*!
+ * \brief           Initializes a new indexed doubly linked list.
+ * \details         An indexed list keeps a skip list over its nodes, so
+ * that dl_list_itr_from_index(), dl_list_data(), dl_list_insert_at(),
+ * dl_list_delete_at(), dl_list_prepend() and dl_list_append() take
+ * O(log n) expected time, at the cost of around a third more memory per
+ * element. Other operations which change the list, e.g. inserting or
+ * deleting through an iterator, sorting and splicing, leave the skip list
+ * to be rebuilt in O(n) time by the next positional operation, so they
+ * are best batched rather than interleaved with positional operations.
+ * \param cfunc     A pointer to a compare function, as for dl_list_init().
+ * \param free_func A pointer to a function to free a node, as for
+ * dl_list_init().
+ * \returns         A pointer to the new list.
+ */
+
+dl_list dl_list_init_indexed(int (*cfunc)(const void *, const void *),
+                             void (*free_func)(void *)) {
+    dl_list new_list = dl_list_init(cfunc, free_func);
+
+    dl_list_index_t * index = term_malloc(sizeof(*index));
+    index->head = new_tower(NULL, INDEX_MAX_LEVELS);
+    for ( size_t l = 0; l < INDEX_MAX_LEVELS; ++l ) {
+        index->head->links[l].next = NULL;
+        index->head->links[l].span = 1;
+    }
+    index->valid = true;
+    index->seed = UINT64_C(0x9e3779b97f4a7c15);
+
+    new_list->index = index;
+    return new_list;
+}
+
+
+/*!
+ * \brief           Initializes a new intrusive doubly linked list.
+ * \details         An intrusive list links nodes embedded in the elements
+ * themselves, so inserting an element allocates nothing. Elements are
+ * inserted with dl_list_prepend_node(), dl_list_append_node(),
+ * dl_list_insert_node_before() and dl_list_insert_node_after(), and the
+ * data of each node, as passed to the compare and free functions and
+ * returned by dl_list_remove_itr(), is the element containing it. Use
+ * `cds_container_of()` to get from a node to its element.
+ * \param cfunc     A pointer to a compare function, as for dl_list_init().
+ * \param free_func A pointer to a function for freeing an element when
+ * it is deleted from the list. If `NULL` is specified, elements are left
+ * alone, which suits elements the caller frees, or that are not
+ * dynamically allocated.
+ * \param offset    The offset of the node within each element, as given
+ * by `offsetof()`.
+ * \returns         A pointer to the new list.
+ */
+
+dl_list dl_list_init_intrusive(int (*cfunc)(const void *, const void *),
+                               void (*free_func)(void *),
+                               const size_t offset) {
+    dl_list new_list = dl_list_init(cfunc,
+                                    free_func ? free_func : free_nothing);
+    new_list->intrusive = true;
+    new_list->offset = offset;
+    return new_list;
+}
+
+
 /*!
  * \brief           Frees the resources associated with a list.
  * \param list      A pointer to the list to free.
  */
 
 void dl_list_free(dl_list list) {
-    while ( list->front ) {
+    if ( list->index ) {
+        free_towers(list->index);
+        free(list->index->head);
+        free(list->index);
+        list->index = NULL;
+    }
+
+    while ( list->length ) {
         dl_list_delete_at(list, 0);
     }
 
@@ -98,7 +757,7 @@ size_t dl_list_length(const dl_list list) {
  */
 
 bool dl_list_isempty(const dl_list list) {
-    return (list->front) ? false : true;
+    return list->head.next == list->end;
 }
 
 
@@ -124,10 +783,10 @@ void dl_list_prepend(dl_list list, void * data) {
  */
 
 void dl_list_append(dl_list list, void * data) {
-    if ( list->back ) {
-        dl_list_insert_after(list, list->back, data);
+    if ( list->index ) {
+        dl_list_insert_at(list, list->length, data);
     } else {
-        dl_list_insert_at(list, 0, data);
+        dl_list_insert_node_back(list, data_node(list, data));
     }
 }
 
@@ -148,12 +807,7 @@ int dl_list_insert_before(dl_list list, const dl_list_itr itr, void * data) {
         return CDSERR_BADITERATOR;
     }
 
-    dl_list_node new_node = dl_list_new_node(data);
-    if ( itr->prev ) {
-        dl_list_insert_node_before_mid(list, itr, new_node);
-    } else {
-        dl_list_insert_node_front(list, new_node);
-    }
+    dl_list_insert_node_before_mid(list, itr, data_node(list, data));
 
     return 0;
 }
@@ -177,9 +831,11 @@ int dl_list_insert_at(dl_list list, const size_t index, void * data) {
         return CDSERR_OUTOFRANGE;
     }
 
-    dl_list_node new_node = dl_list_new_node(data);
+    dl_list_node new_node = data_node(list, data);
 
-    if ( index == 0 ) {
+    if ( list->index ) {
+        index_insert_node(list, index, new_node);
+    } else if ( index == 0 ) {
         dl_list_insert_node_front(list, new_node);
     } else if ( index == list->length ) {
         dl_list_insert_node_back(list, new_node);
@@ -220,13 +876,78 @@ int dl_list_insert_after(dl_list list, const dl_list_itr itr, void * data) {
         return CDSERR_BADITERATOR;
     }
 
-    dl_list_node new_node = dl_list_new_node(data);
-    if ( itr->next ) {
-        dl_list_insert_node_after_mid(list, itr, new_node);
-    } else {
-        dl_list_insert_node_back(list, new_node);
+    dl_list_insert_node_after_mid(list, itr, data_node(list, data));
+
+    return 0;
+}
+
+
+/*!
+ * \brief           Inserts a node at the beginning of an intrusive list.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ */
+
+void dl_list_prepend_node(dl_list list, dl_list_node_t * node) {
+    dl_list_insert_node_front(list, adopt_node(list, node));
+}
+
+
+/*!
+ * \brief           Inserts a node at the end of an intrusive list.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ */
+
+void dl_list_append_node(dl_list list, dl_list_node_t * node) {
+    dl_list_insert_node_back(list, adopt_node(list, node));
+}
+
+
+/*!
+ * \brief           Inserts a node into an intrusive list before a
+ * provided iterator.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator before which to insert.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` is a
+ * NULL pointer.
+ */
+
+int dl_list_insert_node_before(dl_list list, const dl_list_itr itr,
+                               dl_list_node_t * node) {
+    if ( itr == NULL ) {
+        return CDSERR_BADITERATOR;
     }
 
+    dl_list_insert_node_before_mid(list, itr, adopt_node(list, node));
+
+    return 0;
+}
+
+
+/*!
+ * \brief           Inserts a node into an intrusive list after a
+ * provided iterator.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to insert.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` is a
+ * NULL pointer.
+ */
+
+int dl_list_insert_node_after(dl_list list, const dl_list_itr itr,
+                              dl_list_node_t * node) {
+    if ( itr == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
+
+    dl_list_insert_node_after_mid(list, itr, adopt_node(list, node));
+
     return 0;
 }
 
@@ -251,6 +972,191 @@ int dl_list_delete_at(dl_list list, const size_t index) {
 }
 
 
+/*!
+ * \brief           Deletes the list element referred to by an iterator.
+ * \details         This takes constant time. The iterator is invalidated,
+ * so a loop deleting elements should advance past it first.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator to the element to delete.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` is a
+ * NULL pointer.
+ */
+
+int dl_list_delete_itr(dl_list list, dl_list_itr itr) {
+    if ( itr == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
+
+    dl_list_free_node(list, dl_list_remove_node(list, itr));
+    return 0;
+}
+
+
+/*!
+ * \brief           Removes, but does not delete, the list element
+ * referred to by an iterator.
+ * \details         This takes constant time. The iterator is invalidated.
+ * On an intrusive list the element's node is left alone, so this is how
+ * to take an element back out of one.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator to the element to remove.
+ * \returns         A pointer to the element's data, which is no longer
+ * owned by the list, or NULL if `itr` is a NULL pointer.
+ */
+
+void * dl_list_remove_itr(dl_list list, dl_list_itr itr) {
+    if ( itr == NULL ) {
+        return NULL;
+    }
+
+    dl_list_node rm_node = dl_list_remove_node(list, itr);
+    void * data = rm_node->data;
+    release_node(list, rm_node);
+    return data;
+}
+
+
+/*!
+ * \brief           Removes every list element matching a predicate.
+ * \details         The list is walked once, so this takes linear time
+ * however many elements match.
+ * \param list      A pointer to the list.
+ * \param pfunc     A pointer to the predicate, which is passed each
+ * element's data and `arg`, and should return `true` if the element is to
+ * be removed.
+ * \param sink      A pointer to a function to which each removed
+ * element's data is passed, along with `arg`, and which becomes
+ * responsible for it. If this is NULL, the data is freed with the list's
+ * free function.
+ * \param arg       A pointer to the argument to pass to `pfunc()` and
+ * `sink()`.
+ * \returns         The number of elements removed.
+ */
+
+size_t dl_list_remove_if(dl_list list,
+        bool (*pfunc)(const void *, void *),
+        void (*sink)(void *, void *), void * arg) {
+    dl_list_node node = list->head.next;
+    size_t count = 0;
+
+    while ( node != list->end ) {
+        dl_list_node next = node->next;
+
+        if ( pfunc(node->data, arg) ) {
+            dl_list_remove_node(list, node);
+            if ( sink ) {
+                sink(node->data, arg);
+                release_node(list, node);
+            } else {
+                dl_list_free_node(list, node);
+            }
+            ++count;
+        }
+
+        node = next;
+    }
+
+    return count;
+}
+
+
+/*!
+ * \brief           Moves every list element matching a predicate to the
+ * end of another list.
+ * \details         The list is walked once, and the matching nodes are
+ * relinked into the other list in their original order, without being
+ * reallocated.
+ * \param list      A pointer to the list.
+ * \param dst       A pointer to the list to receive the matching elements,
+ * which must be a different list, and intrusive with the same offset if
+ * and only if `list` is.
+ * \param pfunc     A pointer to the predicate, which is passed each
+ * element's data and `arg`, and should return `true` if the element is to
+ * be moved.
+ * \param arg       A pointer to the argument to pass to `pfunc()`.
+ * \returns         The number of elements moved.
+ */
+
+size_t dl_list_partition(dl_list list, dl_list dst,
+        bool (*pfunc)(const void *, void *), void * arg) {
+    dl_list_node node = list->head.next;
+    size_t count = 0;
+
+    while ( node != list->end ) {
+        dl_list_node next = node->next;
+
+        if ( pfunc(node->data, arg) ) {
+            dl_list_insert_node_back(dst, dl_list_remove_node(list, node));
+            ++count;
+        }
+
+        node = next;
+    }
+
+    return count;
+}
+
+
+/*!
+ * \brief           Moves a range of elements from one list to another.
+ * \details         The nodes are relinked rather than reallocated, so this
+ * takes constant time apart from counting the range to keep both lengths
+ * correct. That count is skipped when the range is the whole of `src`, or
+ * when `dst` and `src` are the same list.
+ * \param dst       A pointer to the list to receive the elements.
+ * \param dst_itr   An iterator to the element of `dst` before which to
+ * insert the range, or NULL to append it. If `dst` and `src` are the same
+ * list, this must not be within the range.
+ * \param src       A pointer to the list to take the elements from, which
+ * must be intrusive with the same offset if and only if `dst` is.
+ * \param first     An iterator to the first element of the range.
+ * \param last      An iterator to the last element of the range, which
+ * must be `first` or follow it in `src`.
+ * \returns         0 on success, CDSERR_BADITERATOR if `first` or `last`
+ * is a NULL pointer.
+ */
+
+int dl_list_splice(dl_list dst, dl_list_itr dst_itr, dl_list src,
+                   dl_list_itr first, dl_list_itr last) {
+    if ( first == NULL || last == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
+
+    /*  Count the range while it is still linked into src  */
+
+    size_t count = 0;
+    if ( dst != src ) {
+        if ( first == src->head.next && last == src->head.prev ) {
+            count = src->length;
+        } else {
+            for ( dl_list_node node = first; node != last;
+                  node = node->next ) {
+                ++count;
+            }
+            ++count;
+        }
+    }
+
+    /*  Unlink the range from src, and link it into dst  */
+
+    holder(src, first->prev)->next = last->next;
+    holder(src, last->next)->prev = first->prev;
+    src->length -= count;
+
+    dl_list_node next = dst_itr ? dst_itr : dst->end;
+    dl_list_node prev = dst_itr ? dst_itr->prev : dst->head.prev;
+    first->prev = prev;
+    last->next = next;
+    holder(dst, prev)->next = first;
+    holder(dst, next)->prev = last;
+
+    dst->length += count;
+    invalidate_positions(src);
+    invalidate_positions(dst);
+    return 0;
+}
+
+
 /*!
  * \brief           Finds the index of the specified data in a list.
  * \param list      A pointer to the list.
@@ -295,6 +1201,46 @@ void * dl_list_data(const dl_list list, const size_t index) {
 }
 
 
+/*!
+ * \brief           Sorts a list using its compare function.
+ * \details         The sort is a stable merge sort which relinks the
+ * existing nodes, in O(n log n) time and O(1) extra memory. Iterators
+ * remain valid and refer to the same elements.
+ * \param list      A pointer to the list.
+ */
+
+void dl_list_sort(dl_list list) {
+    dl_list_sort_by(list, list->cfunc);
+}
+
+
+/*!
+ * \brief           Sorts a list using a supplied compare function.
+ * \details         The sort is a stable merge sort which relinks the
+ * existing nodes, in O(n log n) time and O(1) extra memory. Iterators
+ * remain valid and refer to the same elements.
+ * \param list      A pointer to the list.
+ * \param cfunc     A pointer to a compare function, which is passed
+ * pointers to the data of two elements, and should return less than
+ * zero, zero or greater than zero if the first sorts before, with or
+ * after the second.
+ */
+
+void dl_list_sort_by(dl_list list, int (*cfunc)(const void *, const void *)) {
+    if ( list->length > 1 ) {
+        dl_list_node back;
+        list->head.prev->next = NULL;
+        dl_list_node front = merge_sort_nodes(list->head.next, cfunc, &back);
+
+        list->head.next = front;
+        list->head.prev = back;
+        front->prev = list->end;
+        back->next = list->end;
+        invalidate_positions(list);
+    }
+}
+
+
 /*!
  * \brief           Returns an iterator to the first element of a list.
  * \param list      A pointer to the list.
@@ -302,7 +1248,7 @@ void * dl_list_data(const dl_list list, const size_t index) {
  */
 
 dl_list_itr dl_list_first(const dl_list list) {
-    return list->front;
+    return dl_list_next(&list->head);
 }
 
 
@@ -313,7 +1259,7 @@ dl_list_itr dl_list_first(const dl_list list) {
  */
 
 dl_list_itr dl_list_last(const dl_list list) {
-    return list->back;
+    return dl_list_prev(&list->head);
 }
 
 
@@ -324,7 +1270,8 @@ dl_list_itr dl_list_last(const dl_list list) {
  */
 
 dl_list_itr dl_list_next(const dl_list_itr itr) {
-    return itr->next;
+    dl_list_node next = itr->next;
+    return ( next && next->data != &sentinel_data ) ? next : NULL;
 }
 
 
@@ -335,12 +1282,18 @@ dl_list_itr dl_list_next(const dl_list_itr itr) {
  */
 
 dl_list_itr dl_list_prev(const dl_list_itr itr) {
-    return itr->prev;
+    dl_list_node prev = itr->prev;
+    return ( prev && prev->data != &sentinel_data ) ? prev : NULL;
 }
 
 
 /*!
  * \brief           Return an iterator to a specified element of a list.
+ * \details         The element is found by walking from whichever of the
+ * front, the back and the last element found by index is closest, or
+ * through the skip list of an indexed list if all three are far away.
+ * Since this records the element found, a list shared between threads
+ * must be locked even to look up elements by index.
  * \param list      A pointer to the list.
  * \param index     The specified index.
  * \returns         The iterator, or NULL if `index` is out of range.
@@ -352,36 +1305,53 @@ dl_list_itr dl_list_itr_from_index(const dl_list list, const size_t index) {
     }
 
     dl_list_itr element;
+    size_t start = 0;
+    size_t distance = index;
 
-    if ( index == 0 ) {
-        element = list->front;
-    } else if ( index == list->length - 1 ) {
-        element = list->back;
-    } else {
+    if ( list->length - 1 - index < distance ) {
+        start = list->length - 1;
+        distance = start - index;
+    }
 
-        if ( index <= list->length / 2 ) {
+    if ( list->cache_node ) {
+        const size_t cached = list->cache_index;
+        const size_t from_cache = index >= cached ?
+                                  index - cached : cached - index;
+        if ( from_cache < distance ) {
+            start = cached;
+            distance = from_cache;
+        }
+    }
 
-            /*  Find indexed element from front  */
+    if ( list->index && distance > INDEX_WALK_LIMIT ) {
+        dl_index_tower_t * update[INDEX_MAX_LEVELS];
+        size_t ranks[INDEX_MAX_LEVELS];
 
-            size_t i = index;
-            element = list->front->next;
+        validate_index(list);
+        search_index(list, index + 1, update, ranks);
+        element = walk_from_tower(list, update[0], ranks[0], index + 1);
+    } else {
+        if ( start == 0 ) {
+            element = list->head.next;
+        } else if ( start == list->length - 1 ) {
+            element = list->head.prev;
+        } else {
+            element = list->cache_node;
+        }
 
-            while ( --i ) {
+        if ( start <= index ) {
+            while ( distance-- ) {
                 element = element->next;
             }
         } else {
-
-            /*  Find indexed element from back  */
-
-            size_t i = list->length - 1;
-            element = list->back->prev;
-
-            while ( --i > index ) {
+            while ( distance-- ) {
                 element = element->prev;
             }
         }
     }
 
+    list->cache_node = element;
+    list->cache_index = index;
     return element;
 }
 
@@ -409,7 +1379,7 @@ dl_list_node dl_list_new_node(void * data) {
 
 void dl_list_free_node(dl_list list, dl_list_node node) {
     list->free_func(node->data);
-    free(node);
+    release_node(list, node);
 }
 
 
@@ -420,62 +1390,43 @@ void dl_list_free_node(dl_list list, dl_list_node node) {
  */
 
 void dl_list_insert_node_front(dl_list list, dl_list_node node) {
-    if ( list->front ) {
-        dl_list_node old_front = list->front;
-        list->front = node;
-        node->prev = NULL;
-        node->next = old_front;
-        old_front->prev = node;
-    } else {
-        list->front = list->back = node;
-    }
+    link_node(list, node, list->end, list->head.next);
     ++list->length;
+    invalidate_positions(list);
 }
 
 
 /*!
- * \brief           Inserts a node in the middle of a list before a specified
- * iterator.
+ * \brief           Inserts a node in a list before a specified iterator.
+ * \details         This works the same way at the front of the list as
+ * in the middle.
  * \param list      A pointer to the list.
- * \param itr       The iterator before which to insert. As this is
- * inserting in the middle, this iterator should not be either the front
- * or the back of the list, i.e. both the `prev` and `next` members
- * should be non-NULL.
+ * \param itr       The iterator before which to insert.
  * \param node      A pointer to the node to insert.
  */
 
 void dl_list_insert_node_before_mid(dl_list list,
         dl_list_itr itr, dl_list_node node) {
-    dl_list_node before = itr->prev;
-    dl_list_node after = itr;
-    node->prev = before;
-    node->next = after;
-    before->next = node;
-    after->prev = node;
+    link_node(list, node, itr->prev, itr);
     ++list->length;
+    invalidate_positions(list);
 }
 
 
 /*!
- * \brief           Inserts a node in the middle of a list after a specified
- * iterator.
+ * \brief           Inserts a node in a list after a specified iterator.
+ * \details         This works the same way at the back of the list as
+ * in the middle.
  * \param list      A pointer to the list.
- * \param itr       The iterator after which to insert. As this is
- * inserting in the middle, this iterator should not be either the front
- * or the back of the list, i.e. both the `prev` and `next` members
- * should be non-NULL.
+ * \param itr       The iterator after which to insert.
  * \param node      A pointer to the node to insert.
  */
 
 void dl_list_insert_node_after_mid(dl_list list,
         dl_list_itr itr, dl_list_node node) {
-    dl_list_node before = itr;
-    dl_list_node after = itr->next;
-    node->prev = before;
-    node->next = after;
-    before->next = node;
-    after->prev = node;
+    link_node(list, node, itr, itr->next);
     ++list->length;
+    invalidate_positions(list);
 }
 
 
@@ -486,16 +1437,12 @@ void dl_list_insert_node_after_mid(dl_list list,
  */
 
 void dl_list_insert_node_back(dl_list list, dl_list_node node) {
-    if ( list->back ) {
-        dl_list_node old_back = list->back;
-        list->back = node;
-        node->prev = old_back;
-        node->next = NULL;
-        old_back->next = node;
-    } else {
-        list->front = list->back = node;
-    }
+    link_node(list, node, list->head.prev, list->end);
     ++list->length;
+
+    /*  No existing node has moved, so the cached position still holds  */
+
+    invalidate_index(list);
 }
 
 
@@ -514,12 +1461,10 @@ dl_list_node dl_list_remove_at(dl_list list, const size_t index) {
 
     dl_list_node rem_node;
 
-    if ( index == 0 ) {
-        rem_node = dl_list_remove_node_front(list);
-    } else if ( index == list->length - 1 ) {
-        rem_node = dl_list_remove_node_back(list);
+    if ( list->index ) {
+        rem_node = index_remove_node(list, index);
     } else {
-        rem_node = dl_list_remove_node_mid(list,
+        rem_node = dl_list_remove_node(list,
                 dl_list_itr_from_index(list, index));
     }
 
@@ -530,82 +1475,64 @@ dl_list_node dl_list_remove_at(dl_list list, const size_t index) {
 /*!
  * \brief           Removes the first node of a list.
  * \param list      A pointer to the list.
- * \returns         A pointer to the removed node.
+ * \returns         A pointer to the removed node, or NULL if the list
+ * is empty.
  */
 
 dl_list_node dl_list_remove_node_front(dl_list list) {
-    dl_list_node removed_node;
-    if ( list->front ) {
-        removed_node = list->front;
-        dl_list_node new_front = removed_node->next;
-        list->front = new_front;
-
-        if ( new_front ) {
-            new_front->prev = NULL;
-        } else {
-            list->back = NULL;
-        }
-
-        removed_node->prev = NULL;
-        removed_node->next = NULL;
-        --list->length;
-    } else {
-        removed_node = NULL;
+    if ( list->length == 0 ) {
+        return NULL;
     }
 
-    return removed_node;
+    return dl_list_remove_node(list, list->head.next);
 }
 
 
 /*!
- * \brief           Removes a specifed node from the middle of a list.
+ * \brief           Removes a specifed node from a list.
+ * \details         This works the same way at either end of the list as
+ * in the middle, and is the same as dl_list_remove_node().
  * \param list      A pointer to the list.
- * \param node      A pointer to the node to remove. As this is
- * removing from the middle, this node should not be either the front
- * or the back of the list, i.e. both the `prev` and `next` members
- * should be non-NULL.
- * \returns         A pointer to the removed node, i.e. equal to `itr`.
+ * \param node      A pointer to the node to remove.
+ * \returns         A pointer to the removed node, i.e. equal to `node`.
  */
 
 dl_list_node dl_list_remove_node_mid(dl_list list, dl_list_node node) {
-    dl_list_node before = node->prev;
-    dl_list_node after = node->next;
-    node->prev = NULL;
-    node->next = NULL;
-    before->next = after;
-    after->prev = before;
-    --list->length;
-    return node;
+    return dl_list_remove_node(list, node);
 }
 
 
 /*!
  * \brief           Removes the last node of a list.
  * \param list      A pointer to the list.
- * \returns         A pointer to the removed node.
+ * \returns         A pointer to the removed node, or NULL if the list
+ * is empty.
  */
 
 dl_list_node dl_list_remove_node_back(dl_list list) {
-    dl_list_node removed_node;
-    if ( list->back ) {
-        removed_node = list->back;
-        dl_list_node new_back = removed_node->prev;
-        list->back = new_back;
-
-        if ( new_back ) {
-            new_back->next = NULL;
-        } else {
-            list->front = NULL;
-        }
-
-        removed_node->prev = NULL;
-        removed_node->next = NULL;
-        --list->length;
-    } else {
-        removed_node = NULL;
+    if ( list->length == 0 ) {
+        return NULL;
     }
 
-    return removed_node;
+    return dl_list_remove_node(list, list->head.prev);
+}
+
+
+/*!
+ * \brief           Removes a specified node from anywhere in a list.
+ * \details         The node is unlinked in constant time, without
+ * searching the list for it.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node to remove, which must be in
+ * the list.
+ * \returns         A pointer to the removed node, i.e. equal to `node`.
+ */
+
+dl_list_node dl_list_remove_node(dl_list list, dl_list_node node) {
+    unlink_node(list, node);
+    --list->length;
+    invalidate_positions(list);
+    return node;
 }
 
 
@@ -622,7 +1549,7 @@ dl_list_node dl_list_remove_node_back(dl_list list) {
 
 void dl_list_find(const dl_list list, const void * data,
                  dl_list_itr * p_itr, int * p_index) {
-    dl_list_node node = list->front;
+    dl_list_node node = list->head.next;
     int index = 0;
     bool found = false;
 
@@ -631,7 +1558,7 @@ void dl_list_find(const dl_list list, const void * data,
         exit(EXIT_FAILURE);
     }
 
-    while ( node && !found ) {
+    while ( node != list->end && !found ) {
         if ( list->cfunc(node->data, data) == 0 ) {
             found = true;
         } else {
@@ -641,7 +1568,7 @@ void dl_list_find(const dl_list list, const void * data,
     }
 
     if ( p_itr ) {
-        *p_itr = node;
+        *p_itr = found ? node : NULL;
     }
 
     if ( p_index ) {
@@ -27,17 +27,26 @@
 
 /*!
  * \brief           Struct to contain a list.
+ * \details         The `next` and `prev` members of `head` point to the
+ * first and last nodes. The links past either end of the list, and those
+ * of `head` when the list is empty, hold `end`, which is NULL, or `head`
+ * itself for a circular list, whose nodes form a ring through `head`.
  */
 
 typedef struct dl_list_t {
 #ifdef CDS_THREAD_SUPPORT
     pthread_mutex_t mutex;              /*!< Mutex */
 #endif
-    struct dl_list_node_t * front;      /*!< Pointer to first node */
-    struct dl_list_node_t * back;       /*!< Pointer to last node */
+    struct dl_list_node_t head;         /*!< Head node */
+    struct dl_list_node_t * end;        /*!< Link past either end */
     size_t length;                      /*!< Length of list */
     int (*cfunc)();                     /*!< Pointer to compare function */
     void (*free_func)();                /*!< Pointer to free function */
+    struct dl_list_index_t * index;     /*!< Pointer to index, or NULL */
+    struct dl_list_node_t * cache_node; /*!< Last node found by index */
+    size_t cache_index;                 /*!< Index of `cache_node` */
+    bool intrusive;                     /*!< Nodes embedded in elements */
+    size_t offset;                      /*!< Offset of node in element */
 } dl_list_t;
 
 
@@ -68,6 +77,7 @@ dl_list_node dl_list_remove_at(dl_list list, const size_t index);
 dl_list_node dl_list_remove_node_front(dl_list list);
 dl_list_node dl_list_remove_node_mid(dl_list list, dl_list_itr itr);
 dl_list_node dl_list_remove_node_back(dl_list list);
+dl_list_node dl_list_remove_node(dl_list list, dl_list_node node);
 
 void dl_list_find(const dl_list list, const void * data,
                  dl_list_itr * p_itr, int * p_index);
@@ -0,0 +1,478 @@
+/*!
+ * \file            frozen_map.c
+ * \brief           Implementation of frozen perfect hash map data structure.
+ * \details         A frozen map is an immutable copy of a BST map, indexed
+ * by a minimal perfect hash function built with the CHD ("compress, hash
+ * and displace") algorithm. Keys are hashed into small buckets, and each
+ * bucket is assigned a displacement which sends every key in it to a
+ * distinct free slot of a table exactly as long as the number of keys.
+ * A lookup therefore hashes the key once and probes exactly one slot.
+ * Each slot keeps the full hash of its key, so almost all misses are
+ * rejected without touching the key itself, and the key is compared only
+ * to confirm a match.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_bst_map.h"
+#include "cds_frozen_map.h"
+
+
+/*!
+ * \brief           Average number of keys per displacement bucket.
+ */
+
+#define KEYS_PER_BUCKET 4
+
+
+/*!
+ * \brief           Maximum number of hash seeds to try before giving up.
+ */
+
+#define MAX_SEEDS 64
+
+
+/*!
+ * \brief           Struct for a frozen map slot.
+ */
+
+typedef struct frozen_slot_t {
+    uint64_t hash;              /*!< Full hash of key */
+    const char * key;           /*!< Pointer to key in key storage */
+    void * value;               /*!< Pointer to value */
+} frozen_slot_t;
+
+
+/*!
+ * \brief           Struct to contain a frozen map.
+ */
+
+typedef struct frozen_map_t {
+    frozen_slot_t * slots;      /*!< Table of slots, one per key */
+    size_t length;              /*!< Number of keys */
+    uint32_t * disp;            /*!< Displacement for each bucket */
+    size_t num_buckets;         /*!< Number of buckets */
+    uint64_t seed;              /*!< Hash seed */
+    char * keys;                /*!< Contiguous key storage */
+} frozen_map_t;
+
+
+/*!
+ * \brief           Struct for collecting the entries of a map.
+ */
+
+typedef struct freeze_entry_t {
+    const char * key;           /*!< Pointer to key */
+    void * value;               /*!< Pointer to value */
+    uint64_t hash;              /*!< Hash of key */
+    size_t bucket;              /*!< Bucket of key */
+} freeze_entry_t;
+
+
+/*!
+ * \brief           Struct for passing collection state to a traversal.
+ */
+
+typedef struct freeze_ctx_t {
+    freeze_entry_t * entries;   /*!< Array of entries */
+    size_t count;               /*!< Number of entries collected */
+    size_t key_bytes;           /*!< Total size of keys with terminators */
+} freeze_ctx_t;
+
+
+/*!
+ * \brief           Mixes the bits of a 64-bit value.
+ * \param x         The value to mix.
+ * \returns         The mixed value.
+ */
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+
+/*!
+ * \brief           Calculates a seeded 64-bit hash of a key.
+ * \param key       The key to hash.
+ * \param seed      The seed.
+ * \returns         The hash value.
+ */
+
+static uint64_t hash_key(const char * key, const uint64_t seed) {
+    uint64_t hash = 14695981039346656037ULL ^ mix64(seed);
+
+    while ( *key ) {
+        hash ^= (unsigned char) *key++;
+        hash *= 1099511628211ULL;
+    }
+
+    return mix64(hash);
+}
+
+
+/*!
+ * \brief           Returns the bucket for a hash.
+ * \param hash      The hash.
+ * \param num_buckets   The number of buckets.
+ * \returns         The bucket.
+ */
+
+static size_t bucket_for_hash(const uint64_t hash, const size_t num_buckets) {
+    return (size_t) ((hash >> 32) % num_buckets);
+}
+
+
+/*!
+ * \brief           Returns the slot for a hash and displacement.
+ * \param hash      The hash.
+ * \param disp      The displacement of the hash's bucket.
+ * \param length    The number of slots.
+ * \returns         The slot.
+ */
+
+static size_t slot_for_hash(const uint64_t hash, const uint32_t disp,
+                            const size_t length) {
+    return (size_t) (mix64(hash + disp * 0x9e3779b97f4a7c15ULL) % length);
+}
+
+
+/*!
+ * \brief           Collects a key-value pair during a map traversal.
+ * \param key       The key.
+ * \param value     The value.
+ * \param arg       A pointer to the collection state.
+ */
+
+static void collect_entry(const char * key, void * value, void * arg) {
+    freeze_ctx_t * ctx = arg;
+    ctx->entries[ctx->count].key = key;
+    ctx->entries[ctx->count].value = value;
+    ctx->key_bytes += strlen(key) + 1;
+    ++ctx->count;
+}
+
+
+/*!
+ * \brief           Attempts to find displacements for every bucket.
+ * \details         Buckets are placed largest first, while the table is
+ * emptiest. For each bucket, displacements are tried in turn until one
+ * sends every key in the bucket to a distinct free slot.
+ * \param fmap      A pointer to the frozen map, with its length, number
+ * of buckets, seed and displacement array set.
+ * \param entries   The entries, with their hashes and buckets set, and
+ * sorted by bucket.
+ * \param starts    The index of the first entry of each bucket, plus a
+ * final element equal to the number of entries.
+ * \param order     The buckets, sorted by decreasing size.
+ * \param taken     An array of flags, one per slot, all `false`.
+ * \param slots     An array in which to store the slot of each entry.
+ * \returns         `true` if displacements were found for all buckets,
+ * `false` if a bucket could not be placed.
+ */
+
+static bool place_buckets(frozen_map fmap, const freeze_entry_t * entries,
+                          const size_t * starts, const size_t * order,
+                          bool * taken, size_t * slots) {
+    const uint64_t max_disp = (uint64_t) fmap->length * 16 + 4096;
+
+    for ( size_t i = 0; i < fmap->num_buckets; ++i ) {
+        const size_t bucket = order[i];
+        const size_t first = starts[bucket];
+        const size_t last = starts[bucket + 1];
+        bool placed = false;
+
+        if ( first == last ) {
+            fmap->disp[bucket] = 0;
+            continue;
+        }
+
+        for ( uint64_t d = 0; !placed && d < max_disp && d <= UINT32_MAX;
+              ++d ) {
+            size_t j;
+
+            for ( j = first; j < last; ++j ) {
+                const size_t slot = slot_for_hash(entries[j].hash,
+                                                  (uint32_t) d, fmap->length);
+                if ( taken[slot] ) {
+                    break;
+                }
+                taken[slot] = true;
+                slots[j] = slot;
+            }
+
+            if ( j == last ) {
+                fmap->disp[bucket] = (uint32_t) d;
+                placed = true;
+            } else {
+
+                /*  Release the slots this attempt claimed  */
+
+                while ( j-- > first ) {
+                    taken[slots[j]] = false;
+                }
+            }
+        }
+
+        if ( !placed ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief           Builds the perfect hash for a set of entries.
+ * \details         If no displacement can be found for some bucket,
+ * which in practice happens only if two keys share a full hash value,
+ * the build is retried with a new seed.
+ * \param fmap      A pointer to the frozen map, with its length set.
+ * \param entries   The entries.
+ * \param slots     An array in which to store the slot of each entry.
+ * \returns         `true` on success, `false` if no seed succeeded.
+ */
+
+static bool build_hash(frozen_map fmap, freeze_entry_t * entries,
+                       size_t * slots) {
+    const size_t n = fmap->length;
+    const size_t nb = fmap->num_buckets;
+    size_t * starts = term_malloc(sizeof(*starts) * (nb + 1));
+    size_t * order = term_malloc(sizeof(*order) * nb);
+    freeze_entry_t * sorted = term_malloc(sizeof(*sorted) * n);
+    bool * taken = term_malloc(sizeof(*taken) * n);
+    bool success = false;
+
+    for ( uint64_t seed = 0; !success && seed < MAX_SEEDS; ++seed ) {
+        fmap->seed = seed;
+
+        /*  Hash keys and counting-sort the entries by bucket  */
+
+        memset(starts, 0, sizeof(*starts) * (nb + 1));
+        for ( size_t i = 0; i < n; ++i ) {
+            entries[i].hash = hash_key(entries[i].key, seed);
+            entries[i].bucket = bucket_for_hash(entries[i].hash, nb);
+            ++starts[entries[i].bucket + 1];
+        }
+
+        for ( size_t b = 0; b < nb; ++b ) {
+            starts[b + 1] += starts[b];
+        }
+
+        for ( size_t i = 0; i < n; ++i ) {
+            sorted[starts[entries[i].bucket]++] = entries[i];
+        }
+
+        for ( size_t b = nb; b > 0; --b ) {
+            starts[b] = starts[b - 1];
+        }
+        starts[0] = 0;
+
+        /*  Order buckets by decreasing size, again by counting sort,
+            since no bucket can hold more than n entries.  */
+
+        size_t max_size = 0;
+        for ( size_t b = 0; b < nb; ++b ) {
+            const size_t size = starts[b + 1] - starts[b];
+            if ( size > max_size ) {
+                max_size = size;
+            }
+        }
+
+        size_t * size_starts = term_malloc(sizeof(*size_starts) *
+                                           (max_size + 2));
+        memset(size_starts, 0, sizeof(*size_starts) * (max_size + 2));
+        for ( size_t b = 0; b < nb; ++b ) {
+            ++size_starts[max_size - (starts[b + 1] - starts[b]) + 1];
+        }
+        for ( size_t s = 0; s <= max_size; ++s ) {
+            size_starts[s + 1] += size_starts[s];
+        }
+        for ( size_t b = 0; b < nb; ++b ) {
+            order[size_starts[max_size - (starts[b + 1] - starts[b])]++] = b;
+        }
+        free(size_starts);
+
+        memset(taken, 0, sizeof(*taken) * n);
+        success = place_buckets(fmap, sorted, starts, order, taken, slots);
+    }
+
+    if ( success ) {
+        memcpy(entries, sorted, sizeof(*entries) * n);
+    }
+
+    free(taken);
+    free(sorted);
+    free(order);
+    free(starts);
+
+    return success;
+}
+
+
+/*!
+ * \brief           Builds a frozen map from a BST map.
+ * \details         The keys are copied into a single contiguous block.
+ * The values are not copied, and remain owned by the BST map, which must
+ * therefore outlive the frozen map, and whose values must not be replaced
+ * or deleted while the frozen map is in use. Building takes expected
+ * O(n log n) time for n keys.
+ * \param map       A pointer to the BST map.
+ * \returns         A pointer to the new frozen map, or `NULL` if a
+ * perfect hash could not be built.
+ */
+
+frozen_map bst_map_freeze(const bst_map map) {
+    const size_t n = bst_map_length(map);
+    freeze_ctx_t ctx = {NULL, 0, 0};
+
+    frozen_map fmap = term_malloc(sizeof(*fmap));
+    fmap->length = n;
+    fmap->num_buckets = n / KEYS_PER_BUCKET + 1;
+    fmap->seed = 0;
+    fmap->disp = term_malloc(sizeof(*fmap->disp) * fmap->num_buckets);
+    fmap->slots = NULL;
+    fmap->keys = NULL;
+
+    if ( n == 0 ) {
+        fmap->disp[0] = 0;
+        return fmap;
+    }
+
+    ctx.entries = term_malloc(sizeof(*ctx.entries) * n);
+    bst_map_traverse(map, collect_entry, &ctx);
+
+    size_t * slots = term_malloc(sizeof(*slots) * n);
+    if ( !build_hash(fmap, ctx.entries, slots) ) {
+        free(slots);
+        free(ctx.entries);
+        free(fmap->disp);
+        free(fmap);
+        return NULL;
+    }
+
+    /*  Populate the table, packing the keys together  */
+
+    fmap->slots = term_malloc(sizeof(*fmap->slots) * n);
+    fmap->keys = term_malloc(ctx.key_bytes);
+    char * next_key = fmap->keys;
+
+    for ( size_t i = 0; i < n; ++i ) {
+        frozen_slot_t * slot = &fmap->slots[slots[i]];
+        const size_t key_size = strlen(ctx.entries[i].key) + 1;
+
+        memcpy(next_key, ctx.entries[i].key, key_size);
+        slot->hash = ctx.entries[i].hash;
+        slot->key = next_key;
+        slot->value = ctx.entries[i].value;
+        next_key += key_size;
+    }
+
+    free(slots);
+    free(ctx.entries);
+
+    return fmap;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a frozen map.
+ * \details         The values are not freed, as they remain owned by
+ * the BST map from which the frozen map was built.
+ * \param fmap      A pointer to the frozen map to free.
+ */
+
+void frozen_map_free(frozen_map fmap) {
+    free(fmap->keys);
+    free(fmap->slots);
+    free(fmap->disp);
+    free(fmap);
+}
+
+
+/*!
+ * \brief           Returns the number of elements in a frozen map.
+ * \param fmap      A pointer to the frozen map.
+ * \returns         The number of elements in the map.
+ */
+
+size_t frozen_map_length(const frozen_map fmap) {
+    return fmap->length;
+}
+
+
+/*!
+ * \brief           Checks if a frozen map is empty.
+ * \param fmap      A pointer to the frozen map.
+ * \returns         `true` if the map is empty, otherwise `false`.
+ */
+
+bool frozen_map_isempty(const frozen_map fmap) {
+    return fmap->length == 0;
+}
+
+
+/*!
+ * \brief           Finds the slot holding a key.
+ * \param fmap      A pointer to the frozen map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the slot if the key is found, `NULL`
+ * otherwise.
+ */
+
+static const frozen_slot_t * find_slot(const frozen_map fmap,
+                                       const char * key) {
+    if ( fmap->length == 0 ) {
+        return NULL;
+    }
+
+    const uint64_t hash = hash_key(key, fmap->seed);
+    const uint32_t disp = fmap->disp[bucket_for_hash(hash, fmap->num_buckets)];
+    const frozen_slot_t * slot = &fmap->slots[slot_for_hash(hash, disp,
+                                                            fmap->length)];
+
+    if ( slot->hash != hash || strcmp(slot->key, key) != 0 ) {
+        return NULL;
+    }
+
+    return slot;
+}
+
+
+/*!
+ * \brief           Determines if a key is in a frozen map.
+ * \param fmap      A pointer to the frozen map.
+ * \param key       The key for which to search.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool frozen_map_search(const frozen_map fmap, const char * key) {
+    return find_slot(fmap, key) ? true : false;
+}
+
+
+/*!
+ * \brief           Searches a frozen map for a value matching a key and
+ * returns it.
+ * \param fmap      A pointer to the frozen map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * frozen_map_search_data(const frozen_map fmap, const char * key) {
+    const frozen_slot_t * slot = find_slot(fmap, key);
+    return slot ? slot->value : NULL;
+}
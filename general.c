@@ -349,3 +349,38 @@ int cds_compare_double(const void * data, const void * cmp) {
 int cds_compare_string(const void * data, const void * cmp) {
     return strcmp(data, cmp);
 }
+
+
+/*!
+ * \brief           Calculates a 64-bit hash of a string.
+ * \details         Uses the FNV-1a hash function.
+ * \param str       The string to hash.
+ * \returns         The hash value.
+ */
+
+uint64_t cds_hash_string(const char * str) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    while ( *str ) {
+        hash ^= (unsigned char) *str++;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+
+/*!
+ * \brief           Calculates a 64-bit hash of a string for a Bloom
+ * filter.
+ * \details         Finishes mixing the FNV-1a hash, whose high bits are
+ * poorly mixed on their own, since a blocked filter uses them to pick
+ * the block.
+ * \param str       The string to hash.
+ * \returns         The hash value.
+ */
+
+uint64_t cds_filter_hash_string(const char * str) {
+    const uint64_t hash = cds_hash_string(str);
+    return hash ^ (hash >> 29) ^ (hash << 31);
+}
@@ -0,0 +1,351 @@
+/*!
+ * \file            intern.c
+ * \brief           Implementation of string interning table.
+ * \details         Interning a string returns a canonical copy of it, the
+ * same pointer for every equal string, so structures sharing a table
+ * hold each distinct string once and can test interned strings for
+ * equality by comparing pointers.
+ *
+ * Canonical copies are packed end to end into large arena blocks, rather
+ * than each being allocated separately, and live until the table is
+ * freed. They are indexed by an open addressing hash table holding each
+ * string's hash alongside its pointer, so that probes compare the strings
+ * themselves only when their hashes match.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_general.h"
+#include "cds_intern.h"
+
+#ifdef CDS_THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+
+/*!
+ * \brief           Size of an arena block.
+ */
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+
+/*!
+ * \brief           Initial number of hash table slots.
+ */
+
+#define INITIAL_SLOTS 1024
+
+
+/*!
+ * \brief           Struct for an arena block.
+ */
+
+typedef struct arena_block_t {
+    struct arena_block_t * next;    /*!< Pointer to previous block */
+    size_t size;                /*!< Size of block data */
+    size_t used;                /*!< Bytes of block data used */
+    char data[];                /*!< Block data */
+} arena_block_t;
+
+
+/*!
+ * \brief           Struct for a hash table slot.
+ */
+
+typedef struct intern_slot_t {
+    uint64_t hash;              /*!< Hash of string */
+    const char * str;           /*!< Canonical string, or `NULL` if empty */
+} intern_slot_t;
+
+
+/*!
+ * \brief           Struct to contain an interning table.
+ */
+
+typedef struct intern_table_t {
+#ifdef CDS_THREAD_SUPPORT
+    pthread_mutex_t mutex;      /*!< Mutex */
+#endif
+    intern_slot_t * slots;      /*!< Hash table slots */
+    size_t num_slots;           /*!< Number of slots, a power of two */
+    size_t length;              /*!< Number of interned strings */
+    arena_block_t * blocks;     /*!< Arena blocks, current block first */
+    size_t bytes;               /*!< Bytes of arena blocks allocated */
+} intern_table_t;
+
+
+/*!
+ * \brief           Locks a table's mutex.
+ * \param table     A pointer to the table.
+ */
+
+static void intern_lock(intern_table table) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_lock(&table->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't lock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) table;       /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Unlocks a table's mutex.
+ * \param table     A pointer to the table.
+ */
+
+static void intern_unlock(intern_table table) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_unlock(&table->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't unlock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) table;       /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Finds the slot for a string.
+ * \details         The caller must hold the table's mutex.
+ * \param table     A pointer to the table.
+ * \param str       The string.
+ * \param hash      The hash of the string.
+ * \returns         A pointer to the slot holding the string, or to the
+ * empty slot where it would be inserted.
+ */
+
+static intern_slot_t * find_slot(intern_table table, const char * str,
+                                 const uint64_t hash) {
+    const size_t mask = table->num_slots - 1;
+    size_t i = (size_t) hash & mask;
+
+    while ( table->slots[i].str ) {
+        if ( table->slots[i].hash == hash &&
+             strcmp(table->slots[i].str, str) == 0 ) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return &table->slots[i];
+}
+
+
+/*!
+ * \brief           Doubles the number of slots in a table.
+ * \details         The caller must hold the table's mutex.
+ * \param table     A pointer to the table.
+ */
+
+static void grow_slots(intern_table table) {
+    intern_slot_t * old_slots = table->slots;
+    const size_t old_num = table->num_slots;
+
+    table->num_slots *= 2;
+    table->slots = term_malloc(sizeof(*table->slots) * table->num_slots);
+    for ( size_t i = 0; i < table->num_slots; ++i ) {
+        table->slots[i].str = NULL;
+    }
+
+    const size_t mask = table->num_slots - 1;
+    for ( size_t i = 0; i < old_num; ++i ) {
+        if ( old_slots[i].str ) {
+            size_t j = (size_t) old_slots[i].hash & mask;
+            while ( table->slots[j].str ) {
+                j = (j + 1) & mask;
+            }
+            table->slots[j] = old_slots[i];
+        }
+    }
+
+    free(old_slots);
+}
+
+
+/*!
+ * \brief           Copies a string into a table's arena.
+ * \details         The caller must hold the table's mutex. A string
+ * larger than a block gets a block of its own.
+ * \param table     A pointer to the table.
+ * \param str       The string.
+ * \returns         A pointer to the copy.
+ */
+
+static const char * arena_copy(intern_table table, const char * str) {
+    const size_t size = strlen(str) + 1;
+    arena_block_t * block = table->blocks;
+
+    if ( block == NULL || block->size - block->used < size ) {
+        const size_t block_size = size > ARENA_BLOCK_SIZE ?
+                                  size : ARENA_BLOCK_SIZE;
+        block = term_malloc(sizeof(*block) + block_size);
+        block->size = block_size;
+        block->used = 0;
+        table->bytes += block_size;
+
+        /*  Keep filling the current block after an oversized string  */
+
+        if ( size > ARENA_BLOCK_SIZE && table->blocks ) {
+            block->next = table->blocks->next;
+            table->blocks->next = block;
+        } else {
+            block->next = table->blocks;
+            table->blocks = block;
+        }
+    }
+
+    char * copy = block->data + block->used;
+    memcpy(copy, str, size);
+    block->used += size;
+    return copy;
+}
+
+
+/*!
+ * \brief           Initializes a new interning table.
+ * \returns         A pointer to the new table.
+ */
+
+intern_table intern_table_init(void) {
+    intern_table new_table = term_malloc(sizeof(*new_table));
+    new_table->num_slots = INITIAL_SLOTS;
+    new_table->slots = term_malloc(sizeof(*new_table->slots) *
+                                   new_table->num_slots);
+    for ( size_t i = 0; i < new_table->num_slots; ++i ) {
+        new_table->slots[i].str = NULL;
+    }
+    new_table->length = 0;
+    new_table->blocks = NULL;
+    new_table->bytes = 0;
+
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_init(&new_table->mutex, NULL);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't initialize mutex", stderr);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
+    return new_table;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with an interning table.
+ * \details         Every canonical string is freed with the table, so
+ * it must outlive all the structures using them.
+ * \param table     A pointer to the table.
+ */
+
+void intern_table_free(intern_table table) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_destroy(&table->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't destroy mutex", stderr);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
+    while ( table->blocks ) {
+        arena_block_t * next = table->blocks->next;
+        free(table->blocks);
+        table->blocks = next;
+    }
+
+    free(table->slots);
+    free(table);
+}
+
+
+/*!
+ * \brief           Interns a string.
+ * \param table     A pointer to the table.
+ * \param str       The string.
+ * \returns         The canonical copy of the string, which is the same
+ * pointer for every equal string interned in the table.
+ */
+
+const char * intern_string(intern_table table, const char * str) {
+    const uint64_t hash = cds_hash_string(str);
+
+    intern_lock(table);
+
+    intern_slot_t * slot = find_slot(table, str, hash);
+    const char * canonical = slot->str;
+
+    if ( canonical == NULL ) {
+        canonical = arena_copy(table, str);
+        slot->hash = hash;
+        slot->str = canonical;
+
+        if ( ++table->length * 2 > table->num_slots ) {
+            grow_slots(table);
+        }
+    }
+
+    intern_unlock(table);
+    return canonical;
+}
+
+
+/*!
+ * \brief           Looks up the canonical copy of a string.
+ * \param table     A pointer to the table.
+ * \param str       The string.
+ * \returns         The canonical copy of the string, or `NULL` if no
+ * equal string has been interned.
+ */
+
+const char * intern_lookup(intern_table table, const char * str) {
+    const uint64_t hash = cds_hash_string(str);
+
+    intern_lock(table);
+    const char * canonical = find_slot(table, str, hash)->str;
+    intern_unlock(table);
+
+    return canonical;
+}
+
+
+/*!
+ * \brief           Returns the number of strings in an interning table.
+ * \param table     A pointer to the table.
+ * \returns         The number of distinct strings interned.
+ */
+
+size_t intern_table_length(intern_table table) {
+    intern_lock(table);
+    const size_t length = table->length;
+    intern_unlock(table);
+    return length;
+}
+
+
+/*!
+ * \brief           Returns the arena size of an interning table.
+ * \param table     A pointer to the table.
+ * \returns         The number of bytes of arena blocks allocated to hold
+ * the interned strings.
+ */
+
+size_t intern_table_bytes(intern_table table) {
+    intern_lock(table);
+    const size_t bytes = table->bytes;
+    intern_unlock(table);
+    return bytes;
+}
@@ -0,0 +1,397 @@
+/*!
+ * \file            lru_cache.c
+ * \brief           Implementation of least recently used cache data
+ * structure.
+ * \details         Entries are indexed by key in a binary search tree,
+ * and ordered by recency in a doubly linked list whose nodes are embedded
+ * in the entries, so a hit relinks its node to the front of the list in
+ * constant time, and the least recently used entry is always at the
+ * back. Each entry holds its list node, value, size and key in a single
+ * allocation.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_lru_cache.h"
+#include "bs_tree.h"
+#include "dl_list.h"
+
+
+/*!
+ * \brief           Struct to contain a cache.
+ */
+
+typedef struct lru_cache_t {
+    bs_tree index;              /*!< Entries ordered by key */
+    dl_list recency;            /*!< Entries, most recently used first */
+    size_t capacity;            /*!< Maximum total size of entries */
+    size_t size;                /*!< Total size of entries */
+    void (*evict_func)(const char *, void *, void *);   /*!< Evict callback */
+    void * evict_arg;           /*!< Argument for evict callback */
+} lru_cache_t;
+
+
+/*!
+ * \brief           Cache entry struct.
+ */
+
+typedef struct cache_entry_t {
+    dl_list_node_t node;        /*!< Recency list node */
+    void * value;               /*!< Pointer to data */
+    size_t size;                /*!< Size charged against capacity */
+    char key[];                 /*!< Key string */
+} cache_entry_t;
+
+
+/*!
+ * \brief           Typedef for cache entry pointer.
+ */
+
+typedef struct cache_entry_t * cache_entry;
+
+
+/*!
+ * \brief           Frees resources used by a cache entry.
+ * \param entry     A pointer to the entry to free.
+ */
+
+static void free_entry(void * entry) {
+    free(((cache_entry) entry)->value);
+    free(entry);
+}
+
+
+/*!
+ * \brief           Compare the keys of two cache entries.
+ * \param data      `void` pointer to entry to be compared.
+ * \param cmp       `void` pointer to comparison entry.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * of data is less than, equal to or greater than the key of cmp.
+ */
+
+static int compare_entry(const void * data, const void * cmp) {
+    return strcmp(((const cache_entry_t *) data)->key,
+                  ((const cache_entry_t *) cmp)->key);
+}
+
+
+/*!
+ * \brief           Searches a cache for a key.
+ * \param cache     A pointer to the cache.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the entry for the key, or `NULL` if the
+ * key was not found.
+ */
+
+static cache_entry search_entry(const lru_cache cache, const char * key) {
+    bs_tree_node node = cache->index->root;
+
+    while ( node ) {
+        const int compare = strcmp(key, ((cache_entry) node->data)->key);
+
+        if ( compare == 0 ) {
+            return node->data;
+        } else if ( compare < 0 ) {
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!
+ * \brief           Marks an entry as the most recently used.
+ * \param cache     A pointer to the cache.
+ * \param entry     A pointer to the entry.
+ */
+
+static void touch_entry(lru_cache cache, cache_entry entry) {
+    if ( dl_list_first(cache->recency) != &entry->node ) {
+        dl_list_remove_node(cache->recency, &entry->node);
+        dl_list_insert_node_front(cache->recency, &entry->node);
+    }
+}
+
+
+/*!
+ * \brief           Removes an entry from a cache.
+ * \details         The entry itself is not freed.
+ * \param cache     A pointer to the cache.
+ * \param entry     A pointer to the entry.
+ */
+
+static void unlink_entry(lru_cache cache, cache_entry entry) {
+    dl_list_remove_node(cache->recency, &entry->node);
+    free(bs_tree_remove(cache->index, entry));
+    cache->size -= entry->size;
+}
+
+
+/*!
+ * \brief           Evicts least recently used entries until a cache is
+ * within its capacity.
+ * \param cache     A pointer to the cache.
+ * \param keep      A pointer to an entry which should not be evicted,
+ * even if it alone exceeds the capacity.
+ */
+
+static void evict_entries(lru_cache cache, const cache_entry_t * keep) {
+    while ( cache->size > cache->capacity ) {
+        cache_entry victim = dl_list_last(cache->recency)->data;
+        if ( victim == keep ) {
+            break;
+        }
+
+        unlink_entry(cache, victim);
+
+        if ( cache->evict_func ) {
+            cache->evict_func(victim->key, victim->value, cache->evict_arg);
+        } else {
+            free(victim->value);
+        }
+        free(victim);
+    }
+}
+
+
+/*!
+ * \brief           Initializes a new cache.
+ * \details         The capacity is measured in whatever units the sizes
+ * passed to lru_cache_put() are, so for a cache bounded by number of
+ * entries, pass a size of 1 for each entry, and for a cache bounded by
+ * memory, pass the size of each value in bytes.
+ * \param capacity  The maximum total size of the entries in the cache.
+ * \param evict_func    A pointer to a function to invoke when an entry
+ * is evicted to make room for another. The function is passed the key,
+ * the value, and `arg`, and takes ownership of the value. If this is
+ * `NULL`, evicted values are `free()`d.
+ * \param arg       A pointer to the argument to pass to `evict_func()`.
+ * \returns         A pointer to the new cache.
+ */
+
+lru_cache lru_cache_init(const size_t capacity,
+        void (*evict_func)(const char *, void *, void *), void * arg) {
+    lru_cache new_cache = term_malloc(sizeof(*new_cache));
+    new_cache->index = bs_tree_init(compare_entry, free_entry);
+    new_cache->recency = dl_list_init_circular(NULL, NULL);
+    new_cache->capacity = capacity;
+    new_cache->size = 0;
+    new_cache->evict_func = evict_func;
+    new_cache->evict_arg = arg;
+    return new_cache;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a cache.
+ * \details         Any remaining values are `free()`d, without being
+ * passed to the eviction function.
+ * \param cache     A pointer to the cache to free.
+ */
+
+void lru_cache_free(lru_cache cache) {
+
+    /*  List nodes are embedded in the entries, so unlink them all
+     *  before the list is freed, and free the entries with the tree.  */
+
+    while ( dl_list_remove_node_front(cache->recency) ) {
+        ;
+    }
+
+    dl_list_free(cache->recency);
+    bs_tree_free(cache->index);
+    free(cache);
+}
+
+
+/*!
+ * \brief           Returns the number of entries in a cache.
+ * \param cache     A pointer to the cache.
+ * \returns         The number of entries in the cache.
+ */
+
+size_t lru_cache_length(const lru_cache cache) {
+    return bs_tree_length(cache->index);
+}
+
+
+/*!
+ * \brief           Checks if a cache is empty.
+ * \param cache     A pointer to the cache.
+ * \returns         `true` if the cache is empty, otherwise `false`.
+ */
+
+bool lru_cache_isempty(const lru_cache cache) {
+    return bs_tree_isempty(cache->index);
+}
+
+
+/*!
+ * \brief           Returns the total size of the entries in a cache.
+ * \param cache     A pointer to the cache.
+ * \returns         The total size of the entries in the cache.
+ */
+
+size_t lru_cache_size(const lru_cache cache) {
+    return cache->size;
+}
+
+
+/*!
+ * \brief           Returns the capacity of a cache.
+ * \param cache     A pointer to the cache.
+ * \returns         The capacity of the cache.
+ */
+
+size_t lru_cache_capacity(const lru_cache cache) {
+    return cache->capacity;
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into a cache.
+ * \details         The entry becomes the most recently used, and least
+ * recently used entries are then evicted until the cache is within its
+ * capacity. An entry which alone exceeds the capacity is kept until the
+ * next insertion. The value is replaced if the key is already found in
+ * the cache. Any memory consumed by the old value is automatically
+ * `free()`d.
+ * \param cache     A pointer to the cache.
+ * \param key       The key of the new value to insert.
+ * \param value     A pointer to the new value to insert.
+ * \param size      The size to charge against the cache's capacity.
+ * \returns         `true` if the key was already in the cache and the
+ * value has been replaced, `false` if the key was not present.
+ */
+
+bool lru_cache_put(lru_cache cache, const char * key,
+                   void * value, const size_t size) {
+    bs_tree_node * p_node = &cache->index->root;
+
+    while ( *p_node ) {
+        cache_entry entry = (*p_node)->data;
+        const int compare = strcmp(key, entry->key);
+
+        if ( compare == 0 ) {
+            free(entry->value);
+            entry->value = value;
+            cache->size = cache->size - entry->size + size;
+            entry->size = size;
+            touch_entry(cache, entry);
+            evict_entries(cache, entry);
+            return true;
+        } else if ( compare < 0 ) {
+            p_node = &(*p_node)->left;
+        } else {
+            p_node = &(*p_node)->right;
+        }
+    }
+
+    const size_t key_size = strlen(key) + 1;
+    cache_entry new_entry = term_malloc(sizeof(*new_entry) + key_size);
+    new_entry->node.data = new_entry;
+    new_entry->node.next = NULL;
+    new_entry->node.prev = NULL;
+    new_entry->value = value;
+    new_entry->size = size;
+    memcpy(new_entry->key, key, key_size);
+
+    *p_node = bs_tree_new_node(new_entry);
+    ++cache->index->length;
+    bs_tree_filter_add(cache->index, new_entry);
+
+    dl_list_insert_node_front(cache->recency, &new_entry->node);
+    cache->size += size;
+    evict_entries(cache, new_entry);
+
+    return false;
+}
+
+
+/*!
+ * \brief           Searches a cache for a value matching a key and
+ * returns it, marking it as the most recently used.
+ * \param cache     A pointer to the cache.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * lru_cache_get(lru_cache cache, const char * key) {
+    cache_entry entry = search_entry(cache, key);
+
+    if ( entry == NULL ) {
+        return NULL;
+    }
+
+    touch_entry(cache, entry);
+    return entry->value;
+}
+
+
+/*!
+ * \brief           Searches a cache for a value matching a key and
+ * returns it, without changing its recency.
+ * \param cache     A pointer to the cache.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * lru_cache_peek(const lru_cache cache, const char * key) {
+    cache_entry entry = search_entry(cache, key);
+    return entry ? entry->value : NULL;
+}
+
+
+/*!
+ * \brief           Deletes a key and its value from a cache.
+ * \details         The value is `free()`d, without being passed to the
+ * eviction function.
+ * \param cache     A pointer to the cache.
+ * \param key       The key to delete.
+ * \returns         `true` if the key was found and deleted, `false` if
+ * the key was not present.
+ */
+
+bool lru_cache_delete(lru_cache cache, const char * key) {
+    cache_entry entry = search_entry(cache, key);
+
+    if ( entry == NULL ) {
+        return false;
+    }
+
+    unlink_entry(cache, entry);
+    free_entry(entry);
+    return true;
+}
+
+
+/*!
+ * \brief           Locks a cache's mutex.
+ * \details         Since lru_cache_get() updates recency, a cache shared
+ * between threads must be locked around gets as well as puts.
+ * \param cache     A pointer to the cache.
+ */
+
+void lru_cache_lock(lru_cache cache) {
+    bs_tree_lock(cache->index);
+}
+
+
+/*!
+ * \brief           Unlocks a cache's mutex.
+ * \param cache     A pointer to the cache.
+ */
+
+void lru_cache_unlock(lru_cache cache) {
+    bs_tree_unlock(cache->index);
+}
@@ -0,0 +1,1141 @@
+/*!
+ * \file            lsm_map.c
+ * \brief           Implementation of log-structured merge map data
+ * structure.
+ * \details         Writes go to an in-memory skip list, the memtable, so
+ * that each write takes logarithmic time whatever the order of the keys,
+ * and the memtable can be written out in key order by walking its bottom
+ * level. When the memtable reaches its size threshold it is written out
+ * as an immutable sorted string table file, a run, and a fresh memtable
+ * is started. A search looks in the memtable and then in each run from
+ * newest to oldest, stopping at the first which holds the key, and each
+ * run has a Bloom filter, built when the run is loaded, so that runs
+ * which do not hold the key are almost always skipped without touching
+ * the file. A deletion is recorded as a tombstone, which hides any older
+ * value of the key until the runs are merged.
+ *
+ * When enough runs have accumulated they are merged into one by a k-way
+ * merge of their cursors, keeping the newest value of each key and
+ * dropping tombstones, since nothing older remains for them to hide.
+ * With thread support this is done by a background thread, so writers
+ * only ever wait for a memtable to be written.
+ *
+ * The merged run replaces the oldest of its inputs, so it ranks below
+ * any input which survives a crash part way through, and the remaining
+ * inputs are then removed oldest first. At every point, therefore, the
+ * files on disk give the same answer for every key.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+/*!
+ * \brief           Enable POSIX library.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_general.h"
+#include "cds_bloom_filter.h"
+#include "cds_lsm_map.h"
+#include "sstable.h"
+
+#ifdef CDS_THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+
+/*!
+ * \brief           Default memtable size threshold in bytes.
+ */
+
+#define DEFAULT_MEMTABLE_SIZE (4 * 1024 * 1024)
+
+
+/*!
+ * \brief           Number of runs at which runs are merged.
+ */
+
+#define COMPACT_RUNS 4
+
+
+/*!
+ * \brief           Maximum number of memtable skip list levels.
+ * \details         An entry reaches each level with probability 1/4, so
+ * this suffices for memtables of around four billion entries.
+ */
+
+#define MEMTABLE_MAX_LEVELS 16
+
+
+/*!
+ * \brief           Bloom filter bits per key for each run.
+ */
+
+#define FILTER_BITS_PER_KEY 10
+
+
+/*!
+ * \brief           Name of the temporary file for writing a memtable.
+ */
+
+#define FLUSH_TMP_NAME "flush.tmp"
+
+
+/*!
+ * \brief           Name of the temporary file for merging runs.
+ */
+
+#define COMPACT_TMP_NAME "compact.tmp"
+
+
+/*!
+ * \brief           Struct for a run.
+ */
+
+typedef struct lsm_run_t {
+    sstable table;              /*!< Sorted string table */
+    bloom_filter filter;        /*!< Filter of keys in table */
+    uint64_t seq;               /*!< Sequence number, newest highest */
+} lsm_run_t;
+
+
+/*!
+ * \brief           Struct for a memtable value.
+ */
+
+typedef struct lsm_value_t {
+    size_t len;                 /*!< Length of value */
+    bool deleted;               /*!< Set if value is a tombstone */
+    unsigned char data[];       /*!< Value bytes */
+} lsm_value_t;
+
+
+/*!
+ * \brief           Struct for a memtable entry.
+ */
+
+typedef struct memtable_entry_t {
+    char * key;                         /*!< Key */
+    lsm_value_t * value;                /*!< Value */
+    struct memtable_entry_t * next[];   /*!< Next entries, lowest first */
+} memtable_entry_t;
+
+
+/*!
+ * \brief           Struct to contain a memtable.
+ * \details         The head entry has no key, and has every level.
+ */
+
+typedef struct memtable_t {
+    memtable_entry_t * head;    /*!< Pointer to head entry */
+    size_t levels;              /*!< Number of levels in use */
+    size_t length;              /*!< Number of entries */
+    uint64_t seed;              /*!< Random entry height state */
+} memtable_t;
+
+
+/*!
+ * \brief           Struct to contain a log-structured merge map.
+ */
+
+typedef struct lsm_map_t {
+#ifdef CDS_THREAD_SUPPORT
+    pthread_mutex_t mutex;      /*!< Mutex */
+    pthread_cond_t cond;        /*!< Signalled on change of run state */
+    pthread_t compactor;        /*!< Background compaction thread */
+    bool compacting;            /*!< Set while a compaction is running */
+    bool stopping;              /*!< Set when the map is being closed */
+#endif
+    char * dirname;             /*!< Directory holding runs */
+    memtable_t * memtable;      /*!< In-memory map of recent writes */
+    size_t memtable_bytes;      /*!< Approximate size of memtable */
+    size_t memtable_limit;      /*!< Size at which memtable is written */
+    lsm_run_t * runs;           /*!< Runs, oldest first */
+    size_t num_runs;            /*!< Number of runs */
+    uint64_t next_seq;          /*!< Sequence number for next run */
+} lsm_map_t;
+
+
+/*!
+ * \brief           Creates a new memtable entry.
+ * \param key       The key, which is copied, or `NULL` for the head.
+ * \param height    The number of levels the entry is linked into.
+ * \returns         A pointer to the new entry.
+ */
+
+static memtable_entry_t * new_entry(const char * key, const size_t height) {
+    memtable_entry_t * entry = term_malloc(sizeof(*entry) +
+                                           sizeof(*entry->next) * height);
+    entry->key = key ? term_strdup(key) : NULL;
+    entry->value = NULL;
+    for ( size_t l = 0; l < height; ++l ) {
+        entry->next[l] = NULL;
+    }
+    return entry;
+}
+
+
+/*!
+ * \brief           Creates a new, empty memtable.
+ * \returns         A pointer to the new memtable.
+ */
+
+static memtable_t * memtable_init(void) {
+    memtable_t * memtable = term_malloc(sizeof(*memtable));
+    memtable->head = new_entry(NULL, MEMTABLE_MAX_LEVELS);
+    memtable->levels = 1;
+    memtable->length = 0;
+    memtable->seed = 0x9E3779B97F4A7C15ULL;
+    return memtable;
+}
+
+
+/*!
+ * \brief           Frees a memtable and every entry and value in it.
+ * \param memtable  A pointer to the memtable.
+ */
+
+static void memtable_free(memtable_t * memtable) {
+    memtable_entry_t * entry = memtable->head->next[0];
+
+    while ( entry ) {
+        memtable_entry_t * next = entry->next[0];
+        free(entry->key);
+        free(entry->value);
+        free(entry);
+        entry = next;
+    }
+
+    free(memtable->head);
+    free(memtable);
+}
+
+
+/*!
+ * \brief           Chooses a height for a new memtable entry.
+ * \details         Each level above the first is reached with probability
+ * 1/4, using successive pairs of bits from an xorshift generator.
+ * \param memtable  A pointer to the memtable.
+ * \returns         The height, at least one.
+ */
+
+static size_t random_height(memtable_t * memtable) {
+    uint64_t x = memtable->seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    memtable->seed = x;
+
+    size_t height = 1;
+    while ( height < MEMTABLE_MAX_LEVELS && (x & 3) == 0 ) {
+        ++height;
+        x >>= 2;
+    }
+
+    return height;
+}
+
+
+/*!
+ * \brief           Finds the last entry before a key on every level.
+ * \param memtable  A pointer to the memtable.
+ * \param key       The key.
+ * \param update    An array of `MEMTABLE_MAX_LEVELS` to populate with the
+ * last entry before the key on each level in use.
+ * \returns         A pointer to the entry for the key, or `NULL` if there
+ * is none.
+ */
+
+static memtable_entry_t * memtable_find(memtable_t * memtable,
+                                        const char * key,
+                                        memtable_entry_t ** update) {
+    memtable_entry_t * entry = memtable->head;
+
+    for ( size_t l = memtable->levels; l-- > 0; ) {
+        while ( entry->next[l] && strcmp(entry->next[l]->key, key) < 0 ) {
+            entry = entry->next[l];
+        }
+        if ( update ) {
+            update[l] = entry;
+        }
+    }
+
+    entry = entry->next[0];
+    return (entry && strcmp(entry->key, key) == 0) ? entry : NULL;
+}
+
+
+/*!
+ * \brief           Searches a memtable for a key.
+ * \param memtable  A pointer to the memtable.
+ * \param key       The key.
+ * \returns         A pointer to the value, or `NULL` if the key is not in
+ * the memtable.
+ */
+
+static const lsm_value_t * memtable_get(memtable_t * memtable,
+                                        const char * key) {
+    const memtable_entry_t * entry = memtable_find(memtable, key, NULL);
+    return entry ? entry->value : NULL;
+}
+
+
+/*!
+ * \brief           Sets the value for a key in a memtable.
+ * \param memtable  A pointer to the memtable.
+ * \param key       The key, which is copied if it is new.
+ * \param value     A pointer to the value, which the memtable takes.
+ * \returns         A pointer to the value replaced, which the caller
+ * takes, or `NULL` if the key is new.
+ */
+
+static lsm_value_t * memtable_set(memtable_t * memtable, const char * key,
+                                  lsm_value_t * value) {
+    memtable_entry_t * update[MEMTABLE_MAX_LEVELS];
+    memtable_entry_t * entry = memtable_find(memtable, key, update);
+
+    if ( entry ) {
+        lsm_value_t * old_value = entry->value;
+        entry->value = value;
+        return old_value;
+    }
+
+    const size_t height = random_height(memtable);
+    while ( memtable->levels < height ) {
+        update[memtable->levels++] = memtable->head;
+    }
+
+    entry = new_entry(key, height);
+    entry->value = value;
+    for ( size_t l = 0; l < height; ++l ) {
+        entry->next[l] = update[l]->next[l];
+        update[l]->next[l] = entry;
+    }
+
+    ++memtable->length;
+    return NULL;
+}
+
+
+/*!
+ * \brief           Locks a map's mutex.
+ * \param map       A pointer to the map.
+ */
+
+static void lsm_lock(lsm_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_lock(&map->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't lock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) map;         /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Unlocks a map's mutex.
+ * \param map       A pointer to the map.
+ */
+
+static void lsm_unlock(lsm_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_unlock(&map->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't unlock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) map;         /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Returns the path of a file in a map's directory.
+ * \param map       A pointer to the map.
+ * \param name      The name of the file.
+ * \returns         The path, which should be `free()`d by the caller.
+ */
+
+static char * dir_path(const lsm_map map, const char * name) {
+    const size_t size = strlen(map->dirname) + strlen(name) + 2;
+    char * path = term_malloc(size);
+    snprintf(path, size, "%s/%s", map->dirname, name);
+    return path;
+}
+
+
+/*!
+ * \brief           Returns the path of a run file.
+ * \param map       A pointer to the map.
+ * \param seq       The sequence number of the run.
+ * \returns         The path, which should be `free()`d by the caller.
+ */
+
+static char * run_path(const lsm_map map, const uint64_t seq) {
+    char name[64];
+    snprintf(name, sizeof(name), "run-%020" PRIu64 ".sst", seq);
+    return dir_path(map, name);
+}
+
+
+/*!
+ * \brief           Opens a run from a file.
+ * \details         The run's filter is built by walking its keys,
+ * including those of tombstones, which must also be found. This reads
+ * the whole file, so should not be done with the map locked if it can
+ * be avoided.
+ * \param path      The path of the file.
+ * \param seq       The sequence number of the run.
+ * \param run       A pointer to the run to populate.
+ * \returns         `true` on success, `false` if the file could not be
+ * opened.
+ */
+
+static bool open_run(const char * path, const uint64_t seq,
+                     lsm_run_t * run) {
+    run->table = sstable_open(path);
+
+    if ( run->table == NULL ) {
+        return false;
+    }
+
+    const size_t length = sstable_length(run->table);
+    run->filter = bloom_filter_init(length ? length : 1,
+                                    FILTER_BITS_PER_KEY);
+    run->seq = seq;
+
+    sstable_cursor cursor = sstable_cursor_seek(run->table, NULL);
+    const char * key;
+    while ( sstable_cursor_next(cursor, &key, NULL, NULL) ) {
+        bloom_filter_add(run->filter, cds_filter_hash_string(key));
+    }
+    sstable_cursor_free(cursor);
+
+    return true;
+}
+
+
+/*!
+ * \brief           Loads a run from its file in a map's directory.
+ * \param map       A pointer to the map.
+ * \param seq       The sequence number of the run.
+ * \param run       A pointer to the run to populate.
+ * \returns         `true` on success, `false` if the file could not be
+ * opened.
+ */
+
+static bool load_run(const lsm_map map, const uint64_t seq,
+                     lsm_run_t * run) {
+    char * path = run_path(map, seq);
+    const bool ok = open_run(path, seq, run);
+    free(path);
+    return ok;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a run.
+ * \param run       A pointer to the run.
+ */
+
+static void free_run(lsm_run_t * run) {
+    sstable_close(run->table);
+    bloom_filter_free(run->filter);
+}
+
+
+/*!
+ * \brief           Compares the sequence numbers of two runs.
+ * \param a         A pointer to the first run.
+ * \param b         A pointer to the second run.
+ * \returns         Less than zero, zero or greater than zero if the first
+ * run is older than, the same age as, or newer than the second.
+ */
+
+static int compare_run_seq(const void * a, const void * b) {
+    const uint64_t seq_a = ((const lsm_run_t *) a)->seq;
+    const uint64_t seq_b = ((const lsm_run_t *) b)->seq;
+    return (seq_a > seq_b) - (seq_a < seq_b);
+}
+
+
+/*!
+ * \brief           Loads every run in a map's directory.
+ * \param map       A pointer to the map.
+ * \returns         `true` on success, `false` if the directory could not
+ * be read or a run could not be loaded.
+ */
+
+static bool load_runs(lsm_map map) {
+    DIR * dir = opendir(map->dirname);
+    if ( dir == NULL ) {
+        return false;
+    }
+
+    size_t capacity = 0;
+    bool ok = true;
+    struct dirent * entry;
+
+    while ( ok && (entry = readdir(dir)) ) {
+        uint64_t seq;
+        char trail;
+
+        if ( sscanf(entry->d_name, "run-%" SCNu64 ".ss%c", &seq, &trail) != 2
+             || trail != 't' ) {
+            continue;
+        }
+
+        if ( map->num_runs == capacity ) {
+            capacity = capacity ? capacity * 2 : 8;
+            map->runs = term_realloc(map->runs,
+                                     sizeof(*map->runs) * capacity);
+        }
+
+        ok = load_run(map, seq, &map->runs[map->num_runs]);
+        if ( ok ) {
+            ++map->num_runs;
+            if ( seq >= map->next_seq ) {
+                map->next_seq = seq + 1;
+            }
+        }
+    }
+
+    closedir(dir);
+
+    if ( map->num_runs ) {
+        qsort(map->runs, map->num_runs, sizeof(*map->runs),
+              compare_run_seq);
+    }
+
+    return ok;
+}
+
+
+/*!
+ * \brief           Writes every memtable entry to a run, in key order.
+ * \param memtable  A pointer to the memtable.
+ * \param writer    A pointer to the run writer.
+ */
+
+static void write_memtable(memtable_t * memtable, sstable_writer writer) {
+    const memtable_entry_t * entry = memtable->head->next[0];
+
+    while ( entry ) {
+        const lsm_value_t * value = entry->value;
+        sstable_writer_add(writer, entry->key,
+                           value->deleted ? NULL : value->data, value->len);
+        entry = entry->next[0];
+    }
+}
+
+
+/*!
+ * \brief           Merges runs into a single run file.
+ * \details         Each step takes the least key among the cursors, keeps
+ * the value from the newest run holding it, and advances every cursor
+ * positioned at that key. Since the oldest run is always among those
+ * merged, tombstones have nothing left to hide and are dropped.
+ * \param runs      A pointer to the runs to merge, oldest first.
+ * \param num_runs  The number of runs.
+ * \param path      The path of the file to write.
+ * \returns         Zero on success, or `CDSERR_IO` on failure.
+ */
+
+static int merge_runs(const lsm_run_t * runs, const size_t num_runs,
+                      const char * path) {
+    sstable_writer writer = sstable_writer_open(path);
+    if ( writer == NULL ) {
+        return CDSERR_IO;
+    }
+
+    sstable_cursor * cursors = term_malloc(sizeof(*cursors) * num_runs);
+    const char ** keys = term_malloc(sizeof(*keys) * num_runs);
+    const void ** values = term_malloc(sizeof(*values) * num_runs);
+    size_t * lens = term_malloc(sizeof(*lens) * num_runs);
+    bool * valid = term_malloc(sizeof(*valid) * num_runs);
+
+    for ( size_t i = 0; i < num_runs; ++i ) {
+        cursors[i] = sstable_cursor_seek(runs[i].table, NULL);
+        valid[i] = sstable_cursor_next(cursors[i], &keys[i],
+                                       &values[i], &lens[i]);
+    }
+
+    while ( true ) {
+
+        /*  Newer runs win ties, since they are scanned last  */
+
+        size_t least = num_runs;
+        for ( size_t i = 0; i < num_runs; ++i ) {
+            if ( valid[i] && (least == num_runs ||
+                              strcmp(keys[i], keys[least]) <= 0) ) {
+                least = i;
+            }
+        }
+
+        if ( least == num_runs ) {
+            break;
+        }
+
+        if ( values[least] ) {
+            sstable_writer_add(writer, keys[least],
+                               values[least], lens[least]);
+        }
+
+        for ( size_t i = 0; i < num_runs; ++i ) {
+            if ( i != least && valid[i] &&
+                 strcmp(keys[i], keys[least]) == 0 ) {
+                valid[i] = sstable_cursor_next(cursors[i], &keys[i],
+                                               &values[i], &lens[i]);
+            }
+        }
+        valid[least] = sstable_cursor_next(cursors[least], &keys[least],
+                                           &values[least], &lens[least]);
+    }
+
+    for ( size_t i = 0; i < num_runs; ++i ) {
+        sstable_cursor_free(cursors[i]);
+    }
+
+    free(cursors);
+    free(keys);
+    free(values);
+    free(lens);
+    free(valid);
+
+    return sstable_writer_close(writer);
+}
+
+
+/*!
+ * \brief           Merges runs into a single run, ready to be installed.
+ * \details         The merged file is written and opened, and its filter
+ * built, without the map, so this may be done with the map unlocked as
+ * long as the runs stay put.
+ * \param runs      A pointer to the runs to merge, oldest first.
+ * \param num_runs  The number of runs.
+ * \param path      The path of the file to write.
+ * \param merged    A pointer to the run to populate, which takes the
+ * sequence number of the oldest input, since it will replace it.
+ * \returns         Zero on success, or `CDSERR_IO` on failure, in which
+ * case the file is removed.
+ */
+
+static int build_merged(const lsm_run_t * runs, const size_t num_runs,
+                        const char * path, lsm_run_t * merged) {
+    int status = merge_runs(runs, num_runs, path);
+
+    if ( status == 0 && !open_run(path, runs[0].seq, merged) ) {
+        status = CDSERR_IO;
+    }
+
+    if ( status != 0 ) {
+        remove(path);
+    }
+
+    return status;
+}
+
+
+/*!
+ * \brief           Replaces merged runs with the run merged from them.
+ * \details         The merged file replaces the oldest input, and the
+ * other inputs are then removed oldest first. The map must be locked,
+ * but the merged run is already open, so this touches no file contents.
+ * \param map       A pointer to the map.
+ * \param num_runs  The number of runs, from the oldest, which were merged.
+ * \param path      The path of the merged file.
+ * \param merged    A pointer to the merged run, from build_merged().
+ * \returns         Zero on success, or `CDSERR_IO` if the merged file
+ * could not be renamed, in which case the merged run is freed and its file
+ * removed, and the runs, and their files, are left unchanged.
+ */
+
+static int install_merged(lsm_map map, const size_t num_runs,
+                          const char * path, lsm_run_t * merged) {
+    char * target = run_path(map, map->runs[0].seq);
+    const int status = rename(path, target);
+    free(target);
+
+    if ( status != 0 ) {
+        free_run(merged);
+        remove(path);
+        return CDSERR_IO;
+    }
+
+    for ( size_t i = 0; i < num_runs; ++i ) {
+        if ( i > 0 ) {
+            char * old_path = run_path(map, map->runs[i].seq);
+            remove(old_path);
+            free(old_path);
+        }
+        free_run(&map->runs[i]);
+    }
+
+    map->runs[0] = *merged;
+    memmove(map->runs + 1, map->runs + num_runs,
+            sizeof(*map->runs) * (map->num_runs - num_runs));
+    map->num_runs -= num_runs - 1;
+
+    return 0;
+}
+
+
+/*!
+ * \brief           Merges all of a map's runs in the calling thread.
+ * \details         The map must be locked.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` on failure.
+ */
+
+static int compact_locked(lsm_map map) {
+    if ( map->num_runs < 2 ) {
+        return 0;
+    }
+
+    char * path = dir_path(map, COMPACT_TMP_NAME);
+    lsm_run_t merged;
+    int status = build_merged(map->runs, map->num_runs, path, &merged);
+
+    if ( status == 0 ) {
+        status = install_merged(map, map->num_runs, path, &merged);
+    }
+
+    free(path);
+    return status;
+}
+
+
+#ifdef CDS_THREAD_SUPPORT
+
+/*!
+ * \brief           Background compaction thread function.
+ * \details         Waits for enough runs to accumulate, then merges the
+ * runs present at that moment, and opens the merged run, with the map
+ * unlocked, so that searches and writes, including new runs being added,
+ * can proceed meanwhile. The map is locked only to swap the merged run
+ * in.
+ * \param arg       A pointer to the map.
+ * \returns         `NULL`.
+ */
+
+static void * compactor_thread(void * arg) {
+    lsm_map map = arg;
+    char * path = dir_path(map, COMPACT_TMP_NAME);
+
+    lsm_lock(map);
+
+    while ( true ) {
+        while ( !map->stopping && map->num_runs < COMPACT_RUNS ) {
+            pthread_cond_wait(&map->cond, &map->mutex);
+        }
+
+        if ( map->stopping ) {
+            break;
+        }
+
+        /*  Runs are only removed by compaction, so the first
+         *  num_runs runs stay put while the map is unlocked.  */
+
+        const size_t num_runs = map->num_runs;
+        lsm_run_t * runs = term_malloc(sizeof(*runs) * num_runs);
+        memcpy(runs, map->runs, sizeof(*runs) * num_runs);
+        map->compacting = true;
+
+        lsm_run_t merged;
+        lsm_unlock(map);
+        int status = build_merged(runs, num_runs, path, &merged);
+        lsm_lock(map);
+
+        if ( status == 0 ) {
+            status = install_merged(map, num_runs, path, &merged);
+        }
+
+        free(runs);
+        map->compacting = false;
+        pthread_cond_broadcast(&map->cond);
+
+        if ( status != 0 ) {
+
+            /*  Don't spin on a failing disk, wait for another run  */
+
+            const size_t failed_runs = map->num_runs;
+            while ( !map->stopping && map->num_runs == failed_runs ) {
+                pthread_cond_wait(&map->cond, &map->mutex);
+            }
+        }
+    }
+
+    lsm_unlock(map);
+    free(path);
+    return NULL;
+}
+
+#endif
+
+
+/*!
+ * \brief           Writes a map's memtable out as a new run.
+ * \details         The map must be locked.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` on failure, in which
+ * case the memtable is kept.
+ */
+
+static int flush_locked(lsm_map map) {
+    if ( map->memtable->length == 0 ) {
+        return 0;
+    }
+
+    char * tmp_path = dir_path(map, FLUSH_TMP_NAME);
+    sstable_writer writer = sstable_writer_open(tmp_path);
+    if ( writer == NULL ) {
+        free(tmp_path);
+        return CDSERR_IO;
+    }
+
+    write_memtable(map->memtable, writer);
+
+    const uint64_t seq = map->next_seq;
+    char * path = run_path(map, seq);
+    int status = sstable_writer_close(writer);
+
+    if ( status == 0 && rename(tmp_path, path) != 0 ) {
+        status = CDSERR_IO;
+    }
+
+    free(tmp_path);
+    free(path);
+
+    lsm_run_t run;
+    if ( status != 0 || !load_run(map, seq, &run) ) {
+        return CDSERR_IO;
+    }
+
+    ++map->next_seq;
+    map->runs = term_realloc(map->runs,
+                             sizeof(*map->runs) * (map->num_runs + 1));
+    map->runs[map->num_runs++] = run;
+
+    memtable_free(map->memtable);
+    map->memtable = memtable_init();
+    map->memtable_bytes = 0;
+
+    if ( map->num_runs >= COMPACT_RUNS ) {
+#ifdef CDS_THREAD_SUPPORT
+        pthread_cond_broadcast(&map->cond);
+#else
+        status = compact_locked(map);
+#endif
+    }
+
+    return status;
+}
+
+
+/*!
+ * \brief           Adds an entry to a map's memtable.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \param value     A pointer to the value, or `NULL` for a tombstone.
+ * \param len       The length of the value.
+ * \returns         Zero on success, or `CDSERR_IO` if the memtable had
+ * to be written out and could not be.
+ */
+
+static int memtable_put(lsm_map map, const char * key,
+                        const void * value, const size_t len) {
+    lsm_value_t * new_value = term_malloc(sizeof(*new_value) + len);
+    new_value->len = len;
+    new_value->deleted = (value == NULL);
+    if ( len ) {
+        memcpy(new_value->data, value, len);
+    }
+
+    lsm_lock(map);
+
+    lsm_value_t * old_value = memtable_set(map->memtable, key, new_value);
+    if ( old_value ) {
+        map->memtable_bytes -= old_value->len;
+        free(old_value);
+    } else {
+        map->memtable_bytes += strlen(key) + sizeof(*new_value);
+    }
+
+    map->memtable_bytes += len;
+
+    int status = 0;
+    if ( map->memtable_bytes >= map->memtable_limit ) {
+        status = flush_locked(map);
+    }
+
+    lsm_unlock(map);
+    return status;
+}
+
+
+/*!
+ * \brief           Opens a log-structured merge map.
+ * \details         Any runs already in the directory are loaded, so a
+ * map written and closed earlier is reopened with its contents.
+ * \param dirname   The directory holding the map's files, which is
+ * created if it does not exist.
+ * \param memtable_size The approximate size in bytes at which the
+ * memtable is written out as a run, or zero for a default of 4MB.
+ * \returns         A pointer to the map, or `NULL` if the directory
+ * could not be created or read.
+ */
+
+lsm_map lsm_map_open(const char * dirname, const size_t memtable_size) {
+    if ( mkdir(dirname, 0777) != 0 && errno != EEXIST ) {
+        return NULL;
+    }
+
+    lsm_map new_map = term_malloc(sizeof(*new_map));
+    new_map->dirname = term_strdup(dirname);
+    new_map->memtable = memtable_init();
+    new_map->memtable_bytes = 0;
+    new_map->memtable_limit = memtable_size ? memtable_size
+                                            : DEFAULT_MEMTABLE_SIZE;
+    new_map->runs = NULL;
+    new_map->num_runs = 0;
+    new_map->next_seq = 1;
+
+    if ( !load_runs(new_map) ) {
+        for ( size_t i = 0; i < new_map->num_runs; ++i ) {
+            free_run(&new_map->runs[i]);
+        }
+        free(new_map->runs);
+        memtable_free(new_map->memtable);
+        free(new_map->dirname);
+        free(new_map);
+        return NULL;
+    }
+
+#ifdef CDS_THREAD_SUPPORT
+    new_map->compacting = false;
+    new_map->stopping = false;
+
+    if ( pthread_mutex_init(&new_map->mutex, NULL) != 0 ||
+         pthread_cond_init(&new_map->cond, NULL) != 0 ||
+         pthread_create(&new_map->compactor, NULL,
+                        compactor_thread, new_map) != 0 ) {
+        fputs("cdatastruct error: couldn't start compaction thread.",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
+    return new_map;
+}
+
+
+/*!
+ * \brief           Closes a log-structured merge map.
+ * \details         Any compaction in progress is completed, the memtable
+ * is written out, and the map's resources are freed whether or not that
+ * succeeds.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` if the memtable
+ * could not be written, in which case its contents are lost.
+ */
+
+int lsm_map_close(lsm_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    lsm_lock(map);
+    map->stopping = true;
+    pthread_cond_broadcast(&map->cond);
+    lsm_unlock(map);
+
+    pthread_join(map->compactor, NULL);
+    pthread_cond_destroy(&map->cond);
+    pthread_mutex_destroy(&map->mutex);
+#endif
+
+    const int status = flush_locked(map);
+
+    for ( size_t i = 0; i < map->num_runs; ++i ) {
+        free_run(&map->runs[i]);
+    }
+
+    free(map->runs);
+    memtable_free(map->memtable);
+    free(map->dirname);
+    free(map);
+
+    return status;
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into a log-structured
+ * merge map.
+ * \details         The value is copied, and replaces any existing value
+ * for the key.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \param value     A pointer to the value. If this is NULL, an empty value
+ * is inserted, whatever `len` is.
+ * \param len       The length of the value.
+ * \returns         Zero on success, or `CDSERR_IO` if the memtable had
+ * to be written out and could not be. The value is inserted either way.
+ */
+
+int lsm_map_insert(lsm_map map, const char * key,
+                   const void * value, const size_t len) {
+    if ( value == NULL ) {
+        return memtable_put(map, key, "", 0);
+    }
+
+    return memtable_put(map, key, value, len);
+}
+
+
+/*!
+ * \brief           Deletes a key from a log-structured merge map.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \returns         Zero on success, or `CDSERR_IO` if the memtable had
+ * to be written out and could not be. The key is deleted either way.
+ */
+
+int lsm_map_delete(lsm_map map, const char * key) {
+    return memtable_put(map, key, NULL, 0);
+}
+
+
+/*!
+ * \brief           Determines if a key is in a log-structured merge map.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool lsm_map_search(lsm_map map, const char * key) {
+    void * value = lsm_map_search_data(map, key, NULL);
+    const bool found = value ? true : false;
+    free(value);
+    return found;
+}
+
+
+/*!
+ * \brief           Searches a log-structured merge map for a value
+ * matching a key and returns a copy of it.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \param len       A pointer to populate with the length of the value.
+ * This parameter is ignored if set to NULL.
+ * \returns         A pointer to a copy of the value if found, which
+ * should be `free()`d by the caller, or `NULL` otherwise.
+ */
+
+void * lsm_map_search_data(lsm_map map, const char * key, size_t * len) {
+    const void * value = NULL;
+    size_t value_len = 0;
+    void * copy = NULL;
+
+    lsm_lock(map);
+
+    const lsm_value_t * lvalue = memtable_get(map->memtable, key);
+
+    if ( lvalue ) {
+        if ( !lvalue->deleted ) {
+            value = lvalue->data;
+            value_len = lvalue->len;
+        }
+    } else {
+        const uint64_t hash = cds_filter_hash_string(key);
+        size_t i = map->num_runs;
+
+        while ( i-- > 0 ) {
+            const lsm_run_t * run = &map->runs[i];
+            if ( bloom_filter_query(run->filter, hash) &&
+                 sstable_find(run->table, key, &value, &value_len) ) {
+                break;
+            }
+        }
+    }
+
+    if ( value ) {
+        copy = term_malloc(value_len ? value_len : 1);
+        memcpy(copy, value, value_len);
+        if ( len ) {
+            *len = value_len;
+        }
+    }
+
+    lsm_unlock(map);
+    return copy;
+}
+
+
+/*!
+ * \brief           Writes a log-structured merge map's memtable out as
+ * a new run.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` on failure.
+ */
+
+int lsm_map_flush(lsm_map map) {
+    lsm_lock(map);
+    const int status = flush_locked(map);
+    lsm_unlock(map);
+    return status;
+}
+
+
+/*!
+ * \brief           Merges all of a log-structured merge map's runs into
+ * one.
+ * \details         The merge is done in the calling thread, with the map
+ * locked, after waiting for any background compaction to finish.
+ * \param map       A pointer to the map.
+ * \returns         Zero on success, or `CDSERR_IO` on failure.
+ */
+
+int lsm_map_compact(lsm_map map) {
+    lsm_lock(map);
+
+#ifdef CDS_THREAD_SUPPORT
+    while ( map->compacting ) {
+        pthread_cond_wait(&map->cond, &map->mutex);
+    }
+#endif
+
+    const int status = compact_locked(map);
+    lsm_unlock(map);
+    return status;
+}
+
+
+/*!
+ * \brief           Returns the number of runs in a log-structured merge
+ * map.
+ * \param map       A pointer to the map.
+ * \returns         The number of runs.
+ */
+
+size_t lsm_map_num_runs(lsm_map map) {
+    lsm_lock(map);
+    const size_t num_runs = map->num_runs;
+    lsm_unlock(map);
+    return num_runs;
+}
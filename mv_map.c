@@ -0,0 +1,773 @@
+/*!
+ * \file            mv_map.c
+ * \brief           Implementation of multiversion map data structure.
+ * \details         Each key holds a chain of versions, newest first, and
+ * each version is stamped with the value of a global commit counter at
+ * the time it was written. A snapshot records the counter when it is
+ * opened, and sees the newest version of each key stamped no later than
+ * that, so a scan over a snapshot sees exactly the writes committed
+ * before it started, however long it takes.
+ *
+ * The keys are held in a skip list, so that searches and writes take
+ * logarithmic time whatever order the keys are written in. Writers are
+ * serialized by a mutex, but readers take no lock. A writer fully builds
+ * a new version or node before publishing it with release stores, linking
+ * a node into its levels from the bottom up, so a reader descending the
+ * levels with acquire loads only ever sees complete nodes and versions.
+ * A deletion is written as a tombstone version.
+ *
+ * mv_map_gc() frees the versions which no open snapshot can see, which
+ * for each key are those older than the newest version visible to the
+ * oldest snapshot. No reader ever walks a chain past that version, so
+ * the pass is safe to run in a background thread alongside readers. A
+ * key whose newest version is a tombstone visible to every snapshot is
+ * unlinked from the skip list altogether. A reader may still be standing
+ * on such a node, and its links are left intact so that the reader can
+ * move on, so the node is only freed by a later pass once every snapshot
+ * open when it was unlinked has been closed.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_mv_map.h"
+
+#ifdef CDS_THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+
+/*!
+ * \brief           Maximum number of skip list levels.
+ * \details         A node reaches each level with probability 1/4, so
+ * this suffices for maps of around four billion keys.
+ */
+
+#define MAX_LEVELS 16
+
+
+/*!
+ * \brief           Loads a shared pointer or counter with acquire
+ * ordering.
+ */
+
+#define LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+
+
+/*!
+ * \brief           Stores a shared pointer or counter with release
+ * ordering.
+ */
+
+#define STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+/*!
+ * \brief           Struct for a version of a value.
+ */
+
+typedef struct mv_version_t {
+    uint64_t stamp;             /*!< Commit stamp */
+    void * value;               /*!< Pointer to value */
+    bool deleted;               /*!< Set if version is a tombstone */
+    struct mv_version_t * older;    /*!< Pointer to next older version */
+} mv_version_t;
+
+
+/*!
+ * \brief           Struct for a skip list node.
+ * \details         The key string follows the links in the same
+ * allocation.
+ */
+
+typedef struct mv_node_t {
+    mv_version_t * head;        /*!< Pointer to newest version */
+    const char * key;           /*!< Key string */
+    size_t height;              /*!< Number of levels linked into */
+    struct mv_node_t * retired; /*!< Next node unlinked with this one */
+    struct mv_node_t * next[];  /*!< Next nodes, lowest level first */
+} mv_node_t;
+
+
+/*!
+ * \brief           Struct for a batch of unlinked nodes awaiting freeing.
+ */
+
+typedef struct mv_retired_t {
+    uint64_t seq;               /*!< Sequence number of next snapshot */
+    mv_node_t * nodes;          /*!< Nodes, linked through `retired` */
+    struct mv_retired_t * next; /*!< Pointer to next older batch */
+} mv_retired_t;
+
+
+/*!
+ * \brief           Struct to contain a multiversion map.
+ */
+
+typedef struct mv_map_t {
+#ifdef CDS_THREAD_SUPPORT
+    pthread_mutex_t mutex;      /*!< Mutex serializing writers */
+    pthread_mutex_t snap_mutex; /*!< Mutex protecting snapshot list */
+#endif
+    mv_node_t * head;           /*!< Head node, with every level */
+    uint64_t seed;              /*!< Random node height state */
+    uint64_t commit;            /*!< Stamp of last commit */
+    struct mv_map_snapshot_t * snapshots;   /*!< List of open snapshots */
+    uint64_t snap_seq;          /*!< Sequence number for next snapshot */
+    mv_retired_t * retired;     /*!< Unlinked node batches, newest first */
+} mv_map_t;
+
+
+/*!
+ * \brief           Struct to contain a snapshot.
+ */
+
+typedef struct mv_map_snapshot_t {
+    mv_map map;                 /*!< Pointer to map */
+    uint64_t stamp;             /*!< Commit stamp visible to snapshot */
+    uint64_t seq;               /*!< Sequence number of opening */
+    struct mv_map_snapshot_t * prev;    /*!< Previous open snapshot */
+    struct mv_map_snapshot_t * next;    /*!< Next open snapshot */
+} mv_map_snapshot_t;
+
+
+/*!
+ * \brief           Locks a map's writer mutex.
+ * \param map       A pointer to the map.
+ */
+
+static void mv_lock(mv_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_lock(&map->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't lock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) map;         /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Unlocks a map's writer mutex.
+ * \param map       A pointer to the map.
+ */
+
+static void mv_unlock(mv_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_unlock(&map->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't unlock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) map;         /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Locks a map's snapshot list mutex.
+ * \param map       A pointer to the map.
+ */
+
+static void snapshot_lock(mv_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_lock(&map->snap_mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't lock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) map;         /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Unlocks a map's snapshot list mutex.
+ * \param map       A pointer to the map.
+ */
+
+static void snapshot_unlock(mv_map map) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_unlock(&map->snap_mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't unlock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) map;         /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Frees a chain of versions and their values.
+ * \param version   A pointer to the newest version to free.
+ * \returns         The number of versions freed.
+ */
+
+static size_t free_versions(mv_version_t * version) {
+    size_t count = 0;
+
+    while ( version ) {
+        mv_version_t * older = version->older;
+        free(version->value);
+        free(version);
+        version = older;
+        ++count;
+    }
+
+    return count;
+}
+
+
+/*!
+ * \brief           Creates a new skip list node.
+ * \param key       The key, which is copied, or `NULL` for the head.
+ * \param height    The number of levels the node is linked into.
+ * \returns         A pointer to the new node.
+ */
+
+static mv_node_t * new_node(const char * key, const size_t height) {
+    const size_t key_size = key ? strlen(key) + 1 : 0;
+    mv_node_t * node = term_malloc(sizeof(*node) +
+                                   sizeof(*node->next) * height + key_size);
+    node->head = NULL;
+    node->height = height;
+    node->retired = NULL;
+    for ( size_t l = 0; l < height; ++l ) {
+        node->next[l] = NULL;
+    }
+
+    if ( key ) {
+        char * key_copy = (char *) (node->next + height);
+        memcpy(key_copy, key, key_size);
+        node->key = key_copy;
+    } else {
+        node->key = NULL;
+    }
+
+    return node;
+}
+
+
+/*!
+ * \brief           Frees a node and all its versions.
+ * \param node      A pointer to the node.
+ * \returns         The number of versions freed.
+ */
+
+static size_t free_node(mv_node_t * node) {
+    const size_t count = free_versions(node->head);
+    free(node);
+    return count;
+}
+
+
+/*!
+ * \brief           Chooses a height for a new node.
+ * \details         The caller must hold the writer mutex. Each level
+ * above the first is reached with probability 1/4, using successive pairs
+ * of bits from an xorshift generator.
+ * \param map       A pointer to the map.
+ * \returns         The height, at least one.
+ */
+
+static size_t random_height(mv_map map) {
+    uint64_t x = map->seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    map->seed = x;
+
+    size_t height = 1;
+    while ( height < MAX_LEVELS && (x & 3) == 0 ) {
+        ++height;
+        x >>= 2;
+    }
+
+    return height;
+}
+
+
+/*!
+ * \brief           Finds the node for a key without locking.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \param update    An array of `MAX_LEVELS` to populate with the last node
+ * before the key on each level, or `NULL`. This should only be passed by
+ * a caller holding the writer mutex.
+ * \returns         A pointer to the node, or `NULL` if the key is not in
+ * the skip list.
+ */
+
+static mv_node_t * find_node(mv_map map, const char * key,
+                             mv_node_t ** update) {
+    mv_node_t * node = map->head;
+
+    for ( size_t l = MAX_LEVELS; l-- > 0; ) {
+        mv_node_t * next;
+        while ( (next = LOAD_ACQUIRE(&node->next[l])) &&
+                strcmp(next->key, key) < 0 ) {
+            node = next;
+        }
+        if ( update ) {
+            update[l] = node;
+        }
+    }
+
+    node = LOAD_ACQUIRE(&node->next[0]);
+    return (node && strcmp(node->key, key) == 0) ? node : NULL;
+}
+
+
+/*!
+ * \brief           Gets the version of a node visible at a commit stamp.
+ * \param node      A pointer to the node.
+ * \param stamp     The commit stamp.
+ * \returns         A pointer to the newest version stamped no later than
+ * `stamp`, or `NULL` if there is none.
+ */
+
+static mv_version_t * visible_version(mv_node_t * node,
+                                      const uint64_t stamp) {
+    mv_version_t * version = LOAD_ACQUIRE(&node->head);
+
+    while ( version && version->stamp > stamp ) {
+        version = LOAD_ACQUIRE(&version->older);
+    }
+
+    return version;
+}
+
+
+/*!
+ * \brief           Commits a new version of a key.
+ * \details         The caller must hold the writer mutex. A new node is
+ * linked into each of its levels from the bottom up, so a reader which
+ * finds it on any level also finds it on the levels below. The version is
+ * published before the commit counter, so a reader which sees the new
+ * stamp always finds the version.
+ * \param map       A pointer to the map.
+ * \param node      A pointer to the key's node, or `NULL` if it has none.
+ * \param update    The last node before the key on each level, from
+ * find_node().
+ * \param key       The key.
+ * \param value     A pointer to the value, or `NULL` for a tombstone.
+ * \param deleted   `true` if the version is a tombstone.
+ * \returns         The commit stamp of the new version.
+ */
+
+static uint64_t commit_version(mv_map map, mv_node_t * node,
+                               mv_node_t ** update, const char * key,
+                               void * value, const bool deleted) {
+    const uint64_t stamp = map->commit + 1;
+
+    mv_version_t * version = term_malloc(sizeof(*version));
+    version->stamp = stamp;
+    version->value = value;
+    version->deleted = deleted;
+
+    if ( node ) {
+        version->older = node->head;
+        STORE_RELEASE(&node->head, version);
+    } else {
+        node = new_node(key, random_height(map));
+        node->head = version;
+        version->older = NULL;
+
+        for ( size_t l = 0; l < node->height; ++l ) {
+            node->next[l] = update[l]->next[l];
+        }
+        for ( size_t l = 0; l < node->height; ++l ) {
+            STORE_RELEASE(&update[l]->next[l], node);
+        }
+    }
+
+    STORE_RELEASE(&map->commit, stamp);
+    return stamp;
+}
+
+
+/*!
+ * \brief           Frees versions hidden from all snapshots, and unlinks
+ * the nodes of keys deleted for all of them.
+ * \details         The caller must hold the writer mutex. Unlinked nodes
+ * keep their own links, since a reader may still be standing on one.
+ * \param map       A pointer to the map.
+ * \param stamp     The oldest commit stamp visible to any snapshot.
+ * \param unlinked  A pointer to populate with the unlinked nodes, linked
+ * through their `retired` member, or `NULL` if there are none.
+ * \returns         The number of versions freed.
+ */
+
+static size_t gc_nodes(mv_map map, const uint64_t stamp,
+                       mv_node_t ** unlinked) {
+    mv_node_t * update[MAX_LEVELS];
+    for ( size_t l = 0; l < MAX_LEVELS; ++l ) {
+        update[l] = map->head;
+    }
+
+    size_t count = 0;
+    *unlinked = NULL;
+
+    for ( mv_node_t * node = map->head->next[0]; node;
+          node = node->next[0] ) {
+        mv_version_t * keep = visible_version(node, stamp);
+        if ( keep && keep->older ) {
+            mv_version_t * hidden = keep->older;
+            STORE_RELEASE(&keep->older, NULL);
+            count += free_versions(hidden);
+        }
+
+        /*  The last node on each level before this one links to it  */
+
+        if ( keep && keep == node->head && keep->deleted ) {
+            for ( size_t l = node->height; l-- > 0; ) {
+                STORE_RELEASE(&update[l]->next[l], node->next[l]);
+            }
+            node->retired = *unlinked;
+            *unlinked = node;
+        } else {
+            for ( size_t l = 0; l < node->height; ++l ) {
+                update[l] = node;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+/*!
+ * \brief           Frees the unlinked nodes which no reader can reach.
+ * \details         The caller must hold the writer mutex.
+ * \param map       A pointer to the map.
+ * \param seq       The sequence number of the oldest open snapshot, or of
+ * the next snapshot if none is open. Nodes unlinked before that snapshot
+ * was opened are freed.
+ * \returns         The number of versions freed.
+ */
+
+static size_t free_retired(mv_map map, const uint64_t seq) {
+    mv_retired_t ** p_batch = &map->retired;
+    size_t count = 0;
+
+    while ( *p_batch ) {
+        mv_retired_t * batch = *p_batch;
+
+        if ( batch->seq <= seq ) {
+            while ( batch->nodes ) {
+                mv_node_t * next = batch->nodes->retired;
+                count += free_node(batch->nodes);
+                batch->nodes = next;
+            }
+            *p_batch = batch->next;
+            free(batch);
+        } else {
+            p_batch = &batch->next;
+        }
+    }
+
+    return count;
+}
+
+
+/*!
+ * \brief           Initializes a new multiversion map.
+ * \returns         A pointer to the new map.
+ */
+
+mv_map mv_map_init(void) {
+    mv_map new_map = term_malloc(sizeof(*new_map));
+    new_map->head = new_node(NULL, MAX_LEVELS);
+    new_map->seed = 0x9E3779B97F4A7C15ULL;
+    new_map->commit = 0;
+    new_map->snapshots = NULL;
+    new_map->snap_seq = 0;
+    new_map->retired = NULL;
+
+#ifdef CDS_THREAD_SUPPORT
+    if ( pthread_mutex_init(&new_map->mutex, NULL) != 0 ||
+         pthread_mutex_init(&new_map->snap_mutex, NULL) != 0 ) {
+        fputs("cdatastruct error: couldn't initialize mutex", stderr);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
+    return new_map;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a multiversion map.
+ * \details         All the map's snapshots must have been closed. Any
+ * memory consumed by the values of every version is automatically
+ * `free()`d.
+ * \param map       A pointer to the map.
+ */
+
+void mv_map_free(mv_map map) {
+    if ( map->snapshots ) {
+        fputs("cdatastruct error: freeing map with open snapshots.",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+#ifdef CDS_THREAD_SUPPORT
+    if ( pthread_mutex_destroy(&map->mutex) != 0 ||
+         pthread_mutex_destroy(&map->snap_mutex) != 0 ) {
+        fputs("cdatastruct error: couldn't destroy mutex", stderr);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
+    free_retired(map, map->snap_seq);
+
+    mv_node_t * node = map->head;
+    while ( node ) {
+        mv_node_t * next = node->next[0];
+        free_node(node);
+        node = next;
+    }
+
+    free(map);
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into a multiversion map.
+ * \details         The value becomes the newest version of the key, and
+ * is visible to snapshots opened after the insertion returns. The map
+ * takes ownership of the value, and `free()`s it once no snapshot can
+ * see it.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \param value     A pointer to the value.
+ * \returns         The commit stamp of the insertion.
+ */
+
+uint64_t mv_map_insert(mv_map map, const char * key, void * value) {
+    mv_node_t * update[MAX_LEVELS];
+
+    mv_lock(map);
+    mv_node_t * node = find_node(map, key, update);
+    const uint64_t stamp = commit_version(map, node, update,
+                                          key, value, false);
+    mv_unlock(map);
+    return stamp;
+}
+
+
+/*!
+ * \brief           Deletes a key from a multiversion map.
+ * \details         Snapshots opened before the deletion still see the
+ * key's earlier value.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \returns         The commit stamp of the deletion, or zero if the key
+ * was not in the map, in which case nothing is committed.
+ */
+
+uint64_t mv_map_delete(mv_map map, const char * key) {
+    mv_node_t * update[MAX_LEVELS];
+    uint64_t stamp = 0;
+
+    mv_lock(map);
+    mv_node_t * node = find_node(map, key, update);
+    if ( node && !node->head->deleted ) {
+        stamp = commit_version(map, node, update, key, NULL, true);
+    }
+    mv_unlock(map);
+
+    return stamp;
+}
+
+
+/*!
+ * \brief           Frees versions which no snapshot can see.
+ * \details         Readers are not blocked, so this may be called
+ * periodically from a background thread. Writers wait for it to finish.
+ * A key deleted for every snapshot is unlinked, and its node and
+ * tombstone are freed by a later call once the snapshots open now have
+ * been closed.
+ * \param map       A pointer to the map.
+ * \returns         The number of versions freed.
+ */
+
+size_t mv_map_gc(mv_map map) {
+    mv_lock(map);
+
+    /*  Any snapshot opened after this sees at least the current commit  */
+
+    snapshot_lock(map);
+    uint64_t oldest = map->commit;
+    uint64_t oldest_seq = map->snap_seq;
+    for ( mv_map_snapshot_t * snapshot = map->snapshots;
+          snapshot; snapshot = snapshot->next ) {
+        if ( snapshot->stamp < oldest ) {
+            oldest = snapshot->stamp;
+        }
+        if ( snapshot->seq < oldest_seq ) {
+            oldest_seq = snapshot->seq;
+        }
+    }
+    snapshot_unlock(map);
+
+    size_t count = free_retired(map, oldest_seq);
+
+    mv_node_t * unlinked;
+    count += gc_nodes(map, oldest, &unlinked);
+
+    /*  Snapshots opened from now on cannot reach the unlinked nodes  */
+
+    if ( unlinked ) {
+        mv_retired_t * batch = term_malloc(sizeof(*batch));
+        batch->nodes = unlinked;
+        snapshot_lock(map);
+        batch->seq = map->snap_seq;
+        snapshot_unlock(map);
+        batch->next = map->retired;
+        map->retired = batch;
+    }
+
+    mv_unlock(map);
+    return count;
+}
+
+
+/*!
+ * \brief           Opens a snapshot of a multiversion map.
+ * \details         The snapshot sees every write committed before it was
+ * opened and none after, and values it returns remain valid until it is
+ * closed.
+ * \param map       A pointer to the map.
+ * \returns         A pointer to the new snapshot.
+ */
+
+mv_map_snapshot mv_map_snapshot_open(mv_map map) {
+    mv_map_snapshot snapshot = term_malloc(sizeof(*snapshot));
+    snapshot->map = map;
+    snapshot->prev = NULL;
+
+    snapshot_lock(map);
+    snapshot->stamp = LOAD_ACQUIRE(&map->commit);
+    snapshot->seq = map->snap_seq++;
+    snapshot->next = map->snapshots;
+    if ( map->snapshots ) {
+        map->snapshots->prev = snapshot;
+    }
+    map->snapshots = snapshot;
+    snapshot_unlock(map);
+
+    return snapshot;
+}
+
+
+/*!
+ * \brief           Closes a snapshot.
+ * \details         Versions only the snapshot could see are freed by the
+ * next call to mv_map_gc().
+ * \param snapshot  A pointer to the snapshot.
+ */
+
+void mv_map_snapshot_close(mv_map_snapshot snapshot) {
+    mv_map map = snapshot->map;
+
+    snapshot_lock(map);
+    if ( snapshot->prev ) {
+        snapshot->prev->next = snapshot->next;
+    } else {
+        map->snapshots = snapshot->next;
+    }
+    if ( snapshot->next ) {
+        snapshot->next->prev = snapshot->prev;
+    }
+    snapshot_unlock(map);
+
+    free(snapshot);
+}
+
+
+/*!
+ * \brief           Returns the commit stamp of a snapshot.
+ * \param snapshot  A pointer to the snapshot.
+ * \returns         The stamp of the last commit the snapshot sees.
+ */
+
+uint64_t mv_map_snapshot_timestamp(const mv_map_snapshot snapshot) {
+    return snapshot->stamp;
+}
+
+
+/*!
+ * \brief           Searches a snapshot for a key.
+ * \param snapshot  A pointer to the snapshot.
+ * \param key       The key.
+ * \returns         `true` if the key is in the snapshot, `false`
+ * otherwise.
+ */
+
+bool mv_map_snapshot_search(const mv_map_snapshot snapshot,
+                            const char * key) {
+    mv_node_t * node = find_node(snapshot->map, key, NULL);
+    if ( node == NULL ) {
+        return false;
+    }
+
+    mv_version_t * version = visible_version(node, snapshot->stamp);
+    return version && !version->deleted;
+}
+
+
+/*!
+ * \brief           Searches a snapshot for a key and returns its value.
+ * \param snapshot  A pointer to the snapshot.
+ * \param key       The key.
+ * \returns         A pointer to the value, or `NULL` if the key is not
+ * in the snapshot. The value remains owned by the map.
+ */
+
+void * mv_map_snapshot_search_data(const mv_map_snapshot snapshot,
+                                   const char * key) {
+    mv_node_t * node = find_node(snapshot->map, key, NULL);
+    if ( node == NULL ) {
+        return NULL;
+    }
+
+    mv_version_t * version = visible_version(node, snapshot->stamp);
+    return version && !version->deleted ? version->value : NULL;
+}
+
+
+/*!
+ * \brief           Traverses the pairs in a snapshot in key order.
+ * \param snapshot  A pointer to the snapshot.
+ * \param kvfunc    A pointer to the function to invoke for each pair.
+ * The function is passed the key, the value, and `arg`.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+void mv_map_snapshot_traverse(const mv_map_snapshot snapshot,
+        void (*kvfunc)(const char *, void *, void *), void * arg) {
+    mv_node_t * node = LOAD_ACQUIRE(&snapshot->map->head->next[0]);
+
+    while ( node ) {
+        mv_version_t * version = visible_version(node, snapshot->stamp);
+        if ( version && !version->deleted ) {
+            kvfunc(node->key, version->value, arg);
+        }
+        node = LOAD_ACQUIRE(&node->next[0]);
+    }
+}
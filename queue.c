@@ -26,7 +26,7 @@
  */
 
 queue queue_init(void (*free_func)(void *)) {
-    return dl_list_init(NULL, free_func);
+    return dl_list_init_circular(NULL, free_func);
 }
 
 
@@ -71,7 +71,7 @@ bool queue_isempty(const queue que) {
  */
 
 void * queue_pop(queue que) {
-    dl_list_node popped_node = dl_list_remove_at(que, 0);
+    dl_list_node popped_node = dl_list_remove_node_front(que);
     void * data = popped_node->data;
     free(popped_node);
     return data;
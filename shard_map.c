@@ -0,0 +1,235 @@
+/*!
+ * \file            shard_map.c
+ * \brief           Implementation of sharded concurrent map data structure.
+ * \details         Keys are hashed onto a fixed number of independently
+ * locked binary search tree maps, so threads operating on keys in
+ * different shards do not contend for the same mutex. Each operation
+ * locks only the shard holding its key, and so the map can be shared
+ * between threads without any external locking.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_general.h"
+#include "cds_bst_map.h"
+#include "cds_shard_map.h"
+
+
+/*!
+ * \brief           Struct to contain a sharded map.
+ */
+
+typedef struct shard_map_t {
+    bst_map * shards;           /*!< Array of shards */
+    size_t mask;                /*!< Number of shards less one */
+} shard_map_t;
+
+
+/*!
+ * \brief           Returns the shard for a key.
+ * \details         The high bits of the hash are folded into the low
+ * bits before masking, since the low bits alone are poorly mixed for
+ * short keys.
+ * \param map       A pointer to the map.
+ * \param key       The key.
+ * \returns         The shard which holds, or would hold, the key.
+ */
+
+static bst_map shard_for_key(const shard_map map, const char * key) {
+    const uint64_t hash = cds_hash_string(key);
+    return map->shards[(size_t) (hash ^ (hash >> 32)) & map->mask];
+}
+
+
+/*!
+ * \brief           Initializes a new sharded map.
+ * \param num_shards    The number of shards. This is rounded up to the
+ * next power of two. Write throughput scales with the number of shards
+ * up to around the number of threads sharing the map.
+ * \returns         A pointer to the new map.
+ */
+
+shard_map shard_map_init(const size_t num_shards) {
+    size_t count = 1;
+    while ( count < num_shards ) {
+        count *= 2;
+    }
+
+    shard_map new_map = term_malloc(sizeof(*new_map));
+    new_map->shards = term_malloc(sizeof(*new_map->shards) * count);
+    new_map->mask = count - 1;
+
+    for ( size_t i = 0; i < count; ++i ) {
+        new_map->shards[i] = bst_map_init();
+    }
+
+    return new_map;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a sharded map.
+ * \details         No other thread may be using the map.
+ * \param map       A pointer to the map to free.
+ */
+
+void shard_map_free(shard_map map) {
+    for ( size_t i = 0; i <= map->mask; ++i ) {
+        bst_map_free(map->shards[i]);
+    }
+
+    free(map->shards);
+    free(map);
+}
+
+
+/*!
+ * \brief           Returns the number of elements in a sharded map.
+ * \details         Each shard is locked in turn while it is counted.
+ * \param map       A pointer to the map.
+ * \returns         The number of elements in the map.
+ */
+
+size_t shard_map_length(const shard_map map) {
+    size_t length = 0;
+
+    for ( size_t i = 0; i <= map->mask; ++i ) {
+        bst_map_lock(map->shards[i]);
+        length += bst_map_length(map->shards[i]);
+        bst_map_unlock(map->shards[i]);
+    }
+
+    return length;
+}
+
+
+/*!
+ * \brief           Checks if a sharded map is empty.
+ * \param map       A pointer to the map.
+ * \returns         `true` if the map is empty, otherwise `false`.
+ */
+
+bool shard_map_isempty(const shard_map map) {
+    return shard_map_length(map) == 0;
+}
+
+
+/*!
+ * \brief           Returns the number of shards in a sharded map.
+ * \param map       A pointer to the map.
+ * \returns         The number of shards.
+ */
+
+size_t shard_map_num_shards(const shard_map map) {
+    return map->mask + 1;
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into a sharded map.
+ * \details         The value is replaced if the key is already found
+ * in the map. Any memory consumed by the old value is automatically
+ * `free()`d.
+ * \param map       A pointer to the map.
+ * \param key       The key of the new value to insert.
+ * \param value     A pointer to the new value to insert.
+ * \returns         `true` if the key was already in the map and the
+ * value has been replaced, `false` if the key was not present.
+ */
+
+bool shard_map_insert(shard_map map, const char * key, void * value) {
+    bst_map shard = shard_for_key(map, key);
+
+    bst_map_lock(shard);
+    bool duplicate = bst_map_insert(shard, key, value);
+    bst_map_unlock(shard);
+
+    return duplicate;
+}
+
+
+/*!
+ * \brief           Deletes a key and its value from a sharded map.
+ * \param map       A pointer to the map.
+ * \param key       The key to delete.
+ * \returns         `true` if the key was found and deleted, `false` if
+ * the key was not present.
+ */
+
+bool shard_map_delete(shard_map map, const char * key) {
+    bst_map shard = shard_for_key(map, key);
+
+    bst_map_lock(shard);
+    bool found = bst_map_delete(shard, key);
+    bst_map_unlock(shard);
+
+    return found;
+}
+
+
+/*!
+ * \brief           Determines if a key is in a sharded map.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool shard_map_search(const shard_map map, const char * key) {
+    bst_map shard = shard_for_key(map, key);
+
+    bst_map_lock(shard);
+    bool found = bst_map_search(shard, key);
+    bst_map_unlock(shard);
+
+    return found;
+}
+
+
+/*!
+ * \brief           Searches a sharded map for a value matching a key
+ * and returns it.
+ * \details         The shard is unlocked before returning, so the
+ * caller must ensure that no other thread replaces or deletes the key
+ * while the returned value is in use.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * shard_map_search_data(const shard_map map, const char * key) {
+    bst_map shard = shard_for_key(map, key);
+
+    bst_map_lock(shard);
+    void * value = bst_map_search_data(shard, key);
+    bst_map_unlock(shard);
+
+    return value;
+}
+
+
+/*!
+ * \brief           Visits each key-value pair in a sharded map.
+ * \details         Shards are locked and visited one at a time, so each
+ * shard is seen in a consistent state, while writers to the other shards
+ * are not blocked. Pairs are visited in key order within each shard, but
+ * not across shards. `kvfunc()` must not modify the map.
+ * \param map       A pointer to the map.
+ * \param kvfunc    A pointer to the function to invoke for each pair.
+ * The function is passed the key, the value, and `arg`.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+void shard_map_traverse(shard_map map,
+        void (*kvfunc)(const char *, void *, void *), void * arg) {
+    for ( size_t i = 0; i <= map->mask; ++i ) {
+        bst_map_lock(map->shards[i]);
+        bst_map_traverse(map->shards[i], kvfunc, arg);
+        bst_map_unlock(map->shards[i]);
+    }
+}
@@ -1,6 +1,11 @@
 /*!
  * \file            sl_list.c
  * \brief           Implementation of singly linked list data structure.
+ * \details         A list remembers the last node it found by index, and
+ * finds a later index by walking on from that node rather than from the
+ * front, so a loop visiting indices in order takes O(n) time overall
+ * rather than O(n^2). The node is forgotten whenever nodes are inserted
+ * or removed anywhere but the back of the list, or are reordered.
  * \author          Paul Griffiths
  * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
  * of the GNU General Public License. <http://www.gnu.org/licenses/>
@@ -20,6 +25,218 @@
 #endif
 
 
+/*!
+ * \brief           Forgets the last node a list found by index.
+ * \param list      A pointer to the list.
+ */
+
+static void invalidate_cache(sl_list list) {
+    list->cache_node = NULL;
+}
+
+
+/*!
+ * \brief           Free function for intrusive lists given none.
+ * \param data      A pointer to the container, which is left alone.
+ */
+
+static void free_nothing(void * data) {
+    (void) data;
+}
+
+
+/*!
+ * \brief           Creates a node for data to be inserted in a list.
+ * \details         Intrusive lists take caller-provided nodes only, so
+ * inserting data into one is a fatal error.
+ * \param list      A pointer to the list.
+ * \param data      The data for the new node.
+ * \returns         A pointer to the newly created node.
+ */
+
+static sl_list_node data_node(sl_list list, void * data) {
+    if ( list->intrusive ) {
+        fputs("cdatastruct error: data inserted into intrusive list",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    return sl_list_new_node(data);
+}
+
+
+/*!
+ * \brief           Prepares a caller-provided node for insertion.
+ * \details         The node's data is set to its container. Only
+ * intrusive lists take caller-provided nodes, so passing one to any
+ * other list is a fatal error.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ * \returns         `node`.
+ */
+
+static sl_list_node adopt_node(sl_list list, sl_list_node node) {
+    if ( !list->intrusive ) {
+        fputs("cdatastruct error: node inserted into non-intrusive list",
+              stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    node->data = (char *) node - list->offset;
+    node->next = NULL;
+    return node;
+}
+
+
+/*!
+ * \brief           Releases a node that has been removed from a list.
+ * \details         Nodes of an intrusive list belong to their containers,
+ * so are left alone.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ */
+
+static void release_node(sl_list list, sl_list_node node) {
+    if ( !list->intrusive ) {
+        free(node);
+    }
+}
+
+
+/*!
+ * \brief           Links a node in at the beginning of a list.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, which must not be in a list.
+ */
+
+static void link_front(sl_list list, sl_list_node node) {
+    node->next = list->front;
+    list->front = node;
+    if ( list->back == NULL ) {
+        list->back = node;
+    }
+    ++list->length;
+    invalidate_cache(list);
+}
+
+
+/*!
+ * \brief           Unlinks the node after a provided iterator.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to unlink.
+ * \returns         A pointer to the unlinked node, or NULL if `itr` is
+ * the last element.
+ */
+
+static sl_list_node unlink_after(sl_list list, sl_list_itr itr) {
+    sl_list_node node = itr->next;
+    if ( node == NULL ) {
+        return NULL;
+    }
+
+    itr->next = node->next;
+    if ( node == list->back ) {
+        list->back = itr;
+    }
+    --list->length;
+    invalidate_cache(list);
+
+    return node;
+}
+
+
+/*!
+ * \brief           Links a node in after a provided iterator.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to link.
+ * \param node      A pointer to the node, which must not be in a list.
+ */
+
+static void link_after(sl_list list, sl_list_itr itr, sl_list_node node) {
+    node->next = itr->next;
+    itr->next = node;
+    if ( itr == list->back ) {
+        list->back = node;
+    }
+    ++list->length;
+    invalidate_cache(list);
+}
+
+
+/*!
+ * \brief           Merge sorts a chain of nodes.
+ * \details         Runs of length 1, 2, 4, ... are merged pairwise in
+ * successive passes over the chain, which needs no recursion and no
+ * extra memory. A node from the left run is taken first when the two
+ * compare equal, so the sort is stable.
+ * \param front     A pointer to the first node of the chain.
+ * \param cfunc     A pointer to the compare function.
+ * \param p_back    A pointer to populate with the last node of the
+ * sorted chain.
+ * \returns         A pointer to the first node of the sorted chain.
+ */
+
+static sl_list_node merge_sort_nodes(sl_list_node front,
+        int (*cfunc)(const void *, const void *), sl_list_node * p_back) {
+    size_t run = 1;
+
+    while ( true ) {
+        sl_list_node p = front;
+        sl_list_node tail = NULL;
+        size_t merges = 0;
+        front = NULL;
+
+        while ( p ) {
+            ++merges;
+
+            /*  Find the second run of the pair  */
+
+            sl_list_node q = p;
+            size_t p_size = 0;
+            while ( p_size < run && q ) {
+                ++p_size;
+                q = q->next;
+            }
+            size_t q_size = run;
+
+            while ( p_size > 0 || (q_size > 0 && q) ) {
+                sl_list_node e;
+                if ( p_size == 0 ) {
+                    e = q;
+                    q = q->next;
+                    --q_size;
+                } else if ( q_size == 0 || q == NULL ||
+                            cfunc(p->data, q->data) <= 0 ) {
+                    e = p;
+                    p = p->next;
+                    --p_size;
+                } else {
+                    e = q;
+                    q = q->next;
+                    --q_size;
+                }
+
+                if ( tail ) {
+                    tail->next = e;
+                } else {
+                    front = e;
+                }
+                tail = e;
+            }
+
+            p = q;
+        }
+
+        tail->next = NULL;
+        if ( merges <= 1 ) {
+            *p_back = tail;
+            return front;
+        }
+        run *= 2;
+    }
+}
+
+
 /*!
  * \brief           Initializes a new singly linked list.
  * \param cfunc     A pointer to a compare function. The function should
@@ -37,8 +254,13 @@ sl_list sl_list_init(int (*cfunc)(const void *, const void *),
                      void (*free_func)(void *)) {
     sl_list new_list = term_malloc(sizeof(*new_list));
     new_list->front = NULL;
+    new_list->back = NULL;
     new_list->length = 0;
     new_list->cfunc = cfunc;
+    new_list->cache_node = NULL;
+    new_list->cache_index = 0;
+    new_list->intrusive = false;
+    new_list->offset = 0;
 
     if ( free_func ) {
         new_list->free_func = free_func;
@@ -58,6 +280,37 @@ sl_list sl_list_init(int (*cfunc)(const void *, const void *),
 }
 
 
+/*!
+ * \brief           Initializes a new intrusive singly linked list.
+ * \details         An intrusive list links nodes embedded in the elements
+ * themselves, so inserting an element allocates nothing. Elements are
+ * inserted with sl_list_prepend_node(), sl_list_append_node() and
+ * sl_list_insert_node_after(), and the data of each node, as passed to
+ * the compare and free functions and returned by iterators, is the
+ * element containing it. Use `cds_container_of()` to get from a node
+ * to its element.
+ * \param cfunc     A pointer to a compare function, as for
+ * sl_list_init().
+ * \param free_func A pointer to a function for freeing an element when
+ * it is deleted from the list. If `NULL` is specified, elements are left
+ * alone, which suits elements the caller frees, or that are not
+ * dynamically allocated.
+ * \param offset    The offset of the node within each element, as given
+ * by `offsetof()`.
+ * \returns         A pointer to the new list.
+ */
+
+sl_list sl_list_init_intrusive(int (*cfunc)(const void *, const void *),
+                               void (*free_func)(void *),
+                               const size_t offset) {
+    sl_list new_list = sl_list_init(cfunc,
+                                    free_func ? free_func : free_nothing);
+    new_list->intrusive = true;
+    new_list->offset = offset;
+    return new_list;
+}
+
+
 /*!
  * \brief           Frees the resources associated with a list.
  * \param list      A pointer to the list to free.
@@ -113,6 +366,21 @@ void sl_list_prepend(sl_list list, void * data) {
 }
 
 
+/*!
+ * \brief           Inserts an element at the end of a list.
+ * \details         The list keeps a pointer to its last node, so this
+ * takes constant time.
+ * \param list      A pointer to the list.
+ * \param data      A pointer to the data to add. The memory pointed
+ * to by this parameter must be dynamically allocated, as an attempt
+ * will be made to `free()` it when deleting the list.
+ */
+
+void sl_list_append(sl_list list, void * data) {
+    sl_list_link_node_back(list, data_node(list, data));
+}
+
+
 /*!
  * \brief           Inserts an element at the specified index of a list.
  * \param list      A pointer to the list.
@@ -131,11 +399,10 @@ int sl_list_insert_at(sl_list list, const size_t index, void * data) {
         return CDSERR_OUTOFRANGE;
     }
 
-    if ( index == 0 ) {
-        sl_list_node new_node = sl_list_new_node(data);
-        new_node->next = list->front;
-        list->front = new_node;
-        ++list->length;
+    if ( index == list->length ) {
+        sl_list_append(list, data);
+    } else if ( index == 0 ) {
+        link_front(list, data_node(list, data));
     } else {
         sl_list_itr before = sl_list_itr_from_index(list, index - 1);
         sl_list_insert_after(list, before, data);
@@ -161,11 +428,53 @@ int sl_list_insert_after(sl_list list, const sl_list_itr itr, void * data) {
         return CDSERR_BADITERATOR;
     }
 
-    sl_list_node new_node = sl_list_new_node(data);
-    new_node->next = itr->next;
-    itr->next = new_node;
-    ++list->length;
+    link_after(list, itr, data_node(list, data));
+    return 0;
+}
+
+
+/*!
+ * \brief           Inserts a node at the beginning of an intrusive list.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ */
+
+void sl_list_prepend_node(sl_list list, sl_list_node_t * node) {
+    link_front(list, adopt_node(list, node));
+}
+
+
+/*!
+ * \brief           Inserts a node at the end of an intrusive list.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ */
+
+void sl_list_append_node(sl_list list, sl_list_node_t * node) {
+    sl_list_link_node_back(list, adopt_node(list, node));
+}
+
+
+/*!
+ * \brief           Inserts a node into an intrusive list after a
+ * provided iterator.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to insert.
+ * \param node      A pointer to the node, embedded in its element, which
+ * must not be in a list.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` is a
+ * NULL pointer.
+ */
+
+int sl_list_insert_node_after(sl_list list, const sl_list_itr itr,
+                              sl_list_node_t * node) {
+    if ( itr == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
 
+    link_after(list, itr, adopt_node(list, node));
     return 0;
 }
 
@@ -190,6 +499,205 @@ int sl_list_delete_at(sl_list list, const size_t index) {
 }
 
 
+/*!
+ * \brief           Deletes the list element after a provided iterator.
+ * \details         This takes constant time, and leaves `itr` valid, so
+ * a loop can delete elements as it walks the list by keeping an iterator
+ * to the element before the one being examined.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to delete.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` is a
+ * NULL pointer, CDSERR_OUTOFRANGE if `itr` is the last element.
+ */
+
+int sl_list_delete_after(sl_list list, const sl_list_itr itr) {
+    if ( itr == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
+
+    sl_list_node rm_node = unlink_after(list, itr);
+    if ( rm_node == NULL ) {
+        return CDSERR_OUTOFRANGE;
+    }
+
+    sl_list_free_node(list, rm_node);
+    return 0;
+}
+
+
+/*!
+ * \brief           Removes, but does not delete, the first element of
+ * a list.
+ * \details         The element's data is not freed, and on an intrusive
+ * list its node is left alone, so this is how to take an element back
+ * out of an intrusive list.
+ * \param list      A pointer to the list.
+ * \returns         A pointer to the data of the removed element, or NULL
+ * if the list is empty.
+ */
+
+void * sl_list_remove_front(sl_list list) {
+    sl_list_node rm_node = sl_list_remove_at(list, 0);
+    if ( rm_node == NULL ) {
+        return NULL;
+    }
+
+    void * data = rm_node->data;
+    release_node(list, rm_node);
+    return data;
+}
+
+
+/*!
+ * \brief           Removes, but does not delete, the list element after
+ * a provided iterator.
+ * \details         As for sl_list_remove_front(), the element's data is
+ * not freed, and `itr` is left valid.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to remove.
+ * \returns         A pointer to the data of the removed element, or NULL
+ * if `itr` is a NULL pointer or the last element.
+ */
+
+void * sl_list_remove_after(sl_list list, const sl_list_itr itr) {
+    if ( itr == NULL ) {
+        return NULL;
+    }
+
+    sl_list_node rm_node = unlink_after(list, itr);
+    if ( rm_node == NULL ) {
+        return NULL;
+    }
+
+    void * data = rm_node->data;
+    release_node(list, rm_node);
+    return data;
+}
+
+
+/*!
+ * \brief           Removes every list element matching a predicate.
+ * \details         The list is walked once, so this takes linear time
+ * however many elements match.
+ * \param list      A pointer to the list.
+ * \param pfunc     A pointer to the predicate, which is passed each
+ * element's data and `arg`, and should return `true` if the element is to
+ * be removed.
+ * \param sink      A pointer to a function to which each removed
+ * element's data is passed, along with `arg`, and which becomes
+ * responsible for it. If this is NULL, the data is freed with the list's
+ * free function.
+ * \param arg       A pointer to the argument to pass to `pfunc()` and
+ * `sink()`.
+ * \returns         The number of elements removed.
+ */
+
+size_t sl_list_remove_if(sl_list list,
+        bool (*pfunc)(const void *, void *),
+        void (*sink)(void *, void *), void * arg) {
+    sl_list_node * p_node = &list->front;
+    sl_list_node last = NULL;
+    size_t count = 0;
+
+    while ( *p_node ) {
+        sl_list_node node = *p_node;
+
+        if ( pfunc(node->data, arg) ) {
+            *p_node = node->next;
+            if ( sink ) {
+                sink(node->data, arg);
+                release_node(list, node);
+            } else {
+                sl_list_free_node(list, node);
+            }
+            ++count;
+        } else {
+            last = node;
+            p_node = &node->next;
+        }
+    }
+
+    list->back = last;
+    list->length -= count;
+    invalidate_cache(list);
+    return count;
+}
+
+
+/*!
+ * \brief           Moves every list element matching a predicate to the
+ * end of another list.
+ * \details         The list is walked once, and the matching nodes are
+ * relinked into the other list in their original order, without being
+ * reallocated.
+ * \param list      A pointer to the list.
+ * \param dst       A pointer to the list to receive the matching elements,
+ * which must be a different list, and intrusive with the same offset if
+ * and only if `list` is.
+ * \param pfunc     A pointer to the predicate, which is passed each
+ * element's data and `arg`, and should return `true` if the element is to
+ * be moved.
+ * \param arg       A pointer to the argument to pass to `pfunc()`.
+ * \returns         The number of elements moved.
+ */
+
+size_t sl_list_partition(sl_list list, sl_list dst,
+        bool (*pfunc)(const void *, void *), void * arg) {
+    sl_list_node * p_node = &list->front;
+    sl_list_node last = NULL;
+    size_t count = 0;
+
+    while ( *p_node ) {
+        sl_list_node node = *p_node;
+
+        if ( pfunc(node->data, arg) ) {
+            *p_node = node->next;
+            sl_list_link_node_back(dst, node);
+            ++count;
+        } else {
+            last = node;
+            p_node = &node->next;
+        }
+    }
+
+    list->back = last;
+    list->length -= count;
+    invalidate_cache(list);
+    return count;
+}
+
+
+/*!
+ * \brief           Moves every element of one list to the end of another.
+ * \details         The nodes are relinked rather than reallocated, so this
+ * takes constant time however long either list is. `src` is left empty.
+ * \param dst       A pointer to the list to receive the elements.
+ * \param src       A pointer to the list to take the elements from, which
+ * must be a different list, and intrusive with the same offset if and
+ * only if `dst` is.
+ */
+
+void sl_list_concat(sl_list dst, sl_list src) {
+    if ( src->front == NULL ) {
+        return;
+    }
+
+    if ( dst->back ) {
+        dst->back->next = src->front;
+    } else {
+        dst->front = src->front;
+    }
+
+    dst->back = src->back;
+    dst->length += src->length;
+
+    src->front = NULL;
+    src->back = NULL;
+    src->length = 0;
+    invalidate_cache(src);
+}
+
+
 /*!
  * \brief           Gets an index to the specified data in a list.
  * \param list      A pointer to the list.
@@ -234,6 +742,39 @@ void * sl_list_data(const sl_list list, const size_t index) {
 }
 
 
+/*!
+ * \brief           Sorts a list using its compare function.
+ * \details         The sort is a stable merge sort which relinks the
+ * existing nodes, in O(n log n) time and O(1) extra memory. Iterators
+ * remain valid and refer to the same elements.
+ * \param list      A pointer to the list.
+ */
+
+void sl_list_sort(sl_list list) {
+    sl_list_sort_by(list, list->cfunc);
+}
+
+
+/*!
+ * \brief           Sorts a list using a supplied compare function.
+ * \details         The sort is a stable merge sort which relinks the
+ * existing nodes, in O(n log n) time and O(1) extra memory. Iterators
+ * remain valid and refer to the same elements.
+ * \param list      A pointer to the list.
+ * \param cfunc     A pointer to a compare function, which is passed
+ * pointers to the data of two elements, and should return less than
+ * zero, zero or greater than zero if the first sorts before, with or
+ * after the second.
+ */
+
+void sl_list_sort_by(sl_list list, int (*cfunc)(const void *, const void *)) {
+    if ( list->length > 1 ) {
+        list->front = merge_sort_nodes(list->front, cfunc, &list->back);
+        invalidate_cache(list);
+    }
+}
+
+
 /*!
  * \brief           Returns an iterator to the first element of a list.
  * \param list      A pointer to the list.
@@ -245,6 +786,18 @@ sl_list_itr sl_list_first(const sl_list list) {
 }
 
 
+/*!
+ * \brief           Returns an iterator to the last element of a list.
+ * \param list      A pointer to the list.
+ * \returns         An iterator to the last element, or NULL if the list
+ * is empty.
+ */
+
+sl_list_itr sl_list_last(const sl_list list) {
+    return list->back;
+}
+
+
 /*!
  * \brief           Advances a list iterator by one element.
  * \param itr       The iterator to advance
@@ -258,6 +811,10 @@ sl_list_itr sl_list_next(const sl_list_itr itr) {
 
 /*!
  * \brief           Return an iterator to a specified element of a list.
+ * \details         The element is found by walking from the last element
+ * found by index, if that is not after it, or otherwise from the front.
+ * Since this records the element found, a list shared between threads
+ * must be locked even to look up elements by index.
  * \param list      A pointer to the list.
  * \param index     The specified index.
  * \returns         The iterator, or NULL if `index` is out of range.
@@ -266,15 +823,24 @@ sl_list_itr sl_list_next(const sl_list_itr itr) {
 sl_list_itr sl_list_itr_from_index(const sl_list list, const size_t index) {
     if ( index >= list->length ) {
         return NULL;
+    } else if ( index == list->length - 1 ) {
+        return list->back;
     }
 
     sl_list_itr itr = list->front;
     size_t i = index;
 
+    if ( list->cache_node && list->cache_index <= index ) {
+        itr = list->cache_node;
+        i = index - list->cache_index;
+    }
+
     while ( i-- ) {
         itr = itr->next;
     }
 
+    list->cache_node = itr;
+    list->cache_index = index;
     return itr;
 }
 
@@ -293,6 +859,26 @@ sl_list_node sl_list_new_node(void * data) {
 }
 
 
+/*!
+ * \brief           Links a node in at the end of a list.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node, which must not be in a list.
+ */
+
+void sl_list_link_node_back(sl_list list, sl_list_node node) {
+    node->next = NULL;
+
+    if ( list->back ) {
+        list->back->next = node;
+    } else {
+        list->front = node;
+    }
+
+    list->back = node;
+    ++list->length;
+}
+
+
 /*!
  * \brief           Frees resources for a node and any data.
  * \param list      A pointer to the list.
@@ -301,7 +887,7 @@ sl_list_node sl_list_new_node(void * data) {
 
 void sl_list_free_node(sl_list list, sl_list_node node) {
     list->free_func(node->data);
-    free(node);
+    release_node(list, node);
 }
 
 
@@ -321,14 +907,21 @@ sl_list_node sl_list_remove_at(sl_list list, const size_t index) {
     sl_list_node itr = list->front;
     if ( index == 0 ) {
         list->front = itr->next;
+        if ( list->front == NULL ) {
+            list->back = NULL;
+        }
     } else {
         sl_list_itr before = sl_list_itr_from_index(list, index - 1);
         itr = before->next;
         before->next = itr->next;
+        if ( itr == list->back ) {
+            list->back = before;
+        }
     }
 
     itr->next = NULL;
     --list->length;
+    invalidate_cache(list);
 
     return itr;
 }
@@ -34,9 +34,14 @@ typedef struct sl_list_t {
     pthread_mutex_t mutex;              /*!< Mutex */
 #endif
     struct sl_list_node_t * front;      /*!< Pointer to first node */
+    struct sl_list_node_t * back;       /*!< Pointer to last node */
     size_t length;                      /*!< Length of list */
     int (*cfunc)();                     /*!< Pointer to compare function */
     void (*free_func)();                /*!< Pointer to free function */
+    struct sl_list_node_t * cache_node; /*!< Last node found by index */
+    size_t cache_index;                 /*!< Index of `cache_node` */
+    bool intrusive;                     /*!< Nodes embedded in elements */
+    size_t offset;                      /*!< Offset of node in element */
 } sl_list_t;
 
 
@@ -55,6 +60,7 @@ extern "C" {
 
 sl_list_node sl_list_new_node(void * data);
 void sl_list_free_node(sl_list list, sl_list_node node);
+void sl_list_link_node_back(sl_list list, sl_list_node node);
 
 sl_list_node sl_list_remove_at(sl_list list, const size_t index);
 
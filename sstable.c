@@ -0,0 +1,940 @@
+/*!
+ * \file            sstable.c
+ * \brief           Implementation of sorted string table file data
+ * structure.
+ * \details         A sorted string table is an immutable file holding
+ * key-value pairs in key order. The pairs are packed into data blocks of
+ * around 4KB, and within each block each key is front-coded, being stored
+ * as the length of the prefix it shares with the previous key followed by
+ * the remaining bytes. The first key of each block is stored in full.
+ * The data blocks are followed by a sparse index holding one fixed-size
+ * record per block, locating the block and its first key, and the file
+ * ends with a fixed-size footer locating the index.
+ *
+ * A table is opened by mapping the file into memory and reading the
+ * footer, and nothing else is read or decoded at open time. A search
+ * binary searches the index for the one block which could hold the key,
+ * and scans that block, comparing the key against the front-coded keys
+ * incrementally without reconstructing them. Values are returned as
+ * pointers directly into the mapping.
+ *
+ * All integers in the file are little-endian. Variable-length integers
+ * are stored seven bits per byte, least significant first, with the high
+ * bit set on all but the last byte. A record is:
+ *
+ *  - varint shared key length
+ *  - varint unshared key length
+ *  - unshared key bytes
+ *  - varint value length plus one, or zero for a deleted key
+ *  - value bytes
+ *
+ * An index record is a 64-bit block offset, a 32-bit length of the
+ * block's first key, and a 32-bit offset of that key within the block.
+ * The footer is the 64-bit index offset, number of blocks, number of
+ * entries, and a magic number.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+/*!
+ * \brief           Enable POSIX library.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_bst_map.h"
+#include "cds_sstable.h"
+#include "sstable.h"
+
+
+/*!
+ * \brief           Size at which a data block is ended.
+ */
+
+#define BLOCK_SIZE 4096
+
+
+/*!
+ * \brief           Size of an index record.
+ */
+
+#define INDEX_RECORD_SIZE 16
+
+
+/*!
+ * \brief           Size of the footer.
+ */
+
+#define FOOTER_SIZE 32
+
+
+/*!
+ * \brief           Magic number ending a sorted string table file.
+ */
+
+#define SSTABLE_MAGIC UINT64_C(0x3130545353534443)
+
+
+/*!
+ * \brief           Struct for a growable byte buffer.
+ */
+
+typedef struct byte_buffer_t {
+    unsigned char * data;       /*!< Pointer to bytes */
+    size_t len;                 /*!< Number of bytes used */
+    size_t cap;                 /*!< Number of bytes allocated */
+} byte_buffer_t;
+
+
+/*!
+ * \brief           Struct to contain a sorted string table writer.
+ */
+
+typedef struct sstable_writer_t {
+    FILE * fp;                  /*!< File being written */
+    byte_buffer_t block;        /*!< Current data block */
+    byte_buffer_t index;        /*!< Index records */
+    byte_buffer_t last_key;     /*!< Previous key */
+    uint64_t offset;            /*!< File offset of current data block */
+    uint64_t num_blocks;        /*!< Number of data blocks */
+    uint64_t length;            /*!< Number of entries */
+    bool failed;                /*!< Set if a write has failed */
+} sstable_writer_t;
+
+
+/*!
+ * \brief           Struct to contain a sorted string table cursor.
+ */
+
+typedef struct sstable_cursor_t {
+    const sstable_t * table;        /*!< Table being traversed */
+    size_t block;                   /*!< Index of current data block */
+    const unsigned char * pos;      /*!< Next record in block */
+    const unsigned char * end;      /*!< End of block */
+    byte_buffer_t key;              /*!< Current key, NUL-terminated */
+    const void * value;             /*!< Current value */
+    size_t len;                     /*!< Length of current value */
+    bool pending;                   /*!< Set if current entry not returned */
+} sstable_cursor_t;
+
+
+/*!
+ * \brief           Struct for passing write state to a callback.
+ */
+
+typedef struct sstable_write_t {
+    sstable_writer writer;                          /*!< Writer */
+    const void * (*vfunc)(const void *, size_t *);  /*!< Value serializer */
+} sstable_write_t;
+
+
+/*!
+ * \brief           Ensures a buffer has room for more bytes.
+ * \param buffer    A pointer to the buffer.
+ * \param extra     The number of bytes to make room for.
+ */
+
+static void buffer_reserve(byte_buffer_t * buffer, const size_t extra) {
+    if ( buffer->len + extra > buffer->cap ) {
+        size_t new_cap = buffer->cap ? buffer->cap * 2 : 64;
+        while ( new_cap < buffer->len + extra ) {
+            new_cap *= 2;
+        }
+        buffer->data = term_realloc(buffer->data, new_cap);
+        buffer->cap = new_cap;
+    }
+}
+
+
+/*!
+ * \brief           Appends bytes to a buffer.
+ * \param buffer    A pointer to the buffer.
+ * \param bytes     A pointer to the bytes.
+ * \param n         The number of bytes.
+ */
+
+static void buffer_put(byte_buffer_t * buffer,
+                       const void * bytes, const size_t n) {
+    buffer_reserve(buffer, n);
+    if ( n ) {
+        memcpy(buffer->data + buffer->len, bytes, n);
+    }
+    buffer->len += n;
+}
+
+
+/*!
+ * \brief           Appends a variable-length integer to a buffer.
+ * \param buffer    A pointer to the buffer.
+ * \param value     The integer.
+ */
+
+static void buffer_put_varint(byte_buffer_t * buffer, uint64_t value) {
+    buffer_reserve(buffer, 10);
+    while ( value >= 0x80 ) {
+        buffer->data[buffer->len++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    buffer->data[buffer->len++] = (unsigned char) value;
+}
+
+
+/*!
+ * \brief           Appends a little-endian fixed-size integer to a buffer.
+ * \param buffer    A pointer to the buffer.
+ * \param value     The integer.
+ * \param size      The size of the integer in bytes.
+ */
+
+static void buffer_put_fixed(byte_buffer_t * buffer,
+                             const uint64_t value, const size_t size) {
+    buffer_reserve(buffer, size);
+    for ( size_t i = 0; i < size; ++i ) {
+        buffer->data[buffer->len++] = (unsigned char) (value >> (8 * i));
+    }
+}
+
+
+/*!
+ * \brief           Reads a little-endian fixed-size integer.
+ * \param p         A pointer to the integer.
+ * \param size      The size of the integer in bytes.
+ * \returns         The integer.
+ */
+
+static uint64_t get_fixed(const unsigned char * p, const size_t size) {
+    uint64_t value = 0;
+    for ( size_t i = 0; i < size; ++i ) {
+        value |= (uint64_t) p[i] << (8 * i);
+    }
+    return value;
+}
+
+
+/*!
+ * \brief           Reads a variable-length integer.
+ * \param p_pos     A pointer to a pointer to the integer, which is
+ * advanced past it.
+ * \returns         The integer.
+ */
+
+static uint64_t get_varint(const unsigned char ** p_pos) {
+    const unsigned char * pos = *p_pos;
+    uint64_t value = 0;
+    int shift = 0;
+
+    while ( *pos & 0x80 ) {
+        value |= (uint64_t) (*pos++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (uint64_t) *pos++ << shift;
+
+    *p_pos = pos;
+    return value;
+}
+
+
+/*!
+ * \brief           Compares a key to a byte string.
+ * \param key       A pointer to the key.
+ * \param key_len   The length of the key.
+ * \param bytes     A pointer to the byte string.
+ * \param len       The length of the byte string.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * is less than, equal to or greater than the byte string.
+ */
+
+static int compare_bytes(const char * key, const size_t key_len,
+                         const unsigned char * bytes, const size_t len) {
+    const size_t common = (key_len < len) ? key_len : len;
+    int compare = memcmp(key, bytes, common);
+
+    if ( compare == 0 ) {
+        compare = (key_len > len) - (key_len < len);
+    }
+
+    return compare;
+}
+
+
+/*!
+ * \brief           Returns the start of a data block.
+ * \param table     A pointer to the table.
+ * \param block     The index of the block.
+ * \returns         A pointer to the start of the block.
+ */
+
+static const unsigned char * block_start(const sstable_t * table,
+                                         const size_t block) {
+    const unsigned char * record = table->index + block * INDEX_RECORD_SIZE;
+    return table->base + get_fixed(record, 8);
+}
+
+
+/*!
+ * \brief           Returns the end of a data block.
+ * \param table     A pointer to the table.
+ * \param block     The index of the block.
+ * \returns         A pointer to one past the end of the block.
+ */
+
+static const unsigned char * block_end(const sstable_t * table,
+                                       const size_t block) {
+    if ( block + 1 < table->num_blocks ) {
+        return block_start(table, block + 1);
+    }
+    return table->index;
+}
+
+
+/*!
+ * \brief           Finds the data block which could hold a key.
+ * \param table     A pointer to the table.
+ * \param key       The key.
+ * \param p_block   A pointer to populate with the index of the last
+ * block whose first key is not greater than the key.
+ * \returns         `true` if such a block exists, `false` if the key
+ * precedes every key in the table.
+ */
+
+static bool find_block(const sstable_t * table, const char * key,
+                       size_t * p_block) {
+    const size_t key_len = strlen(key);
+    size_t low = 0;
+    size_t high = table->num_blocks;
+
+    /*  Find the first block whose first key is greater than the key  */
+
+    while ( low < high ) {
+        const size_t mid = low + (high - low) / 2;
+        const unsigned char * record = table->index +
+                                       mid * INDEX_RECORD_SIZE;
+        const unsigned char * first = block_start(table, mid) +
+                                      get_fixed(record + 12, 4);
+
+        if ( compare_bytes(key, key_len, first,
+                           get_fixed(record + 8, 4)) < 0 ) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    if ( low == 0 ) {
+        return false;
+    }
+
+    *p_block = low - 1;
+    return true;
+}
+
+
+/*!
+ * \brief           Positions a cursor at the start of a data block.
+ * \param cursor    A pointer to the cursor.
+ * \param block     The index of the block.
+ */
+
+static void cursor_load_block(sstable_cursor cursor, const size_t block) {
+    cursor->block = block;
+    cursor->pos = block_start(cursor->table, block);
+    cursor->end = block_end(cursor->table, block);
+    cursor->key.len = 0;
+}
+
+
+/*!
+ * \brief           Decodes the next entry at a cursor.
+ * \param cursor    A pointer to the cursor.
+ * \returns         `true` if an entry was decoded, `false` if the end of
+ * the table has been reached.
+ */
+
+static bool cursor_advance(sstable_cursor cursor) {
+    while ( cursor->pos == cursor->end ) {
+        if ( cursor->block + 1 >= cursor->table->num_blocks ) {
+            return false;
+        }
+        cursor_load_block(cursor, cursor->block + 1);
+    }
+
+    const size_t shared = get_varint(&cursor->pos);
+    const size_t unshared = get_varint(&cursor->pos);
+
+    cursor->key.len = shared;
+    buffer_put(&cursor->key, cursor->pos, unshared);
+    buffer_reserve(&cursor->key, 1);
+    cursor->key.data[cursor->key.len] = '\0';
+    cursor->pos += unshared;
+
+    const size_t code = get_varint(&cursor->pos);
+    if ( code ) {
+        cursor->value = cursor->pos;
+        cursor->len = code - 1;
+        cursor->pos += code - 1;
+    } else {
+        cursor->value = NULL;
+        cursor->len = 0;
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief           Ends the current data block of a writer.
+ * \param writer    A pointer to the writer.
+ */
+
+static void writer_flush_block(sstable_writer writer) {
+    if ( writer->block.len == 0 ) {
+        return;
+    }
+
+    if ( fwrite(writer->block.data, 1, writer->block.len,
+                writer->fp) != writer->block.len ) {
+        writer->failed = true;
+    }
+
+    writer->offset += writer->block.len;
+    ++writer->num_blocks;
+    writer->block.len = 0;
+}
+
+
+/*!
+ * \brief           Writes a key-value pair during a map traversal.
+ * \param key       The key.
+ * \param value     A pointer to the value.
+ * \param arg       A pointer to the write state.
+ */
+
+static void write_pair(const char * key, void * value, void * arg) {
+    const sstable_write_t * state = arg;
+    const void * bytes;
+    size_t len;
+
+    if ( state->vfunc ) {
+        bytes = state->vfunc(value, &len);
+    } else {
+        bytes = value;
+        len = value ? strlen(value) + 1 : 0;
+    }
+
+    if ( bytes == NULL ) {
+        bytes = "";
+        len = 0;
+    }
+
+    sstable_writer_add(state->writer, key, bytes, len);
+}
+
+
+/*!
+ * \brief           Writes a map to a sorted string table file.
+ * \details         The map must not be modified during the write.
+ * \param map       A pointer to the map.
+ * \param filename  The name of the file to write. Any existing file of
+ * that name is replaced.
+ * \param vfunc     A pointer to a function to serialize a value. The
+ * function is passed a pointer to the value, and a pointer to a `size_t`
+ * to populate with the length of the serialized value, and should return
+ * a pointer to the serialized bytes, which must remain valid until the
+ * function is next called. If this is `NULL`, values are taken to be
+ * strings and written with their terminating NULs.
+ * \returns         Zero on success, or `CDSERR_IO` if the file could
+ * not be written.
+ */
+
+int bst_map_write_sstable(const bst_map map, const char * filename,
+        const void * (*vfunc)(const void *, size_t *)) {
+    sstable_write_t state;
+    state.writer = sstable_writer_open(filename);
+    state.vfunc = vfunc;
+
+    if ( state.writer == NULL ) {
+        return CDSERR_IO;
+    }
+
+    bst_map_traverse(map, write_pair, &state);
+    return sstable_writer_close(state.writer);
+}
+
+
+/*!
+ * \brief           Opens a sorted string table file for reading.
+ * \details         The file is mapped into memory, and only its footer
+ * is read, so this takes the same time whatever the size of the file.
+ * \param filename  The name of the file.
+ * \returns         A pointer to the table, or `NULL` if the file could
+ * not be opened or is not a sorted string table.
+ */
+
+sstable sstable_open(const char * filename) {
+    const int fd = open(filename, O_RDONLY);
+    if ( fd == -1 ) {
+        return NULL;
+    }
+
+    struct stat st;
+    if ( fstat(fd, &st) == -1 || st.st_size < FOOTER_SIZE ) {
+        close(fd);
+        return NULL;
+    }
+
+    const size_t size = (size_t) st.st_size;
+    void * mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if ( mapping == MAP_FAILED ) {
+        return NULL;
+    }
+
+    const unsigned char * base = mapping;
+    const unsigned char * footer = base + size - FOOTER_SIZE;
+    const uint64_t index_offset = get_fixed(footer, 8);
+    const uint64_t num_blocks = get_fixed(footer + 8, 8);
+
+    if ( get_fixed(footer + 24, 8) != SSTABLE_MAGIC ||
+         index_offset > size - FOOTER_SIZE ||
+         num_blocks != (size - FOOTER_SIZE - index_offset) /
+                       INDEX_RECORD_SIZE ) {
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    sstable new_table = term_malloc(sizeof(*new_table));
+    new_table->base = base;
+    new_table->size = size;
+    new_table->index = base + index_offset;
+    new_table->num_blocks = num_blocks;
+    new_table->length = get_fixed(footer + 16, 8);
+    return new_table;
+}
+
+
+/*!
+ * \brief           Closes a sorted string table.
+ * \details         Any pointers to keys or values obtained from the table
+ * become invalid.
+ * \param table     A pointer to the table.
+ */
+
+void sstable_close(sstable table) {
+    munmap((void *) table->base, table->size);
+    free(table);
+}
+
+
+/*!
+ * \brief           Returns the number of entries in a sorted string table.
+ * \param table     A pointer to the table.
+ * \returns         The number of entries in the table.
+ */
+
+size_t sstable_length(const sstable table) {
+    return table->length;
+}
+
+
+/*!
+ * \brief           Checks if a sorted string table is empty.
+ * \param table     A pointer to the table.
+ * \returns         `true` if the table is empty, otherwise `false`.
+ */
+
+bool sstable_isempty(const sstable table) {
+    return table->length == 0;
+}
+
+
+/*!
+ * \brief           Determines if a key is in a sorted string table.
+ * \param table     A pointer to the table.
+ * \param key       The key for which to search.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool sstable_search(const sstable table, const char * key) {
+    return sstable_search_data(table, key, NULL) ? true : false;
+}
+
+
+/*!
+ * \brief           Searches a sorted string table for a value matching
+ * a key and returns it.
+ * \param table     A pointer to the table.
+ * \param key       The key for which to search.
+ * \param len       A pointer to populate with the length of the value.
+ * This parameter is ignored if set to NULL.
+ * \returns         A pointer to the value within the file mapping if
+ * found, `NULL` otherwise. The value has no particular alignment.
+ */
+
+const void * sstable_search_data(const sstable table,
+                                 const char * key, size_t * len) {
+    const void * value;
+    size_t value_len;
+
+    if ( !sstable_find(table, key, &value, &value_len) || value == NULL ) {
+        return NULL;
+    }
+
+    if ( len ) {
+        *len = value_len;
+    }
+
+    return value;
+}
+
+
+/*!
+ * \brief           Visits each key and value in a sorted string table
+ * beginning with a prefix, in key order.
+ * \param table     A pointer to the table.
+ * \param prefix    The prefix.
+ * \param kvfunc    A pointer to the function to invoke for each entry.
+ * The function is passed the key, a pointer to the value, the length of
+ * the value, and `arg`.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+void sstable_prefix_traverse(const sstable table, const char * prefix,
+        void (*kvfunc)(const char *, const void *, size_t, void *),
+        void * arg) {
+    const size_t prefix_len = strlen(prefix);
+    sstable_cursor cursor = sstable_cursor_seek(table, prefix);
+    const char * key;
+    const void * value;
+    size_t len;
+
+    while ( sstable_cursor_next(cursor, &key, &value, &len) &&
+            strncmp(key, prefix, prefix_len) == 0 ) {
+        if ( value ) {
+            kvfunc(key, value, len, arg);
+        }
+    }
+
+    sstable_cursor_free(cursor);
+}
+
+
+/*!
+ * \brief           Visits each key and value in a sorted string table
+ * within a range, in key order.
+ * \param table     A pointer to the table.
+ * \param first     The first key of the range, inclusive, or `NULL` to
+ * start at the first key in the table.
+ * \param last      The last key of the range, exclusive, or `NULL` to
+ * end at the last key in the table.
+ * \param kvfunc    A pointer to the function to invoke for each entry.
+ * The function is passed the key, a pointer to the value, the length of
+ * the value, and `arg`.
+ * \param arg       A pointer to the argument to pass to `kvfunc()`.
+ */
+
+void sstable_range_traverse(const sstable table,
+        const char * first, const char * last,
+        void (*kvfunc)(const char *, const void *, size_t, void *),
+        void * arg) {
+    sstable_cursor cursor = sstable_cursor_seek(table, first);
+    const char * key;
+    const void * value;
+    size_t len;
+
+    while ( sstable_cursor_next(cursor, &key, &value, &len) &&
+            (last == NULL || strcmp(key, last) < 0) ) {
+        if ( value ) {
+            kvfunc(key, value, len, arg);
+        }
+    }
+
+    sstable_cursor_free(cursor);
+}
+
+
+/*!
+ * \brief           Creates a cursor over a sorted string table.
+ * \param table     A pointer to the table.
+ * \param key       The key at which to start. The cursor starts at the
+ * first key not less than this, or at the first key in the table if this
+ * is `NULL`.
+ * \returns         A pointer to the new cursor.
+ */
+
+sstable_cursor sstable_cursor_seek(const sstable table, const char * key) {
+    sstable_cursor new_cursor = term_malloc(sizeof(*new_cursor));
+    new_cursor->table = table;
+    new_cursor->key = (byte_buffer_t) {NULL, 0, 0};
+    new_cursor->value = NULL;
+    new_cursor->len = 0;
+    new_cursor->pending = false;
+
+    size_t block = 0;
+    if ( key ) {
+        find_block(table, key, &block);
+    }
+
+    if ( table->num_blocks ) {
+        cursor_load_block(new_cursor, block);
+    } else {
+        new_cursor->block = 0;
+        new_cursor->pos = new_cursor->end = NULL;
+    }
+
+    if ( key ) {
+        while ( cursor_advance(new_cursor) ) {
+            if ( strcmp((const char *) new_cursor->key.data, key) >= 0 ) {
+                new_cursor->pending = true;
+                break;
+            }
+        }
+    }
+
+    return new_cursor;
+}
+
+
+/*!
+ * \brief           Gets the next entry from a sorted string table cursor.
+ * \param cursor    A pointer to the cursor.
+ * \param key       A pointer to populate with the key, which remains valid
+ * until the cursor is next advanced or freed. This parameter is ignored
+ * if set to NULL.
+ * \param value     A pointer to populate with a pointer to the value
+ * within the file mapping, or with `NULL` if the entry records a deleted
+ * key. This parameter is ignored if set to NULL.
+ * \param len       A pointer to populate with the length of the value.
+ * This parameter is ignored if set to NULL.
+ * \returns         `true` if an entry was retrieved, `false` if the
+ * cursor has passed the last entry.
+ */
+
+bool sstable_cursor_next(sstable_cursor cursor, const char ** key,
+                         const void ** value, size_t * len) {
+    if ( cursor->pending ) {
+        cursor->pending = false;
+    } else if ( !cursor_advance(cursor) ) {
+        return false;
+    }
+
+    if ( key ) {
+        *key = (const char *) cursor->key.data;
+    }
+    if ( value ) {
+        *value = cursor->value;
+    }
+    if ( len ) {
+        *len = cursor->len;
+    }
+
+    return true;
+}
+
+
+/*!
+ * \brief           Frees a sorted string table cursor.
+ * \param cursor    A pointer to the cursor.
+ */
+
+void sstable_cursor_free(sstable_cursor cursor) {
+    free(cursor->key.data);
+    free(cursor);
+}
+
+
+/*!
+ * \brief           Opens a sorted string table file for writing.
+ * \param filename  The name of the file. Any existing file of that name
+ * is replaced.
+ * \returns         A pointer to the writer, or `NULL` if the file could
+ * not be created.
+ */
+
+sstable_writer sstable_writer_open(const char * filename) {
+    FILE * fp = fopen(filename, "wb");
+    if ( fp == NULL ) {
+        return NULL;
+    }
+
+    sstable_writer new_writer = term_malloc(sizeof(*new_writer));
+    new_writer->fp = fp;
+    new_writer->block = new_writer->index = new_writer->last_key =
+        (byte_buffer_t) {NULL, 0, 0};
+    new_writer->offset = 0;
+    new_writer->num_blocks = 0;
+    new_writer->length = 0;
+    new_writer->failed = false;
+    return new_writer;
+}
+
+
+/*!
+ * \brief           Adds an entry to a sorted string table being written.
+ * \param writer    A pointer to the writer.
+ * \param key       The key, which must be greater than the key of the
+ * previous entry.
+ * \param value     A pointer to the value, or `NULL` to record the key
+ * as deleted.
+ * \param len       The length of the value.
+ */
+
+void sstable_writer_add(sstable_writer writer, const char * key,
+                        const void * value, const size_t len) {
+    const size_t key_len = strlen(key);
+    size_t shared = 0;
+
+    if ( writer->block.len >= BLOCK_SIZE ) {
+        writer_flush_block(writer);
+    }
+
+    if ( writer->block.len == 0 ) {
+        buffer_put_varint(&writer->block, 0);
+        buffer_put_varint(&writer->block, key_len);
+
+        buffer_put_fixed(&writer->index, writer->offset, 8);
+        buffer_put_fixed(&writer->index, key_len, 4);
+        buffer_put_fixed(&writer->index, writer->block.len, 4);
+    } else {
+        while ( shared < key_len && shared < writer->last_key.len &&
+                writer->last_key.data[shared] ==
+                (unsigned char) key[shared] ) {
+            ++shared;
+        }
+
+        buffer_put_varint(&writer->block, shared);
+        buffer_put_varint(&writer->block, key_len - shared);
+    }
+
+    buffer_put(&writer->block, key + shared, key_len - shared);
+
+    if ( value ) {
+        buffer_put_varint(&writer->block, (uint64_t) len + 1);
+        buffer_put(&writer->block, value, len);
+    } else {
+        buffer_put_varint(&writer->block, 0);
+    }
+
+    writer->last_key.len = shared;
+    buffer_put(&writer->last_key, key + shared, key_len - shared);
+    ++writer->length;
+}
+
+
+/*!
+ * \brief           Completes and closes a sorted string table file.
+ * \param writer    A pointer to the writer, which is freed.
+ * \returns         Zero on success, or `CDSERR_IO` if the file could
+ * not be written.
+ */
+
+int sstable_writer_close(sstable_writer writer) {
+    writer_flush_block(writer);
+
+    const uint64_t index_offset = writer->offset;
+    buffer_put_fixed(&writer->index, index_offset, 8);
+    buffer_put_fixed(&writer->index, writer->num_blocks, 8);
+    buffer_put_fixed(&writer->index, writer->length, 8);
+    buffer_put_fixed(&writer->index, SSTABLE_MAGIC, 8);
+
+    if ( fwrite(writer->index.data, 1, writer->index.len,
+                writer->fp) != writer->index.len ) {
+        writer->failed = true;
+    }
+
+    if ( fclose(writer->fp) != 0 ) {
+        writer->failed = true;
+    }
+
+    const bool failed = writer->failed;
+    free(writer->block.data);
+    free(writer->index.data);
+    free(writer->last_key.data);
+    free(writer);
+
+    return failed ? CDSERR_IO : 0;
+}
+
+
+/*!
+ * \brief           Searches a sorted string table for a key.
+ * \details         The key is compared against each front-coded key in
+ * its block incrementally: as long as the length of the prefix shared
+ * with the previous key exceeds the length of the prefix the previous key
+ * shared with the search key, the key must still be less than the search
+ * key, and once it is shorter, the key must be greater, so only the keys
+ * sharing exactly that prefix need their remaining bytes compared.
+ * \param table     A pointer to the table.
+ * \param key       The key for which to search.
+ * \param value     A pointer to populate with a pointer to the value,
+ * or with `NULL` if the key is recorded as deleted.
+ * \param len       A pointer to populate with the length of the value.
+ * \returns         `true` if the key was found, even if recorded as
+ * deleted, `false` otherwise.
+ */
+
+bool sstable_find(const sstable table, const char * key,
+                  const void ** value, size_t * len) {
+    size_t block;
+    if ( !find_block(table, key, &block) ) {
+        return false;
+    }
+
+    const unsigned char * pos = block_start(table, block);
+    const unsigned char * end = block_end(table, block);
+    const size_t key_len = strlen(key);
+    size_t match = 0;
+
+    while ( pos < end ) {
+        const size_t shared = get_varint(&pos);
+        const size_t unshared = get_varint(&pos);
+        const unsigned char * suffix = pos;
+        pos += unshared;
+        const size_t code = get_varint(&pos);
+        const unsigned char * entry_value = pos;
+        pos += code ? code - 1 : 0;
+
+        if ( shared < match ) {
+            return false;
+        } else if ( shared > match ) {
+            continue;
+        }
+
+        const size_t rest = key_len - match;
+        const size_t common = (rest < unshared) ? rest : unshared;
+        size_t i = 0;
+        while ( i < common && (unsigned char) key[match + i] == suffix[i] ) {
+            ++i;
+        }
+
+        if ( i < common ) {
+            if ( (unsigned char) key[match + i] < suffix[i] ) {
+                return false;
+            }
+            match += i;
+        } else if ( rest == unshared ) {
+            *value = code ? entry_value : NULL;
+            *len = code ? code - 1 : 0;
+            return true;
+        } else if ( rest < unshared ) {
+            return false;
+        } else {
+            match += unshared;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,61 @@
+/*!
+ * \file            sstable.h
+ * \brief           Developer interface to sorted string table file data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_SSTABLE_DEV_H
+#define PG_CDS_SSTABLE_DEV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cds_sstable.h"
+
+
+/*!
+ * \brief           Struct to contain a sorted string table.
+ * \details         All pointers are into the read-only mapping of the
+ * file.
+ */
+
+typedef struct sstable_t {
+    const unsigned char * base;         /*!< Start of mapping */
+    size_t size;                        /*!< Size of mapping */
+    const unsigned char * index;        /*!< Start of block index */
+    size_t num_blocks;                  /*!< Number of data blocks */
+    size_t length;                      /*!< Number of entries */
+} sstable_t;
+
+
+/*!
+ * \brief           Typedef for sorted string table writer pointer.
+ */
+
+typedef struct sstable_writer_t * sstable_writer;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+sstable_writer sstable_writer_open(const char * filename);
+void sstable_writer_add(sstable_writer writer, const char * key,
+                        const void * value, const size_t len);
+int sstable_writer_close(sstable_writer writer);
+
+bool sstable_find(const sstable table, const char * key,
+                  const void ** value, size_t * len);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_SSTABLE_DEV_H  */
@@ -0,0 +1,83 @@
+/*
+ *  test_bloom_filter.cpp
+ *  =====================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for blocked Bloom filter.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static uint64_t hash_int(const void * data) {
+    uint64_t x = (uint64_t) *((const int *) data) + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+BOOST_AUTO_TEST_SUITE(bloom_filter_suite)
+
+BOOST_AUTO_TEST_CASE(bloom_filter_query_test) {
+    bloom_filter filter = bloom_filter_init(1000, 10);
+
+    for ( int i = 0; i < 1000; ++i ) {
+        bloom_filter_add(filter, hash_int(&i));
+    }
+
+    int false_negatives = 0;
+    for ( int i = 0; i < 1000; ++i ) {
+        if ( !bloom_filter_query(filter, hash_int(&i)) ) {
+            ++false_negatives;
+        }
+    }
+    BOOST_CHECK_EQUAL(false_negatives, 0);
+
+    int false_positives = 0;
+    for ( int i = 1000; i < 11000; ++i ) {
+        if ( bloom_filter_query(filter, hash_int(&i)) ) {
+            ++false_positives;
+        }
+    }
+    BOOST_CHECK(false_positives < 500);
+
+    bloom_filter_clear(filter);
+    int zero = 0;
+    BOOST_CHECK(bloom_filter_query(filter, hash_int(&zero)) == false);
+
+    bloom_filter_free(filter);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter_bs_tree_test) {
+    bs_tree tree = bs_tree_init(cds_compare_int, NULL);
+    for ( int i = 0; i < 100; ++i ) {
+        bs_tree_insert(tree, cds_new_int(i));
+    }
+
+    bs_tree_attach_filter(tree, hash_int, 10);
+    for ( int i = 100; i < 1000; ++i ) {
+        bs_tree_insert(tree, cds_new_int(i));
+    }
+
+    for ( int i = 0; i < 2000; ++i ) {
+        BOOST_CHECK(bs_tree_search(tree, &i) == (i < 1000));
+    }
+
+    bs_tree_filter_stats_t stats;
+    bs_tree_filter_stats(tree, &stats);
+    BOOST_CHECK_EQUAL(stats.queries, 2000);
+    BOOST_CHECK_EQUAL(stats.hits, 1000);
+    BOOST_CHECK_EQUAL(stats.rejected + stats.false_positives, 1000);
+    BOOST_CHECK(stats.rejected > 900);
+
+    bs_tree_free(tree);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
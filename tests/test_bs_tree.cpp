@@ -12,10 +12,60 @@
  *  http://www.gnu.org/licenses/
  */
 
+#include <cstdio>
+#include <cstdlib>
 #include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
 #include <boost/test/unit_test.hpp>
 #include "../cdatastruct.h"
 
+/*  Developer interface function, not declared by cdatastruct.h  */
+
+extern "C" void bs_tree_build_sorted(bs_tree tree, void ** data,
+                                     const size_t n);
+
+struct tree_item {
+    int value;
+    bs_tree_node_t link;
+};
+
+static int compare_tree_item(const void * data, const void * cmp) {
+    return ((const tree_item *) data)->value -
+           ((const tree_item *) cmp)->value;
+}
+
+static void collect_item(void * data, void * arg) {
+    ((std::vector<tree_item *> *) arg)->push_back((tree_item *) data);
+}
+
+/*  Runs a function in a child process, and checks that it exits with
+ *  EXIT_FAILURE, as the library does on misuse                       */
+
+static bool exits_with_failure(void (*func)(bs_tree, void *),
+                               bs_tree tree, void * arg) {
+    std::fflush(NULL);
+    const pid_t pid = fork();
+    if ( pid == 0 ) {
+        std::freopen("/dev/null", "w", stderr);
+        func(tree, arg);
+        _exit(EXIT_SUCCESS);
+    }
+
+    int status;
+    return pid > 0 && waitpid(pid, &status, 0) == pid &&
+           WIFEXITED(status) && WEXITSTATUS(status) == EXIT_FAILURE;
+}
+
+static void insert_data(bs_tree tree, void * arg) {
+    bs_tree_insert(tree, arg);
+}
+
+static void build_sorted_data(bs_tree tree, void * arg) {
+    bs_tree_build_sorted(tree, (void **) arg, 1);
+}
+
 BOOST_AUTO_TEST_SUITE(bs_tree_suite)
 
 BOOST_AUTO_TEST_CASE(bs_tree_insert_search_test) {
@@ -71,4 +121,89 @@ BOOST_AUTO_TEST_CASE(bs_tree_insert_existing_test) {
     bs_tree_free(tree);
 }
 
+BOOST_AUTO_TEST_CASE(bs_tree_delete_test) {
+    bs_tree tree = bs_tree_init(cds_compare_int, NULL);
+    const int elems[] = {50, 30, 70, 20, 40, 60, 80, 35, 45, 65};
+    for ( size_t i = 0; i < 10; ++i ) {
+        bs_tree_insert(tree, cds_new_int(elems[i]));
+    }
+
+    int key = 30;
+    BOOST_CHECK(bs_tree_delete(tree, &key) == true);
+    BOOST_CHECK(bs_tree_search(tree, &key) == false);
+    BOOST_CHECK(bs_tree_delete(tree, &key) == false);
+
+    key = 50;
+    BOOST_CHECK(bs_tree_delete(tree, &key) == true);
+    key = 20;
+    BOOST_CHECK(bs_tree_delete(tree, &key) == true);
+    key = 60;
+    BOOST_CHECK(bs_tree_delete(tree, &key) == true);
+
+    BOOST_CHECK_EQUAL(bs_tree_length(tree), 6);
+    const int remaining[] = {35, 40, 45, 65, 70, 80};
+    for ( size_t i = 0; i < 6; ++i ) {
+        BOOST_CHECK(bs_tree_search(tree, &remaining[i]) == true);
+    }
+
+    for ( size_t i = 0; i < 6; ++i ) {
+        BOOST_CHECK(bs_tree_delete(tree, &remaining[i]) == true);
+    }
+    BOOST_CHECK(bs_tree_isempty(tree) == true);
+
+    bs_tree_free(tree);
+}
+
+BOOST_AUTO_TEST_CASE(bs_tree_intrusive_test) {
+    bs_tree tree = bs_tree_init_intrusive(compare_tree_item, NULL,
+                                          offsetof(tree_item, link));
+    const int elems[] = {50, 30, 70, 20, 40, 60, 80, 35, 45, 65};
+    tree_item items[10];
+    for ( size_t i = 0; i < 10; ++i ) {
+        items[i].value = elems[i];
+        BOOST_CHECK(bs_tree_insert_node(tree, &items[i].link) == NULL);
+    }
+    BOOST_CHECK_EQUAL(bs_tree_length(tree), 10);
+
+    tree_item key;
+    key.value = 40;
+    BOOST_CHECK(bs_tree_search_data(tree, &key) == &items[4]);
+
+    tree_item dup;
+    dup.value = 40;
+    BOOST_CHECK(bs_tree_insert_node(tree, &dup.link) == &items[4].link);
+    BOOST_CHECK_EQUAL(bs_tree_length(tree), 10);
+    BOOST_CHECK(bs_tree_search_data(tree, &key) == &dup);
+
+    key.value = 30;
+    BOOST_CHECK(bs_tree_delete(tree, &key) == true);
+    BOOST_CHECK(bs_tree_search(tree, &key) == false);
+    BOOST_CHECK_EQUAL(items[1].value, 30);
+
+    std::vector<tree_item *> visited;
+    bs_tree_inorder_left_traverse(tree, collect_item, &visited);
+    const int sorted[] = {20, 35, 40, 45, 50, 60, 65, 70, 80};
+    BOOST_REQUIRE_EQUAL(visited.size(), 9);
+    for ( size_t i = 0; i < 9; ++i ) {
+        BOOST_CHECK_EQUAL(visited[i]->value, sorted[i]);
+    }
+    BOOST_CHECK(visited[2] == &dup);
+
+    bs_tree_free(tree);
+}
+
+BOOST_AUTO_TEST_CASE(bs_tree_intrusive_rejects_data_test) {
+    bs_tree tree = bs_tree_init_intrusive(compare_tree_item, NULL,
+                                          offsetof(tree_item, link));
+    tree_item item;
+    item.value = 1;
+    void * data[] = {&item};
+
+    BOOST_CHECK(exits_with_failure(insert_data, tree, &item));
+    BOOST_CHECK(exits_with_failure(build_sorted_data, tree, data));
+    BOOST_CHECK(bs_tree_isempty(tree));
+
+    bs_tree_free(tree);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+/*
+ *  test_bst_counter.cpp
+ *  ====================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for binary search tree counter map.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static void collect_keys(const char * key, uint64_t count, void * arg) {
+    (void) count;
+    std::vector<std::string> * keys = (std::vector<std::string> *) arg;
+    keys->push_back(key);
+}
+
+BOOST_AUTO_TEST_SUITE(bst_counter_suite)
+
+BOOST_AUTO_TEST_CASE(bst_counter_increment_test) {
+    bst_counter counter = bst_counter_init();
+
+    BOOST_CHECK(bst_counter_isempty(counter));
+    BOOST_CHECK_EQUAL(bst_counter_increment(counter, "delta", 1), 1);
+    BOOST_CHECK_EQUAL(bst_counter_increment(counter, "alpha", 5), 5);
+    BOOST_CHECK_EQUAL(bst_counter_increment(counter, "delta", 1), 2);
+    BOOST_CHECK_EQUAL(bst_counter_increment(counter, "echo", 3), 3);
+    BOOST_CHECK_EQUAL(bst_counter_increment(counter, "delta", 10), 12);
+
+    BOOST_CHECK_EQUAL(bst_counter_length(counter), 3);
+    BOOST_CHECK_EQUAL(bst_counter_get(counter, "delta"), 12);
+    BOOST_CHECK_EQUAL(bst_counter_get(counter, "alpha"), 5);
+    BOOST_CHECK_EQUAL(bst_counter_get(counter, "missing"), 0);
+
+    std::vector<std::string> keys;
+    bst_counter_traverse(counter, collect_keys, &keys);
+    BOOST_REQUIRE_EQUAL(keys.size(), 3);
+    BOOST_CHECK_EQUAL(keys[0], "alpha");
+    BOOST_CHECK_EQUAL(keys[1], "delta");
+    BOOST_CHECK_EQUAL(keys[2], "echo");
+
+    bst_counter_free(counter);
+}
+
+BOOST_AUTO_TEST_CASE(bst_counter_top_test) {
+    bst_counter counter = bst_counter_init();
+
+    bst_counter_increment(counter, "c", 7);
+    bst_counter_increment(counter, "a", 2);
+    bst_counter_increment(counter, "e", 9);
+    bst_counter_increment(counter, "b", 7);
+    bst_counter_increment(counter, "d", 1);
+
+    const char * keys[5];
+    uint64_t counts[5];
+
+    BOOST_CHECK_EQUAL(bst_counter_top(counter, 3, keys, counts), 3);
+    BOOST_CHECK_EQUAL(std::string(keys[0]), "e");
+    BOOST_CHECK_EQUAL(counts[0], 9);
+    BOOST_CHECK_EQUAL(std::string(keys[1]), "b");
+    BOOST_CHECK_EQUAL(counts[1], 7);
+    BOOST_CHECK_EQUAL(std::string(keys[2]), "c");
+    BOOST_CHECK_EQUAL(counts[2], 7);
+
+    BOOST_CHECK_EQUAL(bst_counter_top(counter, 5, keys, NULL), 5);
+    BOOST_CHECK_EQUAL(std::string(keys[3]), "a");
+    BOOST_CHECK_EQUAL(std::string(keys[4]), "d");
+
+    BOOST_CHECK_EQUAL(bst_counter_top(counter, 0, keys, counts), 0);
+
+    bst_counter_free(counter);
+
+    counter = bst_counter_init();
+    BOOST_CHECK_EQUAL(bst_counter_top(counter, 3, keys, counts), 0);
+    bst_counter_free(counter);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
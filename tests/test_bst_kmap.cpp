@@ -0,0 +1,78 @@
+/*
+ *  test_bst_kmap.cpp
+ *  =================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for binary search tree map with integer or binary keys.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+BOOST_AUTO_TEST_SUITE(bst_kmap_suite)
+
+BOOST_AUTO_TEST_CASE(bst_kmap_int_insert_search_test) {
+    bst_kmap map = bst_kmap_init(BST_KMAP_INTEGER);
+
+    bst_kmap_insert_int(map, 9000000000LL, cds_new_int(4));
+    bst_kmap_insert_int(map, -42, cds_new_int(9));
+    bst_kmap_insert_int(map, 0, cds_new_int(16));
+    bst_kmap_insert_int(map, INT64_MAX, cds_new_int(25));
+    bst_kmap_insert_int(map, INT64_MIN, cds_new_int(36));
+
+    BOOST_CHECK_EQUAL(bst_kmap_length(map), 5);
+
+    int * pval = (int *) bst_kmap_search_int_data(map, -42);
+    BOOST_CHECK_EQUAL(*pval, 9);
+    pval = (int *) bst_kmap_search_int_data(map, INT64_MIN);
+    BOOST_CHECK_EQUAL(*pval, 36);
+    BOOST_CHECK(bst_kmap_search_int(map, 9000000000LL) == true);
+    BOOST_CHECK(bst_kmap_search_int(map, 9000000001LL) == false);
+
+    bool duplicate = bst_kmap_insert_int(map, 0, cds_new_int(99));
+    BOOST_CHECK(duplicate);
+    pval = (int *) bst_kmap_search_int_data(map, 0);
+    BOOST_CHECK_EQUAL(*pval, 99);
+    BOOST_CHECK_EQUAL(bst_kmap_length(map), 5);
+
+    bst_kmap_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(bst_kmap_bin_insert_search_test) {
+    bst_kmap map = bst_kmap_init(BST_KMAP_BINARY);
+    const char key1[] = {'s', 'p', 'a', 'm'};
+    const char key2[] = {'s', 'p', 'a', 'm', '\0'};
+    const char key3[] = {'s', '\0', 'a', 'm'};
+
+    bst_kmap_insert_bin(map, key1, sizeof(key1), cds_new_int(4));
+    bst_kmap_insert_bin(map, key2, sizeof(key2), cds_new_int(9));
+    bst_kmap_insert_bin(map, key3, sizeof(key3), cds_new_int(16));
+
+    BOOST_CHECK_EQUAL(bst_kmap_length(map), 3);
+
+    int * pval = (int *) bst_kmap_search_bin_data(map, key1, sizeof(key1));
+    BOOST_CHECK_EQUAL(*pval, 4);
+    pval = (int *) bst_kmap_search_bin_data(map, key2, sizeof(key2));
+    BOOST_CHECK_EQUAL(*pval, 9);
+    pval = (int *) bst_kmap_search_bin_data(map, key3, sizeof(key3));
+    BOOST_CHECK_EQUAL(*pval, 16);
+    BOOST_CHECK(bst_kmap_search_bin(map, key1, 3) == false);
+    BOOST_CHECK(bst_kmap_search_bin(map, "", 0) == false);
+
+    bool duplicate = bst_kmap_insert_bin(map, key3, sizeof(key3),
+                                         cds_new_int(99));
+    BOOST_CHECK(duplicate);
+    pval = (int *) bst_kmap_search_bin_data(map, key3, sizeof(key3));
+    BOOST_CHECK_EQUAL(*pval, 99);
+
+    bst_kmap_free(map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -13,9 +13,16 @@
  */
 
 #include <string>
+#include <vector>
 #include <boost/test/unit_test.hpp>
 #include "../cdatastruct.h"
 
+static void collect_keys(const char * key, void * value, void * arg) {
+    (void) value;
+    std::vector<std::string> * keys = (std::vector<std::string> *) arg;
+    keys->push_back(key);
+}
+
 BOOST_AUTO_TEST_SUITE(bst_map_suite)
 
 BOOST_AUTO_TEST_CASE(bst_map_insert_search_test) {
@@ -63,4 +70,181 @@ BOOST_AUTO_TEST_CASE(bst_map_insert_replace_test) {
     bst_map_free(map);
 }
 
+BOOST_AUTO_TEST_CASE(bst_map_delete_test) {
+    bst_map map = bst_map_init();
+
+    bst_map_insert(map, "bacon", cds_new_int(4));
+    bst_map_insert(map, "eggs", cds_new_int(9));
+    bst_map_insert(map, "spam", cds_new_int(16));
+
+    BOOST_CHECK(bst_map_delete(map, "eggs") == true);
+    BOOST_CHECK(bst_map_delete(map, "eggs") == false);
+    BOOST_CHECK(bst_map_search(map, "eggs") == false);
+    BOOST_CHECK_EQUAL(bst_map_length(map), 2);
+
+    int * pval = (int *) bst_map_search_data(map, "spam");
+    BOOST_CHECK_EQUAL(*pval, 16);
+
+    bst_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(bst_map_traverse_cursor_test) {
+    bst_map map = bst_map_init();
+    const char * keys[] = {"spam", "eggs", "bacon", "toffee", "gruel",
+                           "cheese", "aardvark"};
+    const char * sorted[] = {"aardvark", "bacon", "cheese", "eggs",
+                             "gruel", "spam", "toffee"};
+    for ( size_t i = 0; i < 7; ++i ) {
+        bst_map_insert(map, keys[i], cds_new_int(i));
+    }
+
+    std::vector<std::string> found;
+    bst_map_traverse(map, collect_keys, &found);
+    BOOST_REQUIRE_EQUAL(found.size(), 7);
+    for ( size_t i = 0; i < 7; ++i ) {
+        BOOST_CHECK_EQUAL(found[i], sorted[i]);
+    }
+
+    const char * key;
+    void * value;
+    size_t count = 0;
+    bst_map_cursor cursor = bst_map_cursor_forward(map);
+    while ( bst_map_cursor_next(cursor, &key, &value) ) {
+        BOOST_CHECK_EQUAL(key, sorted[count]);
+        BOOST_CHECK(value == bst_map_search_data(map, key));
+        ++count;
+    }
+    BOOST_CHECK_EQUAL(count, 7);
+    BOOST_CHECK(bst_map_cursor_next(cursor, &key, &value) == false);
+    bst_map_cursor_free(cursor);
+
+    cursor = bst_map_cursor_reverse(map);
+    while ( bst_map_cursor_next(cursor, &key, NULL) ) {
+        BOOST_CHECK_EQUAL(key, sorted[--count]);
+    }
+    BOOST_CHECK_EQUAL(count, 0);
+    bst_map_cursor_free(cursor);
+
+    bst_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(bst_map_insert_batch_test) {
+    bst_map map = bst_map_init();
+    bst_map_insert(map, "bacon", cds_new_int(100));
+    bst_map_insert(map, "spam", cds_new_int(200));
+
+    const char * keys[] = {"toffee", "bacon", "eggs", "aardvark",
+                           "toffee", "cheese"};
+    void * values[6];
+    for ( size_t i = 0; i < 6; ++i ) {
+        values[i] = cds_new_int(i);
+    }
+    bool duplicates[6];
+    const bool expected[] = {false, true, false, false, true, false};
+
+    BOOST_CHECK_EQUAL(bst_map_insert_batch(map, keys, values, 6,
+                                           duplicates), 2);
+    for ( size_t i = 0; i < 6; ++i ) {
+        BOOST_CHECK_EQUAL(duplicates[i], expected[i]);
+    }
+
+    const char * sorted[] = {"aardvark", "bacon", "cheese", "eggs",
+                             "spam", "toffee"};
+    const int sorted_values[] = {3, 1, 5, 2, 200, 4};
+    std::vector<std::string> found;
+    bst_map_traverse(map, collect_keys, &found);
+    BOOST_REQUIRE_EQUAL(found.size(), 6);
+    for ( size_t i = 0; i < 6; ++i ) {
+        BOOST_CHECK_EQUAL(found[i], sorted[i]);
+        int * value = (int *) bst_map_search_data(map, sorted[i]);
+        BOOST_REQUIRE(value);
+        BOOST_CHECK_EQUAL(*value, sorted_values[i]);
+    }
+
+    /*  A large batch is sorted in parallel and built balanced  */
+
+    const size_t n = 50000;
+    std::vector<std::string> big_keys;
+    std::vector<const char *> key_ptrs;
+    std::vector<void *> big_values;
+    for ( size_t i = 0; i < n; ++i ) {
+        big_keys.push_back("key" + std::to_string((i * 7919) % n));
+    }
+    for ( size_t i = 0; i < n; ++i ) {
+        key_ptrs.push_back(big_keys[i].c_str());
+        big_values.push_back(cds_new_int(i));
+    }
+    BOOST_CHECK_EQUAL(bst_map_insert_batch(map, key_ptrs.data(),
+                                           big_values.data(), n, NULL), 0);
+    BOOST_CHECK_EQUAL(bst_map_length(map), n + 6);
+    int * value = (int *) bst_map_search_data(map, "key7919");
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 1);
+
+    bst_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(bst_map_prefix_traverse_test) {
+    bst_map map = bst_map_init();
+    const char * keys[] = {"tenant42/spam", "tenant41/eggs", "tenant420",
+                           "tenant42/bacon", "tenant43/toffee", "tenant42",
+                           "tenant42/gruel", "aardvark", "zebra"};
+    for ( size_t i = 0; i < 9; ++i ) {
+        bst_map_insert(map, keys[i], cds_new_int(i));
+    }
+
+    std::vector<std::string> found;
+    bst_map_prefix_traverse(map, "tenant42/", collect_keys, &found);
+    BOOST_REQUIRE_EQUAL(found.size(), 3);
+    BOOST_CHECK_EQUAL(found[0], "tenant42/bacon");
+    BOOST_CHECK_EQUAL(found[1], "tenant42/gruel");
+    BOOST_CHECK_EQUAL(found[2], "tenant42/spam");
+
+    found.clear();
+    bst_map_prefix_traverse(map, "tenant5", collect_keys, &found);
+    BOOST_CHECK(found.empty());
+
+    found.clear();
+    bst_map_prefix_traverse(map, "", collect_keys, &found);
+    BOOST_REQUIRE_EQUAL(found.size(), 9);
+    BOOST_CHECK_EQUAL(found[0], "aardvark");
+    BOOST_CHECK_EQUAL(found[8], "zebra");
+
+    bst_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(bst_map_filter_test) {
+    bst_map map = bst_map_init();
+    bst_map_attach_filter(map, 1000);
+
+    for ( int i = 0; i < 1000; ++i ) {
+        std::string key = "key" + std::to_string(i);
+        bst_map_insert(map, key.c_str(), cds_new_int(i));
+    }
+
+    for ( int i = 0; i < 2000; ++i ) {
+        std::string key = "key" + std::to_string(i);
+        BOOST_CHECK(bst_map_search(map, key.c_str()) == (i < 1000));
+    }
+
+    bs_tree_filter_stats_t stats;
+    bst_map_filter_stats(map, &stats);
+    BOOST_CHECK_EQUAL(stats.queries, 2000);
+    BOOST_CHECK_EQUAL(stats.hits, 1000);
+    BOOST_CHECK(stats.rejected > 900);
+
+    for ( int i = 0; i < 500; ++i ) {
+        std::string key = "key" + std::to_string(i);
+        bst_map_delete(map, key.c_str());
+    }
+    bst_map_rebuild_filter(map);
+
+    for ( int i = 0; i < 1000; ++i ) {
+        std::string key = "key" + std::to_string(i);
+        BOOST_CHECK(bst_map_search(map, key.c_str()) == (i >= 500));
+    }
+
+    bst_map_free(map);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
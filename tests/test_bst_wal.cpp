@@ -0,0 +1,250 @@
+/*
+ *  test_bst_wal.cpp
+ *  ================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *
+ *  Unit tests for binary search tree map write-ahead log.
+ *
+ *  Uses Boost unit testing framework.
+ *
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static const char * test_file = "test_bst_wal.log";
+
+static const void * int_bytes(const void * value, size_t * len) {
+    *len = sizeof(int);
+    return value;
+}
+
+static void * int_from_bytes(const void * bytes, size_t len) {
+    BOOST_REQUIRE_EQUAL(len, sizeof(int));
+    int n;
+    std::memcpy(&n, bytes, len);
+    return cds_new_int(n);
+}
+
+BOOST_AUTO_TEST_SUITE(bst_wal_suite)
+
+/*  Test replay of insertions and deletions  */
+
+BOOST_AUTO_TEST_CASE(bst_wal_replay_test) {
+    std::remove(test_file);
+
+    bst_map map = bst_map_init();
+    BOOST_REQUIRE(map);
+    BOOST_REQUIRE_EQUAL(bst_map_attach_wal(map, test_file, 1000, NULL), 0);
+
+    bst_map_insert(map, "pear", cds_new_string("green"));
+    bst_map_insert(map, "apple", cds_new_string("red"));
+    bst_map_insert(map, "banana", cds_new_string("yellow"));
+    bst_map_insert(map, "pear", cds_new_string("brown"));
+    bst_map_delete(map, "banana");
+    bst_map_delete(map, "cherry");
+    bst_map_insert(map, "banana", cds_new_string("spotted"));
+    bst_map_delete(map, "apple");
+
+    BOOST_CHECK_EQUAL(bst_map_sync_wal(map), 0);
+    BOOST_CHECK_EQUAL(bst_map_detach_wal(map), 0);
+
+    bst_map replayed = bst_map_replay_wal(test_file, NULL);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK_EQUAL(bst_map_length(replayed), 2);
+    BOOST_CHECK(!bst_map_search(replayed, "apple"));
+    BOOST_CHECK_EQUAL(static_cast<char *>(bst_map_search_data(replayed,
+                      "pear")), "brown");
+    BOOST_CHECK_EQUAL(static_cast<char *>(bst_map_search_data(replayed,
+                      "banana")), "spotted");
+
+    bst_map_free(replayed);
+    bst_map_free(map);
+    std::remove(test_file);
+}
+
+/*  Test that a NULL value replays as NULL, not as an empty value  */
+
+BOOST_AUTO_TEST_CASE(bst_wal_null_value_test) {
+    std::remove(test_file);
+
+    bst_map map = bst_map_init();
+    BOOST_REQUIRE_EQUAL(bst_map_attach_wal(map, test_file, 0, NULL), 0);
+    bst_map_insert(map, "none", NULL);
+    bst_map_insert(map, "empty", cds_new_string(""));
+    bst_map_insert(map, "later", cds_new_string("set"));
+    bst_map_insert(map, "later", NULL);
+    BOOST_CHECK_EQUAL(bst_map_detach_wal(map), 0);
+
+    bst_map replayed = bst_map_replay_wal(test_file, NULL);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK_EQUAL(bst_map_length(replayed), 3);
+    BOOST_CHECK(bst_map_search(replayed, "none"));
+    BOOST_CHECK(bst_map_search_data(replayed, "none") == NULL);
+    BOOST_CHECK(bst_map_search(replayed, "later"));
+    BOOST_CHECK(bst_map_search_data(replayed, "later") == NULL);
+    BOOST_CHECK_EQUAL(static_cast<char *>(bst_map_search_data(replayed,
+                      "empty")), "");
+    bst_map_free(replayed);
+
+    /*  NULL values bypass the serializer in a checkpoint and replay  */
+
+    bst_map_delete(map, "empty");
+    BOOST_REQUIRE_EQUAL(bst_map_attach_wal(map, test_file, 0,
+                                           int_bytes), 0);
+    BOOST_CHECK_EQUAL(bst_map_checkpoint_wal(map), 0);
+    BOOST_CHECK_EQUAL(bst_map_detach_wal(map), 0);
+
+    replayed = bst_map_replay_wal(test_file, int_from_bytes);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK_EQUAL(bst_map_length(replayed), 2);
+    BOOST_CHECK(bst_map_search(replayed, "none"));
+    BOOST_CHECK(bst_map_search_data(replayed, "none") == NULL);
+    BOOST_CHECK(bst_map_search_data(replayed, "later") == NULL);
+    bst_map_free(replayed);
+
+    bst_map_free(map);
+    std::remove(test_file);
+}
+
+/*  Test replay of serialized values and rebuilding a large map  */
+
+BOOST_AUTO_TEST_CASE(bst_wal_serialized_test) {
+    std::remove(test_file);
+
+    bst_map map = bst_map_init();
+    BOOST_REQUIRE_EQUAL(bst_map_attach_wal(map, test_file, 0,
+                                           int_bytes), 0);
+
+    char key[16];
+    for ( int i = 0; i < 1000; ++i ) {
+        std::sprintf(key, "key%04d", i);
+        bst_map_insert(map, key, cds_new_int(i));
+    }
+    for ( int i = 0; i < 1000; i += 2 ) {
+        std::sprintf(key, "key%04d", i);
+        bst_map_delete(map, key);
+    }
+
+    bst_map_free(map);
+
+    bst_map replayed = bst_map_replay_wal(test_file, int_from_bytes);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK_EQUAL(bst_map_length(replayed), 500);
+    for ( int i = 0; i < 1000; ++i ) {
+        std::sprintf(key, "key%04d", i);
+        int * value = static_cast<int *>(bst_map_search_data(replayed, key));
+        if ( i % 2 ) {
+            BOOST_REQUIRE(value);
+            BOOST_CHECK_EQUAL(*value, i);
+        } else {
+            BOOST_CHECK(!value);
+        }
+    }
+
+    bst_map_free(replayed);
+    std::remove(test_file);
+}
+
+/*  Test replay stops at a torn final record  */
+
+BOOST_AUTO_TEST_CASE(bst_wal_torn_tail_test) {
+    std::remove(test_file);
+
+    bst_map map = bst_map_init();
+    BOOST_REQUIRE_EQUAL(bst_map_attach_wal(map, test_file, 0, NULL), 0);
+    bst_map_insert(map, "first", cds_new_string("one"));
+    bst_map_insert(map, "second", cds_new_string("two"));
+    bst_map_free(map);
+
+    FILE * fp = std::fopen(test_file, "rb");
+    BOOST_REQUIRE(fp);
+    std::fseek(fp, 0, SEEK_END);
+    const long size = std::ftell(fp);
+    std::fclose(fp);
+    BOOST_REQUIRE_EQUAL(truncate(test_file, size - 2), 0);
+
+    bst_map replayed = bst_map_replay_wal(test_file, NULL);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK_EQUAL(bst_map_length(replayed), 1);
+    BOOST_CHECK(bst_map_search(replayed, "first"));
+    BOOST_CHECK(!bst_map_search(replayed, "second"));
+    bst_map_free(replayed);
+
+    /*  Corrupt a byte in the first record  */
+
+    fp = std::fopen(test_file, "r+b");
+    BOOST_REQUIRE(fp);
+    std::fseek(fp, 15, SEEK_SET);
+    std::fputc('X', fp);
+    std::fclose(fp);
+
+    replayed = bst_map_replay_wal(test_file, NULL);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK(bst_map_isempty(replayed));
+    bst_map_free(replayed);
+
+    std::remove(test_file);
+}
+
+/*  Test a missing log replays as an empty map  */
+
+BOOST_AUTO_TEST_CASE(bst_wal_missing_test) {
+    std::remove(test_file);
+
+    bst_map replayed = bst_map_replay_wal(test_file, NULL);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK(bst_map_isempty(replayed));
+    bst_map_free(replayed);
+}
+
+/*  Test checkpoint replaces log with a snapshot of the map  */
+
+BOOST_AUTO_TEST_CASE(bst_wal_checkpoint_test) {
+    std::remove(test_file);
+
+    bst_map map = bst_map_init();
+    BOOST_REQUIRE_EQUAL(bst_map_attach_wal(map, test_file, 1000, NULL), 0);
+
+    char key[16];
+    for ( int i = 0; i < 100; ++i ) {
+        std::sprintf(key, "key%03d", i % 10);
+        bst_map_insert(map, key, cds_new_string("value"));
+    }
+    BOOST_REQUIRE_EQUAL(bst_map_sync_wal(map), 0);
+
+    FILE * fp = std::fopen(test_file, "rb");
+    std::fseek(fp, 0, SEEK_END);
+    const long before = std::ftell(fp);
+    std::fclose(fp);
+
+    BOOST_REQUIRE_EQUAL(bst_map_checkpoint_wal(map), 0);
+
+    fp = std::fopen(test_file, "rb");
+    std::fseek(fp, 0, SEEK_END);
+    const long after = std::ftell(fp);
+    std::fclose(fp);
+    BOOST_CHECK_EQUAL(after * 10, before);
+
+    bst_map_insert(map, "extra", cds_new_string("appended"));
+    BOOST_CHECK_EQUAL(bst_map_detach_wal(map), 0);
+
+    bst_map replayed = bst_map_replay_wal(test_file, NULL);
+    BOOST_REQUIRE(replayed);
+    BOOST_CHECK_EQUAL(bst_map_length(replayed), 11);
+    BOOST_CHECK_EQUAL(static_cast<char *>(bst_map_search_data(replayed,
+                      "extra")), "appended");
+
+    bst_map_free(replayed);
+    bst_map_free(map);
+    std::remove(test_file);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
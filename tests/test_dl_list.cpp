@@ -12,10 +12,80 @@
  *  http://www.gnu.org/licenses/
  */
 
+#include <cstdlib>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <boost/test/unit_test.hpp>
 #include "../cdatastruct.h"
 
+static int compare_last_digit(const void * data, const void * cmp) {
+    return *((const int *) data) % 10 - *((const int *) cmp) % 10;
+}
+
+static bool last_digit_less(const int a, const int b) {
+    return a % 10 < b % 10;
+}
+
+struct filter_arg {
+    int divisor;
+    int sunk;
+};
+
+static bool is_multiple_of(const void * data, void * arg) {
+    return *((const int *) data) % ((filter_arg *) arg)->divisor == 0;
+}
+
+static bool is_negative(const void * data, void * arg) {
+    (void) arg;
+    return *((const int *) data) < 0;
+}
+
+static void sink_count(void * data, void * arg) {
+    ++((filter_arg *) arg)->sunk;
+    free(data);
+}
+
+static void check_contents(dl_list list, const int * expected,
+                           const size_t n) {
+    BOOST_REQUIRE_EQUAL(dl_list_length(list), n);
+
+    size_t i = 0;
+    for ( dl_list_itr itr = dl_list_first(list); itr;
+          itr = dl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), expected[i++]);
+    }
+    BOOST_CHECK_EQUAL(i, n);
+
+    for ( dl_list_itr itr = dl_list_last(list); itr;
+          itr = dl_list_prev(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), expected[--i]);
+    }
+    BOOST_CHECK_EQUAL(i, 0);
+}
+
+/*  `value` comes first, so check_contents() can read it through `data`  */
+
+struct dl_item {
+    int value;
+    dl_list_node_t link;
+};
+
+static int compare_dl_item(const void * data, const void * cmp) {
+    return ((const dl_item *) data)->value - ((const dl_item *) cmp)->value;
+}
+
+static dl_item * new_dl_item(const int value) {
+    dl_item * item = (dl_item *) std::malloc(sizeof(*item));
+    item->value = value;
+    return item;
+}
+
+static bool is_odd_item(const void * data, void * arg) {
+    (void) arg;
+    return ((const dl_item *) data)->value % 2 != 0;
+}
+
 BOOST_AUTO_TEST_SUITE(dl_list_suite)
 
 BOOST_AUTO_TEST_CASE(dl_list_prepend_delete_front_test) {
@@ -246,4 +316,444 @@ BOOST_AUTO_TEST_CASE(dl_list_find_insert_index_test) {
     dl_list_free(list);
 }
 
+BOOST_AUTO_TEST_CASE(dl_list_sort_test) {
+    dl_list list = dl_list_init(cds_compare_int, NULL);
+    std::vector<int> values;
+    for ( int i = 0; i < 1000; ++i ) {
+        values.push_back((i * 37) % 1000);
+        dl_list_append(list, (void *) cds_new_int(values.back()));
+    }
+
+    /*  Stable sort by last digit keeps equal digits in list order  */
+
+    dl_list_sort_by(list, compare_last_digit);
+    std::stable_sort(values.begin(), values.end(), last_digit_less);
+    size_t i = 0;
+    for ( dl_list_itr itr = dl_list_first(list); itr;
+          itr = dl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), values[i++]);
+    }
+    BOOST_CHECK_EQUAL(i, 1000);
+
+    dl_list_sort(list);
+    i = 0;
+    for ( dl_list_itr itr = dl_list_first(list); itr;
+          itr = dl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), (int) i++);
+    }
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(list)->data), 999);
+
+    /*  Walk backwards to check the previous links  */
+
+    int expected_value = 999;
+    for ( dl_list_itr itr = dl_list_last(list); itr;
+          itr = dl_list_prev(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), expected_value--);
+    }
+    BOOST_CHECK_EQUAL(expected_value, -1);
+
+    dl_list_append(list, (void *) cds_new_int(-1));
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(list)->data), -1);
+    BOOST_CHECK_EQUAL(dl_list_length(list), 1001);
+
+    dl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(dl_list_delete_remove_itr_test) {
+    dl_list list = dl_list_init(cds_compare_int, NULL);
+    for ( int i = 0; i < 100; ++i ) {
+        dl_list_append(list, (void *) cds_new_int(i));
+    }
+
+    /*  Delete odd elements, including the last, in one pass  */
+
+    dl_list_itr itr = dl_list_first(list);
+    while ( itr ) {
+        dl_list_itr next = dl_list_next(itr);
+        if ( *((int *) itr->data) % 2 ) {
+            BOOST_CHECK_EQUAL(dl_list_delete_itr(list, itr), 0);
+        }
+        itr = next;
+    }
+    BOOST_CHECK_EQUAL(dl_list_length(list), 50);
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(list)->data), 98);
+
+    int * data = (int *) dl_list_remove_itr(list, dl_list_first(list));
+    BOOST_REQUIRE(data);
+    BOOST_CHECK_EQUAL(*data, 0);
+    free(data);
+    BOOST_CHECK_EQUAL(*((int *) dl_list_first(list)->data), 2);
+    BOOST_CHECK(dl_list_first(list)->prev == NULL);
+
+    int i = 2;
+    for ( itr = dl_list_first(list); itr; itr = dl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), i);
+        i += 2;
+    }
+
+    BOOST_CHECK_EQUAL(dl_list_delete_itr(list, NULL), CDSERR_BADITERATOR);
+    BOOST_CHECK(dl_list_remove_itr(list, NULL) == NULL);
+
+    dl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(dl_list_remove_if_partition_test) {
+    dl_list list = dl_list_init(cds_compare_int, NULL);
+    for ( int i = 0; i < 100; ++i ) {
+        dl_list_append(list, (void *) cds_new_int(i));
+    }
+
+    /*  Multiples of 3 are freed, including the first element  */
+
+    filter_arg arg = {3, 0};
+    BOOST_CHECK_EQUAL(dl_list_remove_if(list, is_multiple_of, NULL, &arg),
+                      34);
+    BOOST_CHECK_EQUAL(dl_list_length(list), 66);
+    BOOST_CHECK_EQUAL(*((int *) dl_list_first(list)->data), 1);
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(list)->data), 98);
+
+    /*  Multiples of 7, and then a negative element, go to a sink  */
+
+    arg.divisor = 7;
+    BOOST_CHECK_EQUAL(dl_list_remove_if(list, is_multiple_of, sink_count,
+                                      &arg), 10);
+    BOOST_CHECK_EQUAL(arg.sunk, 10);
+    BOOST_CHECK_EQUAL(dl_list_remove_if(list, is_negative, sink_count, &arg),
+                      0);
+    dl_list_append(list, (void *) cds_new_int(-5));
+    BOOST_CHECK_EQUAL(dl_list_remove_if(list, is_negative, sink_count, &arg),
+                      1);
+    BOOST_CHECK_EQUAL(arg.sunk, 11);
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(list)->data), 97);
+
+    /*  Even elements move to a second list in order  */
+
+    dl_list evens = dl_list_init(cds_compare_int, NULL);
+    dl_list_append(evens, (void *) cds_new_int(0));
+    arg.divisor = 2;
+    const size_t moved = dl_list_partition(list, evens, is_multiple_of, &arg);
+    BOOST_CHECK_EQUAL(dl_list_length(list) + dl_list_length(evens), 57);
+    BOOST_CHECK_EQUAL(dl_list_length(evens), moved + 1);
+
+    int previous = -1;
+    for ( dl_list_itr itr = dl_list_first(evens); itr;
+          itr = dl_list_next(itr) ) {
+        const int value = *((int *) itr->data);
+        BOOST_CHECK(value % 2 == 0 && value > previous);
+        previous = value;
+    }
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(evens)->data), previous);
+    for ( dl_list_itr itr = dl_list_first(list); itr;
+          itr = dl_list_next(itr) ) {
+        BOOST_CHECK(*((int *) itr->data) % 2 == 1);
+    }
+    BOOST_CHECK_EQUAL(*((int *) dl_list_last(list)->data), 97);
+
+    dl_list_free(evens);
+    dl_list_free(list);
+}
+
+/*  Test splicing ranges between and within lists  */
+
+BOOST_AUTO_TEST_CASE(dl_list_splice_test) {
+    dl_list src = dl_list_init(cds_compare_int, NULL);
+    dl_list dst = dl_list_init(cds_compare_int, NULL);
+
+    for ( int i = 0; i < 6; ++i ) {
+        dl_list_append(src, (void *) cds_new_int(i));
+        dl_list_append(dst, (void *) cds_new_int(i + 10));
+    }
+
+    BOOST_CHECK_EQUAL(dl_list_splice(dst, NULL, src, NULL,
+                                     dl_list_last(src)),
+                      CDSERR_BADITERATOR);
+    BOOST_CHECK_EQUAL(dl_list_splice(dst, NULL, src, dl_list_first(src),
+                                     NULL), CDSERR_BADITERATOR);
+
+    /*  A middle range goes before a middle element  */
+
+    BOOST_CHECK_EQUAL(dl_list_splice(dst, dl_list_itr_from_index(dst, 2), src,
+                                     dl_list_itr_from_index(src, 1),
+                                     dl_list_itr_from_index(src, 3)), 0);
+    const int first_src[] = {0, 4, 5};
+    const int first_dst[] = {10, 11, 1, 2, 3, 12, 13, 14, 15};
+    check_contents(src, first_src, 3);
+    check_contents(dst, first_dst, 9);
+
+    /*  A single element goes to the front, and another to the back  */
+
+    dl_list_splice(dst, dl_list_first(dst), src,
+                   dl_list_last(src), dl_list_last(src));
+    dl_list_splice(dst, NULL, src, dl_list_first(src), dl_list_first(src));
+    const int second_src[] = {4};
+    const int second_dst[] = {5, 10, 11, 1, 2, 3, 12, 13, 14, 15, 0};
+    check_contents(src, second_src, 1);
+    check_contents(dst, second_dst, 11);
+
+    /*  The whole of a list goes into an empty list  */
+
+    dl_list_splice(src, NULL, dst, dl_list_first(dst), dl_list_last(dst));
+    const int third_src[] = {4, 5, 10, 11, 1, 2, 3, 12, 13, 14, 15, 0};
+    check_contents(src, third_src, 12);
+    BOOST_CHECK(dl_list_isempty(dst));
+    BOOST_CHECK(dl_list_first(dst) == NULL && dl_list_last(dst) == NULL);
+
+    /*  A range moves within the same list  */
+
+    dl_list_splice(src, dl_list_first(src), src,
+                   dl_list_itr_from_index(src, 4),
+                   dl_list_itr_from_index(src, 6));
+    dl_list_splice(src, NULL, src, dl_list_first(src),
+                   dl_list_itr_from_index(src, 1));
+    const int fourth_src[] = {3, 4, 5, 10, 11, 12, 13, 14, 15, 0, 1, 2};
+    check_contents(src, fourth_src, 12);
+
+    dl_list_free(dst);
+    dl_list_free(src);
+}
+
+/*  Test an indexed list against a vector through positional and
+ *  iterator operations                                            */
+
+BOOST_AUTO_TEST_CASE(dl_list_indexed_test) {
+    dl_list list = dl_list_init_indexed(cds_compare_int, NULL);
+    std::vector<int> values;
+    unsigned int seed = 12345;
+
+    for ( int i = 0; i < 4000; ++i ) {
+        seed = seed * 1103515245 + 12345;
+        const size_t r = (seed >> 8) % 1000;
+        const size_t index = values.empty() ? 0 : r % (values.size() + 1);
+
+        if ( r < 550 || values.empty() ) {
+            BOOST_REQUIRE_EQUAL(dl_list_insert_at(list, index,
+                                        (void *) cds_new_int(i)), 0);
+            values.insert(values.begin() + index, i);
+        } else if ( r < 850 ) {
+            const size_t at = index % values.size();
+            BOOST_REQUIRE_EQUAL(dl_list_delete_at(list, at), 0);
+            values.erase(values.begin() + at);
+        } else if ( r < 900 ) {
+            dl_list_append(list, (void *) cds_new_int(i));
+            values.push_back(i);
+        } else if ( r < 950 ) {
+            dl_list_prepend(list, (void *) cds_new_int(i));
+            values.insert(values.begin(), i);
+        } else if ( r < 980 ) {
+
+            /*  Iterator operations leave the index to be rebuilt  */
+
+            const size_t at = index % values.size();
+            dl_list_insert_after(list, dl_list_itr_from_index(list, at),
+                                 (void *) cds_new_int(i));
+            values.insert(values.begin() + at + 1, i);
+        } else {
+            const size_t at = index % values.size();
+            dl_list_delete_itr(list, dl_list_itr_from_index(list, at));
+            values.erase(values.begin() + at);
+        }
+
+        BOOST_REQUIRE_EQUAL(dl_list_length(list), values.size());
+        if ( !values.empty() ) {
+            const size_t at = r % values.size();
+            int * data = (int *) dl_list_data(list, at);
+            BOOST_REQUIRE(data);
+            BOOST_REQUIRE_EQUAL(*data, values[at]);
+        }
+    }
+
+    BOOST_CHECK(dl_list_itr_from_index(list, values.size()) == NULL);
+    BOOST_CHECK_EQUAL(dl_list_insert_at(list, values.size() + 1,
+                                        (void *) &seed), CDSERR_OUTOFRANGE);
+    BOOST_CHECK_EQUAL(dl_list_delete_at(list, values.size()),
+                      CDSERR_OUTOFRANGE);
+    check_contents(list, &values[0], values.size());
+
+    /*  Sorting leaves the index to be rebuilt  */
+
+    dl_list_sort(list);
+    std::sort(values.begin(), values.end());
+    for ( size_t i = 0; i < values.size(); ++i ) {
+        BOOST_CHECK_EQUAL(*((int *) dl_list_data(list, i)), values[i]);
+    }
+
+    dl_list_free(list);
+}
+
+/*  Test index lookups stay correct as the list changes between them  */
+
+BOOST_AUTO_TEST_CASE(dl_list_sequential_index_test) {
+    dl_list list = dl_list_init(cds_compare_int, NULL);
+    std::vector<int> values;
+
+    for ( int i = 0; i < 1000; ++i ) {
+        dl_list_append(list, (void *) cds_new_int(i));
+        values.push_back(i);
+    }
+
+    for ( int pass = 0; pass < 6; ++pass ) {
+        for ( size_t i = 0; i < values.size(); ++i ) {
+            BOOST_REQUIRE_EQUAL(*((int *) dl_list_data(list, i)), values[i]);
+        }
+        for ( size_t i = values.size(); i-- > 0; ) {
+            BOOST_REQUIRE_EQUAL(*((int *) dl_list_data(list, i)), values[i]);
+        }
+        /*  Each change moves elements after a cached index  */
+
+        const size_t mid = values.size() / 2;
+        switch ( pass ) {
+        case 0:
+            dl_list_delete_at(list, mid);
+            values.erase(values.begin() + mid);
+            break;
+        case 1:
+            dl_list_insert_at(list, mid, (void *) cds_new_int(-1));
+            values.insert(values.begin() + mid, -1);
+            break;
+        case 2:
+            dl_list_prepend(list, (void *) cds_new_int(-2));
+            values.insert(values.begin(), -2);
+            break;
+        case 3:
+            dl_list_insert_after(list, dl_list_itr_from_index(list, mid),
+                                 (void *) cds_new_int(-3));
+            values.insert(values.begin() + mid + 1, -3);
+            break;
+        case 4:
+            dl_list_sort_by(list, compare_last_digit);
+            std::stable_sort(values.begin(), values.end(), last_digit_less);
+            break;
+        default:
+            dl_list_append(list, (void *) cds_new_int(-4));
+            values.push_back(-4);
+            break;
+        }
+    }
+
+    dl_list_free(list);
+}
+
+/*  Test iterators and insertions at both ends of the list  */
+
+BOOST_AUTO_TEST_CASE(dl_list_ends_test) {
+    dl_list list = dl_list_init(cds_compare_int, NULL);
+
+    BOOST_CHECK(dl_list_first(list) == NULL);
+    BOOST_CHECK(dl_list_last(list) == NULL);
+
+    dl_list_append(list, (void *) cds_new_int(2));
+    BOOST_CHECK(dl_list_first(list) == dl_list_last(list));
+    BOOST_CHECK(dl_list_first(list)->next == NULL);
+    BOOST_CHECK(dl_list_first(list)->prev == NULL);
+
+    dl_list_insert_before(list, dl_list_first(list), (void *) cds_new_int(1));
+    dl_list_insert_after(list, dl_list_last(list), (void *) cds_new_int(3));
+    const int expected[] = {1, 2, 3};
+    check_contents(list, expected, 3);
+    BOOST_CHECK(dl_list_first(list)->prev == NULL);
+    BOOST_CHECK(dl_list_last(list)->next == NULL);
+
+    int * data = (int *) dl_list_remove_itr(list, dl_list_last(list));
+    BOOST_CHECK_EQUAL(*data, 3);
+    std::free(data);
+    dl_list_delete_at(list, 0);
+    BOOST_CHECK_EQUAL(*((int *) dl_list_first(list)->data), 2);
+    BOOST_CHECK(dl_list_first(list) == dl_list_last(list));
+
+    dl_list_delete_itr(list, dl_list_first(list));
+    BOOST_CHECK(dl_list_isempty(list));
+    BOOST_CHECK(dl_list_first(list) == NULL);
+
+    dl_list_free(list);
+}
+
+/*  Test a circular list, and moving nodes to and from one  */
+
+BOOST_AUTO_TEST_CASE(dl_list_circular_test) {
+    dl_list list = dl_list_init_circular(cds_compare_int, NULL);
+
+    BOOST_CHECK(dl_list_isempty(list));
+    BOOST_CHECK(dl_list_first(list) == NULL);
+    BOOST_CHECK(dl_list_last(list) == NULL);
+
+    dl_list_append(list, (void *) cds_new_int(2));
+    BOOST_CHECK(dl_list_next(dl_list_first(list)) == NULL);
+    BOOST_CHECK(dl_list_prev(dl_list_first(list)) == NULL);
+
+    dl_list_prepend(list, (void *) cds_new_int(1));
+    dl_list_insert_after(list, dl_list_last(list), (void *) cds_new_int(0));
+    dl_list_insert_at(list, 2, (void *) cds_new_int(3));
+    const int expected[] = {1, 2, 3, 0};
+    check_contents(list, expected, 4);
+
+    dl_list_sort(list);
+    const int sorted[] = {0, 1, 2, 3};
+    check_contents(list, sorted, 4);
+    BOOST_CHECK_EQUAL(dl_list_find_index(list, sorted + 3), 3);
+
+    dl_list linear = dl_list_init(cds_compare_int, NULL);
+    dl_list_append(linear, (void *) cds_new_int(9));
+    dl_list_splice(linear, NULL, list, dl_list_first(list),
+                   dl_list_itr_from_index(list, 1));
+    dl_list_splice(list, NULL, linear, dl_list_first(linear),
+                   dl_list_first(linear));
+    const int moved[] = {0, 1};
+    const int kept[] = {2, 3, 9};
+    check_contents(linear, moved, 2);
+    check_contents(list, kept, 3);
+    BOOST_CHECK(dl_list_first(linear)->prev == NULL);
+    BOOST_CHECK(dl_list_last(linear)->next == NULL);
+
+    dl_list_delete_at(list, 0);
+    dl_list_delete_itr(list, dl_list_last(list));
+    int * data = (int *) dl_list_remove_itr(list, dl_list_first(list));
+    BOOST_CHECK_EQUAL(*data, 3);
+    std::free(data);
+    BOOST_CHECK(dl_list_isempty(list));
+    BOOST_CHECK(dl_list_last(list) == NULL);
+
+    dl_list_free(linear);
+    dl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(dl_list_intrusive_test) {
+    dl_list list = dl_list_init_intrusive(compare_dl_item, std::free,
+                                          offsetof(dl_item, link));
+
+    for ( int i = 1; i < 9; ++i ) {
+        if ( i != 5 ) {
+            dl_list_append_node(list, &new_dl_item(i)->link);
+        }
+    }
+    dl_list_prepend_node(list, &new_dl_item(0)->link);
+    dl_list_insert_node_after(list, dl_list_last(list), &new_dl_item(9)->link);
+    dl_list_insert_node_before(list, dl_list_itr_from_index(list, 5),
+                               &new_dl_item(5)->link);
+
+    dl_item * extra = new_dl_item(10);
+    BOOST_CHECK(dl_list_insert_node_before(list, NULL, &extra->link) ==
+                CDSERR_BADITERATOR);
+    dl_list_insert_node_after(list, dl_list_first(list), &extra->link);
+
+    const int expected[] = {0, 10, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    check_contents(list, expected, 11);
+
+    dl_list_itr itr = dl_list_find_itr(list, extra);
+    BOOST_CHECK(itr == &extra->link);
+    BOOST_CHECK(cds_container_of(itr, dl_item, link) == extra);
+    BOOST_CHECK(dl_list_remove_itr(list, itr) == extra);
+    std::free(extra);
+
+    BOOST_CHECK_EQUAL(dl_list_remove_if(list, is_odd_item, NULL, NULL), 5);
+    const int evens[] = {0, 2, 4, 6, 8};
+    check_contents(list, evens, 5);
+
+    dl_list_delete_itr(list, dl_list_first(list));
+    dl_list_delete_at(list, 3);
+    const int middle[] = {2, 4, 6};
+    check_contents(list, middle, 3);
+
+    dl_list_free(list);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,67 @@
+/*
+ *  test_frozen_map.cpp
+ *  ===================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for frozen perfect hash map.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+BOOST_AUTO_TEST_SUITE(frozen_map_suite)
+
+BOOST_AUTO_TEST_CASE(frozen_map_search_test) {
+    bst_map map = bst_map_init();
+    for ( int i = 0; i < 5000; ++i ) {
+        std::string key = "route/" + std::to_string(i);
+        bst_map_insert(map, key.c_str(), cds_new_int(i));
+    }
+
+    frozen_map fmap = bst_map_freeze(map);
+    BOOST_REQUIRE(fmap != NULL);
+    BOOST_CHECK_EQUAL(frozen_map_length(fmap), 5000);
+
+    bool all_found = true;
+    for ( int i = 0; i < 5000; ++i ) {
+        std::string key = "route/" + std::to_string(i);
+        int * pval = (int *) frozen_map_search_data(fmap, key.c_str());
+        if ( pval == NULL || *pval != i ) {
+            all_found = false;
+        }
+    }
+    BOOST_CHECK(all_found);
+
+    BOOST_CHECK(frozen_map_search(fmap, "route/5000") == false);
+    BOOST_CHECK(frozen_map_search(fmap, "route/") == false);
+    BOOST_CHECK(frozen_map_search_data(fmap, "") == NULL);
+
+    frozen_map_free(fmap);
+    bst_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(frozen_map_empty_test) {
+    bst_map map = bst_map_init();
+    frozen_map fmap = bst_map_freeze(map);
+    BOOST_REQUIRE(fmap != NULL);
+    BOOST_CHECK(frozen_map_isempty(fmap) == true);
+    BOOST_CHECK(frozen_map_search(fmap, "spam") == false);
+    frozen_map_free(fmap);
+
+    bst_map_insert(map, "spam", cds_new_int(16));
+    fmap = bst_map_freeze(map);
+    BOOST_CHECK_EQUAL(*((int *) frozen_map_search_data(fmap, "spam")), 16);
+    BOOST_CHECK(frozen_map_search(fmap, "eggs") == false);
+    frozen_map_free(fmap);
+
+    bst_map_free(map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
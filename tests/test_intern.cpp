@@ -0,0 +1,118 @@
+/*
+ *  test_intern.cpp
+ *  ===============
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *
+ *  Unit tests for string interning table.
+ *
+ *  Uses Boost unit testing framework.
+ *
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+BOOST_AUTO_TEST_SUITE(intern_suite)
+
+/*  Test equal strings intern to the same pointer  */
+
+BOOST_AUTO_TEST_CASE(intern_string_test) {
+    intern_table table = intern_table_init();
+    BOOST_REQUIRE(table);
+
+    char buffer[] = "metric.cpu.user";
+    const char * first = intern_string(table, buffer);
+    BOOST_CHECK(first != buffer);
+    BOOST_CHECK_EQUAL(first, "metric.cpu.user");
+
+    std::strcpy(buffer, "metric.cpu.idle");
+    const char * second = intern_string(table, buffer);
+    BOOST_CHECK(second != first);
+
+    BOOST_CHECK(intern_string(table, "metric.cpu.user") == first);
+    BOOST_CHECK(intern_lookup(table, "metric.cpu.idle") == second);
+    BOOST_CHECK(!intern_lookup(table, "metric.cpu.system"));
+    BOOST_CHECK_EQUAL(intern_table_length(table), 2);
+
+    intern_table_free(table);
+}
+
+/*  Test strings survive growth of the table and its arena  */
+
+BOOST_AUTO_TEST_CASE(intern_growth_test) {
+    intern_table table = intern_table_init();
+    const int num_strings = 20000;
+    const char ** canonical = new const char *[num_strings];
+    char key[32];
+
+    for ( int i = 0; i < num_strings; ++i ) {
+        std::sprintf(key, "metric.%08d", i);
+        canonical[i] = intern_string(table, key);
+    }
+
+    /*  A string larger than an arena block gets a block of its own  */
+
+    std::string big(100000, 'x');
+    const char * big_canonical = intern_string(table, big.c_str());
+
+    BOOST_CHECK_EQUAL(intern_table_length(table), num_strings + 1);
+    BOOST_CHECK(intern_table_bytes(table) >= num_strings * 16 + big.size());
+
+    bool all_found = true;
+    for ( int i = 0; i < num_strings; ++i ) {
+        std::sprintf(key, "metric.%08d", i);
+        if ( intern_lookup(table, key) != canonical[i] ||
+             std::strcmp(canonical[i], key) != 0 ) {
+            all_found = false;
+        }
+    }
+    BOOST_CHECK(all_found);
+    BOOST_CHECK(intern_lookup(table, big.c_str()) == big_canonical);
+
+    delete[] canonical;
+    intern_table_free(table);
+}
+
+/*  Test maps with interned keys share canonical keys  */
+
+BOOST_AUTO_TEST_CASE(intern_bst_map_test) {
+    intern_table table = intern_table_init();
+    bst_map first = bst_map_init_interned(table);
+    bst_map second = bst_map_init_interned(table);
+
+    bst_map_insert(first, "cpu", cds_new_int(1));
+    bst_map_insert(first, "disk", cds_new_int(2));
+    bst_map_insert(second, "cpu", cds_new_int(3));
+    BOOST_CHECK(bst_map_insert(first, "cpu", cds_new_int(4)));
+    BOOST_CHECK_EQUAL(intern_table_length(table), 2);
+
+    int * value = static_cast<int *>(bst_map_search_data(first, "cpu"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 4);
+    value = static_cast<int *>(bst_map_search_data(second, "cpu"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 3);
+
+    char buffer[] = "disk";
+    BOOST_CHECK(bst_map_search(first, buffer));
+    BOOST_CHECK(bst_map_search(first, intern_lookup(table, "disk")));
+    BOOST_CHECK(!bst_map_search(second, "disk"));
+    BOOST_CHECK(!bst_map_search(first, "memory"));
+    BOOST_CHECK(!bst_map_search_data(first, "memory"));
+    BOOST_CHECK(!bst_map_delete(first, "memory"));
+    BOOST_CHECK(!bst_map_delete(second, "disk"));
+    BOOST_CHECK(bst_map_delete(first, "disk"));
+    BOOST_CHECK_EQUAL(bst_map_length(first), 1);
+
+    bst_map_free(first);
+    bst_map_free(second);
+    intern_table_free(table);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+/*
+ *  test_lru_cache.cpp
+ *  ==================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for least recently used cache.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static void collect_evicted(const char * key, void * value, void * arg) {
+    std::vector<std::string> * keys = (std::vector<std::string> *) arg;
+    keys->push_back(key);
+    free(value);
+}
+
+BOOST_AUTO_TEST_SUITE(lru_cache_suite)
+
+BOOST_AUTO_TEST_CASE(lru_cache_entry_capacity_test) {
+    std::vector<std::string> evicted;
+    lru_cache cache = lru_cache_init(3, collect_evicted, &evicted);
+
+    BOOST_CHECK(lru_cache_isempty(cache));
+    BOOST_CHECK(lru_cache_put(cache, "one", cds_new_int(1), 1) == false);
+    lru_cache_put(cache, "two", cds_new_int(2), 1);
+    lru_cache_put(cache, "three", cds_new_int(3), 1);
+    BOOST_CHECK_EQUAL(lru_cache_length(cache), 3);
+
+    /*  Touching "one" leaves "two" as the least recently used  */
+
+    int * pval = (int *) lru_cache_get(cache, "one");
+    BOOST_REQUIRE(pval);
+    BOOST_CHECK_EQUAL(*pval, 1);
+
+    lru_cache_put(cache, "four", cds_new_int(4), 1);
+    BOOST_CHECK_EQUAL(lru_cache_length(cache), 3);
+    BOOST_REQUIRE_EQUAL(evicted.size(), 1);
+    BOOST_CHECK_EQUAL(evicted[0], "two");
+    BOOST_CHECK(lru_cache_get(cache, "two") == NULL);
+
+    /*  Peeking at "three" does not save it from eviction  */
+
+    BOOST_CHECK(lru_cache_peek(cache, "three") != NULL);
+    BOOST_CHECK(lru_cache_put(cache, "one", cds_new_int(11), 1));
+    lru_cache_put(cache, "five", cds_new_int(5), 1);
+    BOOST_REQUIRE_EQUAL(evicted.size(), 2);
+    BOOST_CHECK_EQUAL(evicted[1], "three");
+
+    pval = (int *) lru_cache_peek(cache, "one");
+    BOOST_REQUIRE(pval);
+    BOOST_CHECK_EQUAL(*pval, 11);
+
+    BOOST_CHECK(lru_cache_delete(cache, "four"));
+    BOOST_CHECK(lru_cache_delete(cache, "four") == false);
+    BOOST_CHECK_EQUAL(lru_cache_length(cache), 2);
+    BOOST_CHECK_EQUAL(lru_cache_size(cache), 2);
+    BOOST_CHECK_EQUAL(evicted.size(), 2);
+
+    lru_cache_free(cache);
+}
+
+BOOST_AUTO_TEST_CASE(lru_cache_byte_capacity_test) {
+    lru_cache cache = lru_cache_init(100, NULL, NULL);
+
+    lru_cache_put(cache, "a", cds_new_int(1), 40);
+    lru_cache_put(cache, "b", cds_new_int(2), 40);
+    BOOST_CHECK_EQUAL(lru_cache_size(cache), 80);
+    BOOST_CHECK_EQUAL(lru_cache_capacity(cache), 100);
+
+    lru_cache_put(cache, "c", cds_new_int(3), 30);
+    BOOST_CHECK_EQUAL(lru_cache_length(cache), 2);
+    BOOST_CHECK_EQUAL(lru_cache_size(cache), 70);
+    BOOST_CHECK(lru_cache_peek(cache, "a") == NULL);
+
+    /*  An entry larger than the capacity displaces everything else  */
+
+    lru_cache_put(cache, "huge", cds_new_int(4), 500);
+    BOOST_CHECK_EQUAL(lru_cache_length(cache), 1);
+    BOOST_CHECK(lru_cache_peek(cache, "huge") != NULL);
+
+    lru_cache_put(cache, "d", cds_new_int(5), 10);
+    BOOST_CHECK_EQUAL(lru_cache_length(cache), 1);
+    BOOST_CHECK_EQUAL(lru_cache_size(cache), 10);
+
+    lru_cache_free(cache);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,193 @@
+/*
+ *  test_lsm_map.cpp
+ *  ================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for log-structured merge map.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <dirent.h>
+#include <unistd.h>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static const char * test_dir = "test_lsm_map.d";
+
+static void remove_test_dir(void) {
+    DIR * dir = opendir(test_dir);
+    if ( dir ) {
+        struct dirent * entry;
+        while ( (entry = readdir(dir)) ) {
+            std::string name(entry->d_name);
+            if ( name != "." && name != ".." ) {
+                std::remove((std::string(test_dir) + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+        rmdir(test_dir);
+    }
+}
+
+static bool check_value(lsm_map map, const char * key, int expected) {
+    size_t len = 0;
+    int * value = (int *) lsm_map_search_data(map, key, &len);
+    bool ok = value && len == sizeof(int) && *value == expected;
+    std::free(value);
+    return ok;
+}
+
+BOOST_AUTO_TEST_SUITE(lsm_map_suite)
+
+BOOST_AUTO_TEST_CASE(lsm_map_insert_search_test) {
+    remove_test_dir();
+    lsm_map map = lsm_map_open(test_dir, 4096);
+    BOOST_REQUIRE(map);
+    char key[32];
+
+    for ( int i = 0; i < 3000; ++i ) {
+        std::sprintf(key, "key%05d", i);
+        BOOST_CHECK_EQUAL(lsm_map_insert(map, key, &i, sizeof(i)), 0);
+    }
+
+    /*  Overwrite and delete some keys, leaving older values in runs  */
+
+    for ( int i = 0; i < 3000; i += 3 ) {
+        std::sprintf(key, "key%05d", i);
+        int value = -i;
+        lsm_map_insert(map, key, &value, sizeof(value));
+    }
+
+    for ( int i = 1; i < 3000; i += 3 ) {
+        std::sprintf(key, "key%05d", i);
+        lsm_map_delete(map, key);
+    }
+
+    BOOST_CHECK(lsm_map_num_runs(map) > 0);
+
+    for ( int i = 0; i < 3000; ++i ) {
+        std::sprintf(key, "key%05d", i);
+        if ( i % 3 == 0 ) {
+            BOOST_CHECK(check_value(map, key, -i));
+        } else if ( i % 3 == 1 ) {
+            BOOST_CHECK(lsm_map_search(map, key) == false);
+        } else {
+            BOOST_CHECK(check_value(map, key, i));
+        }
+    }
+
+    BOOST_CHECK(lsm_map_search(map, "missing") == false);
+
+    BOOST_CHECK_EQUAL(lsm_map_flush(map), 0);
+    BOOST_CHECK_EQUAL(lsm_map_compact(map), 0);
+    BOOST_CHECK_EQUAL(lsm_map_num_runs(map), 1);
+
+    BOOST_CHECK(check_value(map, "key00003", -3));
+    BOOST_CHECK(lsm_map_search(map, "key00004") == false);
+    BOOST_CHECK(check_value(map, "key00005", 5));
+
+    BOOST_CHECK_EQUAL(lsm_map_close(map), 0);
+    remove_test_dir();
+}
+
+/*  Test that a NULL value is stored as an empty value  */
+
+BOOST_AUTO_TEST_CASE(lsm_map_null_value_test) {
+    remove_test_dir();
+    lsm_map map = lsm_map_open(test_dir, 0);
+    BOOST_REQUIRE(map);
+
+    BOOST_CHECK_EQUAL(lsm_map_insert(map, "empty", NULL, 64), 0);
+    BOOST_CHECK(lsm_map_search(map, "empty") == true);
+
+    size_t len = 1;
+    void * value = lsm_map_search_data(map, "empty", &len);
+    BOOST_CHECK(value != NULL);
+    BOOST_CHECK_EQUAL(len, 0);
+    std::free(value);
+
+    BOOST_CHECK_EQUAL(lsm_map_flush(map), 0);
+    len = 1;
+    value = lsm_map_search_data(map, "empty", &len);
+    BOOST_CHECK(value != NULL);
+    BOOST_CHECK_EQUAL(len, 0);
+    std::free(value);
+
+    BOOST_CHECK_EQUAL(lsm_map_close(map), 0);
+    remove_test_dir();
+}
+
+/*  Test that a memtable of many sequential keys stays fast  */
+
+BOOST_AUTO_TEST_CASE(lsm_map_sequential_keys_test) {
+    remove_test_dir();
+    lsm_map map = lsm_map_open(test_dir, 0);
+    BOOST_REQUIRE(map);
+    const int num_keys = 100000;
+    char key[32];
+
+    for ( int i = 0; i < num_keys; ++i ) {
+        std::sprintf(key, "k%010d", i);
+        double value = i;
+        BOOST_REQUIRE_EQUAL(lsm_map_insert(map, key, &value,
+                                           sizeof(value)), 0);
+    }
+
+    BOOST_CHECK_EQUAL(lsm_map_num_runs(map), 0);
+
+    for ( int i = 0; i < num_keys; i += 997 ) {
+        std::sprintf(key, "k%010d", i);
+        size_t len = 0;
+        double * value = (double *) lsm_map_search_data(map, key, &len);
+        BOOST_REQUIRE(value);
+        BOOST_CHECK_EQUAL(len, sizeof(double));
+        BOOST_CHECK_EQUAL(*value, i);
+        std::free(value);
+    }
+
+    BOOST_CHECK_EQUAL(lsm_map_flush(map), 0);
+    BOOST_CHECK_EQUAL(lsm_map_num_runs(map), 1);
+    std::sprintf(key, "k%010d", num_keys - 1);
+    BOOST_CHECK(lsm_map_search(map, key) == true);
+    BOOST_CHECK(lsm_map_search(map, "k") == false);
+
+    BOOST_CHECK_EQUAL(lsm_map_close(map), 0);
+    remove_test_dir();
+}
+
+BOOST_AUTO_TEST_CASE(lsm_map_reopen_test) {
+    remove_test_dir();
+    lsm_map map = lsm_map_open(test_dir, 0);
+    BOOST_REQUIRE(map);
+
+    const char * hello = "hello";
+    lsm_map_insert(map, "greeting", hello, std::strlen(hello) + 1);
+    lsm_map_insert(map, "doomed", hello, std::strlen(hello) + 1);
+    lsm_map_flush(map);
+    lsm_map_delete(map, "doomed");
+    BOOST_CHECK_EQUAL(lsm_map_close(map), 0);
+
+    map = lsm_map_open(test_dir, 0);
+    BOOST_REQUIRE(map);
+    BOOST_CHECK_EQUAL(lsm_map_num_runs(map), 2);
+
+    char * value = (char *) lsm_map_search_data(map, "greeting", NULL);
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(std::string(value), "hello");
+    std::free(value);
+    BOOST_CHECK(lsm_map_search(map, "doomed") == false);
+
+    BOOST_CHECK_EQUAL(lsm_map_close(map), 0);
+    remove_test_dir();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
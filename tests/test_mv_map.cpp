@@ -0,0 +1,236 @@
+/*
+ *  test_mv_map.cpp
+ *  ===============
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *
+ *  Unit tests for multiversion map.
+ *
+ *  Uses Boost unit testing framework.
+ *
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static const int num_writes = 5000;
+
+static void count_pairs(const char * key, void * value, void * arg) {
+    (void) key;
+    (void) value;
+    ++*static_cast<size_t *>(arg);
+}
+
+static void * writer_thread(void * arg) {
+    mv_map map = static_cast<mv_map>(arg);
+    char key[16];
+
+    for ( int i = 0; i < num_writes; ++i ) {
+        std::sprintf(key, "key%06d", i);
+        mv_map_insert(map, key, cds_new_int(i));
+        if ( i % 100 == 0 ) {
+            mv_map_gc(map);
+        }
+    }
+
+    return NULL;
+}
+
+BOOST_AUTO_TEST_SUITE(mv_map_suite)
+
+/*  Test snapshots see only writes committed before they were opened  */
+
+BOOST_AUTO_TEST_CASE(mv_map_snapshot_isolation_test) {
+    mv_map map = mv_map_init();
+    BOOST_REQUIRE(map);
+
+    BOOST_CHECK_EQUAL(mv_map_insert(map, "apple", cds_new_int(1)), 1);
+    BOOST_CHECK_EQUAL(mv_map_insert(map, "banana", cds_new_int(2)), 2);
+
+    mv_map_snapshot first = mv_map_snapshot_open(map);
+    BOOST_CHECK_EQUAL(mv_map_snapshot_timestamp(first), 2);
+
+    mv_map_insert(map, "apple", cds_new_int(10));
+    BOOST_CHECK_EQUAL(mv_map_delete(map, "banana"), 4);
+    BOOST_CHECK_EQUAL(mv_map_delete(map, "banana"), 0);
+    BOOST_CHECK_EQUAL(mv_map_delete(map, "cherry"), 0);
+    mv_map_insert(map, "cherry", cds_new_int(3));
+
+    mv_map_snapshot second = mv_map_snapshot_open(map);
+    BOOST_CHECK_EQUAL(mv_map_snapshot_timestamp(second), 5);
+
+    int * value = static_cast<int *>(mv_map_snapshot_search_data(first,
+                                                                 "apple"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 1);
+    BOOST_CHECK(mv_map_snapshot_search(first, "banana"));
+    BOOST_CHECK(!mv_map_snapshot_search(first, "cherry"));
+
+    value = static_cast<int *>(mv_map_snapshot_search_data(second, "apple"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 10);
+    BOOST_CHECK(!mv_map_snapshot_search(second, "banana"));
+    BOOST_CHECK(!mv_map_snapshot_search_data(second, "banana"));
+    BOOST_CHECK(mv_map_snapshot_search(second, "cherry"));
+
+    size_t count = 0;
+    mv_map_snapshot_traverse(first, count_pairs, &count);
+    BOOST_CHECK_EQUAL(count, 2);
+    count = 0;
+    mv_map_snapshot_traverse(second, count_pairs, &count);
+    BOOST_CHECK_EQUAL(count, 2);
+
+    mv_map_snapshot_close(first);
+    mv_map_snapshot_close(second);
+    mv_map_free(map);
+}
+
+/*  Test garbage collection keeps versions visible to open snapshots  */
+
+BOOST_AUTO_TEST_CASE(mv_map_gc_test) {
+    mv_map map = mv_map_init();
+
+    mv_map_insert(map, "key", cds_new_int(1));
+    mv_map_snapshot snapshot = mv_map_snapshot_open(map);
+    mv_map_insert(map, "key", cds_new_int(2));
+    mv_map_insert(map, "key", cds_new_int(3));
+
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 0);
+    int * value = static_cast<int *>(mv_map_snapshot_search_data(snapshot,
+                                                                 "key"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 1);
+
+    mv_map_snapshot_close(snapshot);
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 2);
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 0);
+
+    snapshot = mv_map_snapshot_open(map);
+    value = static_cast<int *>(mv_map_snapshot_search_data(snapshot, "key"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 3);
+    mv_map_snapshot_close(snapshot);
+
+    mv_map_delete(map, "key");
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 1);
+
+    /*  The deleted key's node and tombstone go on the next pass  */
+
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 1);
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 0);
+
+    mv_map_free(map);
+}
+
+/*  Test deleted keys are reclaimed only once no snapshot can reach them  */
+
+BOOST_AUTO_TEST_CASE(mv_map_reclaim_test) {
+    mv_map map = mv_map_init();
+    char key[16];
+
+    /*  Sequential keys, which must not degrade the map  */
+
+    const int num_keys = 100000;
+    for ( int i = 0; i < num_keys; ++i ) {
+        std::sprintf(key, "key%06d", i);
+        mv_map_insert(map, key, cds_new_int(i));
+    }
+
+    mv_map_snapshot before = mv_map_snapshot_open(map);
+    for ( int i = 0; i < num_keys; i += 2 ) {
+        std::sprintf(key, "key%06d", i);
+        mv_map_delete(map, key);
+    }
+    mv_map_snapshot after = mv_map_snapshot_open(map);
+
+    /*  The old snapshot still sees the deleted keys  */
+
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 0);
+    size_t count = 0;
+    mv_map_snapshot_traverse(before, count_pairs, &count);
+    BOOST_CHECK_EQUAL(count, static_cast<size_t>(num_keys));
+    BOOST_CHECK(mv_map_snapshot_search(before, "key000000"));
+    mv_map_snapshot_close(before);
+
+    /*  Deleted keys are unlinked, but freed only after later snapshots
+     *  which might be standing on them have closed                      */
+
+    BOOST_CHECK_EQUAL(mv_map_gc(map), static_cast<size_t>(num_keys / 2));
+    count = 0;
+    mv_map_snapshot_traverse(after, count_pairs, &count);
+    BOOST_CHECK_EQUAL(count, static_cast<size_t>(num_keys / 2));
+    BOOST_CHECK(!mv_map_snapshot_search(after, "key000000"));
+    BOOST_CHECK(mv_map_snapshot_search(after, "key000001"));
+    BOOST_CHECK_EQUAL(mv_map_gc(map), 0);
+    mv_map_snapshot_close(after);
+    BOOST_CHECK_EQUAL(mv_map_gc(map), static_cast<size_t>(num_keys / 2));
+
+    /*  A reclaimed key can be written again  */
+
+    mv_map_insert(map, "key000000", cds_new_int(-1));
+    mv_map_snapshot snapshot = mv_map_snapshot_open(map);
+    int * value = static_cast<int *>(
+            mv_map_snapshot_search_data(snapshot, "key000000"));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, -1);
+    count = 0;
+    mv_map_snapshot_traverse(snapshot, count_pairs, &count);
+    BOOST_CHECK_EQUAL(count, static_cast<size_t>(num_keys / 2 + 1));
+    mv_map_snapshot_close(snapshot);
+
+    mv_map_free(map);
+}
+
+/*  Test readers see consistent snapshots while a writer runs  */
+
+BOOST_AUTO_TEST_CASE(mv_map_concurrent_readers_test) {
+    mv_map map = mv_map_init();
+
+    pthread_t writer;
+    BOOST_REQUIRE_EQUAL(pthread_create(&writer, NULL, writer_thread, map), 0);
+
+    char key[16];
+    bool consistent = true;
+    uint64_t stamp = 0;
+
+    while ( stamp < static_cast<uint64_t>(num_writes) ) {
+        mv_map_snapshot snapshot = mv_map_snapshot_open(map);
+        stamp = mv_map_snapshot_timestamp(snapshot);
+
+        /*  Keys are written in order, one per commit  */
+
+        size_t count = 0;
+        mv_map_snapshot_traverse(snapshot, count_pairs, &count);
+        if ( count != stamp ) {
+            consistent = false;
+        }
+
+        if ( stamp > 0 ) {
+            std::sprintf(key, "key%06d", static_cast<int>(stamp - 1));
+            int * value = static_cast<int *>(
+                    mv_map_snapshot_search_data(snapshot, key));
+            if ( !value || *value != static_cast<int>(stamp - 1) ) {
+                consistent = false;
+            }
+        }
+        std::sprintf(key, "key%06d", static_cast<int>(stamp));
+        if ( mv_map_snapshot_search(snapshot, key) ) {
+            consistent = false;
+        }
+
+        mv_map_snapshot_close(snapshot);
+    }
+
+    pthread_join(writer, NULL);
+    BOOST_CHECK(consistent);
+
+    mv_map_free(map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+/*
+ *  test_shard_map.cpp
+ *  ==================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for sharded concurrent map.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static void sum_values(const char * key, void * value, void * arg) {
+    (void) key;
+    *((int *) arg) += *((int *) value);
+}
+
+BOOST_AUTO_TEST_SUITE(shard_map_suite)
+
+BOOST_AUTO_TEST_CASE(shard_map_insert_search_delete_test) {
+    shard_map map = shard_map_init(6);
+    BOOST_CHECK_EQUAL(shard_map_num_shards(map), 8);
+    BOOST_CHECK(shard_map_isempty(map) == true);
+
+    shard_map_insert(map, "bacon", cds_new_int(4));
+    shard_map_insert(map, "eggs", cds_new_int(9));
+    shard_map_insert(map, "spam", cds_new_int(16));
+    shard_map_insert(map, "cheese", cds_new_int(25));
+
+    BOOST_CHECK_EQUAL(shard_map_length(map), 4);
+    int * pval = (int *) shard_map_search_data(map, "spam");
+    BOOST_CHECK_EQUAL(*pval, 16);
+    BOOST_CHECK(shard_map_search(map, "gruel") == false);
+
+    BOOST_CHECK(shard_map_insert(map, "spam", cds_new_int(99)) == true);
+    BOOST_CHECK(shard_map_delete(map, "eggs") == true);
+    BOOST_CHECK(shard_map_delete(map, "eggs") == false);
+    BOOST_CHECK_EQUAL(shard_map_length(map), 3);
+
+    int sum = 0;
+    shard_map_traverse(map, sum_values, &sum);
+    BOOST_CHECK_EQUAL(sum, 4 + 99 + 25);
+
+    shard_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(shard_map_threaded_insert_test) {
+    shard_map map = shard_map_init(16);
+    std::vector<std::thread> threads;
+
+    for ( int t = 0; t < 4; ++t ) {
+        threads.push_back(std::thread([map, t]() {
+            for ( int i = 0; i < 1000; ++i ) {
+                std::string key = std::to_string(t) + "/" +
+                                  std::to_string(i);
+                shard_map_insert(map, key.c_str(), cds_new_int(1));
+            }
+        }));
+    }
+
+    for ( size_t t = 0; t < threads.size(); ++t ) {
+        threads[t].join();
+    }
+
+    BOOST_CHECK_EQUAL(shard_map_length(map), 4000);
+    int sum = 0;
+    shard_map_traverse(map, sum_values, &sum);
+    BOOST_CHECK_EQUAL(sum, 4000);
+
+    shard_map_free(map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
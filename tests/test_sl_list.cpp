@@ -12,10 +12,49 @@
  *  http://www.gnu.org/licenses/
  */
 
+#include <cstdlib>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <boost/test/unit_test.hpp>
 #include "../cdatastruct.h"
 
+static int compare_last_digit(const void * data, const void * cmp) {
+    return *((const int *) data) % 10 - *((const int *) cmp) % 10;
+}
+
+static bool last_digit_less(const int a, const int b) {
+    return a % 10 < b % 10;
+}
+
+struct filter_arg {
+    int divisor;
+    int sunk;
+};
+
+static bool is_multiple_of(const void * data, void * arg) {
+    return *((const int *) data) % ((filter_arg *) arg)->divisor == 0;
+}
+
+static bool is_negative(const void * data, void * arg) {
+    (void) arg;
+    return *((const int *) data) < 0;
+}
+
+static void sink_count(void * data, void * arg) {
+    ++((filter_arg *) arg)->sunk;
+    free(data);
+}
+
+struct sl_item {
+    int value;
+    sl_list_node_t link;
+};
+
+static int compare_sl_item(const void * data, const void * cmp) {
+    return ((const sl_item *) data)->value - ((const sl_item *) cmp)->value;
+}
+
 BOOST_AUTO_TEST_SUITE(sl_list_suite)
 
 BOOST_AUTO_TEST_CASE(sl_list_prepend_delete_front_test) {
@@ -157,4 +196,313 @@ BOOST_AUTO_TEST_CASE(sl_list_find_insert_index_test) {
     sl_list_free(list);
 }
 
+BOOST_AUTO_TEST_CASE(sl_list_append_last_test) {
+    sl_list list = sl_list_init(cds_compare_int, NULL);
+    BOOST_CHECK(sl_list_last(list) == NULL);
+
+    for ( int i = 0; i < 1000; ++i ) {
+        sl_list_append(list, (void *) cds_new_int(i));
+    }
+    BOOST_CHECK_EQUAL(sl_list_length(list), 1000);
+    BOOST_CHECK_EQUAL(999, *((int *) sl_list_last(list)->data));
+    BOOST_CHECK_EQUAL(500, *((int *) sl_list_data(list, 500)));
+
+    /*  Removing and inserting at the back keeps the last element  */
+
+    sl_list_delete_at(list, 999);
+    BOOST_CHECK_EQUAL(998, *((int *) sl_list_last(list)->data));
+    sl_list_insert_after(list, sl_list_last(list), (void *) cds_new_int(-1));
+    BOOST_CHECK_EQUAL(-1, *((int *) sl_list_last(list)->data));
+    sl_list_insert_at(list, sl_list_length(list), (void *) cds_new_int(-2));
+    BOOST_CHECK_EQUAL(-2, *((int *) sl_list_last(list)->data));
+    BOOST_CHECK_EQUAL(1001, sl_list_length(list));
+
+    while ( sl_list_length(list) > 1 ) {
+        sl_list_delete_at(list, 0);
+    }
+    BOOST_CHECK(sl_list_first(list) == sl_list_last(list));
+    sl_list_delete_at(list, 0);
+    BOOST_CHECK(sl_list_last(list) == NULL);
+
+    sl_list_append(list, (void *) cds_new_int(7));
+    BOOST_CHECK(sl_list_first(list) == sl_list_last(list));
+    sl_list_prepend(list, (void *) cds_new_int(6));
+    BOOST_CHECK_EQUAL(7, *((int *) sl_list_last(list)->data));
+
+    sl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(sl_list_sort_test) {
+    sl_list list = sl_list_init(cds_compare_int, NULL);
+    std::vector<int> values;
+    for ( int i = 0; i < 1000; ++i ) {
+        values.push_back((i * 37) % 1000);
+        sl_list_append(list, (void *) cds_new_int(values.back()));
+    }
+
+    /*  Stable sort by last digit keeps equal digits in list order  */
+
+    sl_list_sort_by(list, compare_last_digit);
+    std::stable_sort(values.begin(), values.end(), last_digit_less);
+    size_t i = 0;
+    for ( sl_list_itr itr = sl_list_first(list); itr;
+          itr = sl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), values[i++]);
+    }
+    BOOST_CHECK_EQUAL(i, 1000);
+
+    sl_list_sort(list);
+    i = 0;
+    for ( sl_list_itr itr = sl_list_first(list); itr;
+          itr = sl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), (int) i++);
+    }
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), 999);
+
+    sl_list_append(list, (void *) cds_new_int(-1));
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), -1);
+    BOOST_CHECK_EQUAL(sl_list_length(list), 1001);
+
+    sl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(sl_list_delete_after_test) {
+    sl_list list = sl_list_init(cds_compare_int, NULL);
+    for ( int i = 0; i < 100; ++i ) {
+        sl_list_append(list, (void *) cds_new_int(i));
+    }
+
+    /*  Delete odd elements, including the last, in one pass  */
+
+    sl_list_itr itr = sl_list_first(list);
+    while ( sl_list_next(itr) ) {
+        if ( *((int *) sl_list_next(itr)->data) % 2 ) {
+            BOOST_CHECK_EQUAL(sl_list_delete_after(list, itr), 0);
+        } else {
+            itr = sl_list_next(itr);
+        }
+    }
+    BOOST_CHECK_EQUAL(sl_list_length(list), 50);
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), 98);
+
+    int i = 0;
+    for ( itr = sl_list_first(list); itr; itr = sl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), i);
+        i += 2;
+    }
+
+    BOOST_CHECK_EQUAL(sl_list_delete_after(list, sl_list_last(list)),
+                      CDSERR_OUTOFRANGE);
+    BOOST_CHECK_EQUAL(sl_list_delete_after(list, NULL), CDSERR_BADITERATOR);
+
+    sl_list_append(list, (void *) cds_new_int(100));
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), 100);
+
+    sl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(sl_list_remove_if_partition_test) {
+    sl_list list = sl_list_init(cds_compare_int, NULL);
+    for ( int i = 0; i < 100; ++i ) {
+        sl_list_append(list, (void *) cds_new_int(i));
+    }
+
+    /*  Multiples of 3 are freed, including the first element  */
+
+    filter_arg arg = {3, 0};
+    BOOST_CHECK_EQUAL(sl_list_remove_if(list, is_multiple_of, NULL, &arg),
+                      34);
+    BOOST_CHECK_EQUAL(sl_list_length(list), 66);
+    BOOST_CHECK_EQUAL(*((int *) sl_list_first(list)->data), 1);
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), 98);
+
+    /*  Multiples of 7, and then a negative element, go to a sink  */
+
+    arg.divisor = 7;
+    BOOST_CHECK_EQUAL(sl_list_remove_if(list, is_multiple_of, sink_count,
+                                      &arg), 10);
+    BOOST_CHECK_EQUAL(arg.sunk, 10);
+    BOOST_CHECK_EQUAL(sl_list_remove_if(list, is_negative, sink_count, &arg),
+                      0);
+    sl_list_append(list, (void *) cds_new_int(-5));
+    BOOST_CHECK_EQUAL(sl_list_remove_if(list, is_negative, sink_count, &arg),
+                      1);
+    BOOST_CHECK_EQUAL(arg.sunk, 11);
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), 97);
+
+    /*  Even elements move to a second list in order  */
+
+    sl_list evens = sl_list_init(cds_compare_int, NULL);
+    sl_list_append(evens, (void *) cds_new_int(0));
+    arg.divisor = 2;
+    const size_t moved = sl_list_partition(list, evens, is_multiple_of, &arg);
+    BOOST_CHECK_EQUAL(sl_list_length(list) + sl_list_length(evens), 57);
+    BOOST_CHECK_EQUAL(sl_list_length(evens), moved + 1);
+
+    int previous = -1;
+    for ( sl_list_itr itr = sl_list_first(evens); itr;
+          itr = sl_list_next(itr) ) {
+        const int value = *((int *) itr->data);
+        BOOST_CHECK(value % 2 == 0 && value > previous);
+        previous = value;
+    }
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(evens)->data), previous);
+    for ( sl_list_itr itr = sl_list_first(list); itr;
+          itr = sl_list_next(itr) ) {
+        BOOST_CHECK(*((int *) itr->data) % 2 == 1);
+    }
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(list)->data), 97);
+
+    sl_list_free(evens);
+    sl_list_free(list);
+}
+
+/*  Test concatenating lists  */
+
+BOOST_AUTO_TEST_CASE(sl_list_concat_test) {
+    sl_list dst = sl_list_init(cds_compare_int, NULL);
+    sl_list src = sl_list_init(cds_compare_int, NULL);
+
+    /*  Concatenating empty lists  */
+
+    sl_list_concat(dst, src);
+    BOOST_CHECK(sl_list_isempty(dst));
+    BOOST_CHECK(sl_list_last(dst) == NULL);
+
+    for ( int i = 0; i < 3; ++i ) {
+        sl_list_append(src, (void *) cds_new_int(i));
+    }
+
+    /*  Into an empty list, and then from an empty list  */
+
+    sl_list_concat(dst, src);
+    BOOST_CHECK_EQUAL(sl_list_length(dst), 3);
+    BOOST_CHECK(sl_list_isempty(src));
+    BOOST_CHECK(sl_list_first(src) == NULL && sl_list_last(src) == NULL);
+    sl_list_concat(dst, src);
+    BOOST_CHECK_EQUAL(sl_list_length(dst), 3);
+
+    /*  Between non-empty lists, after which both remain usable  */
+
+    for ( int i = 3; i < 6; ++i ) {
+        sl_list_append(src, (void *) cds_new_int(i));
+    }
+    sl_list_concat(dst, src);
+    sl_list_append(dst, (void *) cds_new_int(6));
+    sl_list_append(src, (void *) cds_new_int(7));
+
+    BOOST_CHECK_EQUAL(sl_list_length(dst), 7);
+    int expected = 0;
+    for ( sl_list_itr itr = sl_list_first(dst); itr;
+          itr = sl_list_next(itr) ) {
+        BOOST_CHECK_EQUAL(*((int *) itr->data), expected++);
+    }
+    BOOST_CHECK_EQUAL(*((int *) sl_list_last(dst)->data), 6);
+    BOOST_CHECK_EQUAL(sl_list_length(src), 1);
+    BOOST_CHECK_EQUAL(*((int *) sl_list_first(src)->data), 7);
+
+    sl_list_free(src);
+    sl_list_free(dst);
+}
+
+/*  Test index lookups stay correct as the list changes between them  */
+
+BOOST_AUTO_TEST_CASE(sl_list_sequential_index_test) {
+    sl_list list = sl_list_init(cds_compare_int, NULL);
+    std::vector<int> values;
+
+    for ( int i = 0; i < 1000; ++i ) {
+        sl_list_append(list, (void *) cds_new_int(i));
+        values.push_back(i);
+    }
+
+    for ( int pass = 0; pass < 6; ++pass ) {
+        for ( size_t i = 0; i < values.size(); ++i ) {
+            BOOST_REQUIRE_EQUAL(*((int *) sl_list_data(list, i)), values[i]);
+        }
+        /*  Each change moves elements after a cached index  */
+
+        const size_t mid = values.size() / 2;
+        switch ( pass ) {
+        case 0:
+            sl_list_delete_at(list, mid);
+            values.erase(values.begin() + mid);
+            break;
+        case 1:
+            sl_list_insert_at(list, mid, (void *) cds_new_int(-1));
+            values.insert(values.begin() + mid, -1);
+            break;
+        case 2:
+            sl_list_prepend(list, (void *) cds_new_int(-2));
+            values.insert(values.begin(), -2);
+            break;
+        case 3:
+            sl_list_insert_after(list, sl_list_itr_from_index(list, mid),
+                                 (void *) cds_new_int(-3));
+            values.insert(values.begin() + mid + 1, -3);
+            break;
+        case 4:
+            sl_list_sort_by(list, compare_last_digit);
+            std::stable_sort(values.begin(), values.end(), last_digit_less);
+            break;
+        default:
+            sl_list_append(list, (void *) cds_new_int(-4));
+            values.push_back(-4);
+            break;
+        }
+    }
+
+    sl_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(sl_list_intrusive_test) {
+    sl_list list = sl_list_init_intrusive(compare_sl_item, NULL,
+                                          offsetof(sl_item, link));
+    sl_item items[6];
+    for ( int i = 0; i < 6; ++i ) {
+        items[i].value = i * 10;
+    }
+
+    sl_list_append_node(list, &items[2].link);
+    sl_list_append_node(list, &items[4].link);
+    sl_list_prepend_node(list, &items[0].link);
+    sl_list_insert_node_after(list, sl_list_first(list), &items[1].link);
+    sl_list_insert_node_after(list, sl_list_itr_from_index(list, 2),
+                              &items[3].link);
+    sl_list_append_node(list, &items[5].link);
+    BOOST_CHECK(sl_list_insert_node_after(list, NULL, &items[5].link) ==
+                CDSERR_BADITERATOR);
+
+    BOOST_REQUIRE_EQUAL(sl_list_length(list), 6);
+    int i = 0;
+    for ( sl_list_itr itr = sl_list_first(list); itr;
+          itr = sl_list_next(itr) ) {
+        BOOST_CHECK(itr == &items[i].link);
+        BOOST_CHECK(itr->data == &items[i]);
+        BOOST_CHECK(cds_container_of(itr, sl_item, link) == &items[i]);
+        ++i;
+    }
+    BOOST_CHECK_EQUAL(i, 6);
+    BOOST_CHECK(sl_list_last(list) == &items[5].link);
+
+    sl_item key;
+    key.value = 30;
+    BOOST_CHECK_EQUAL(sl_list_find_index(list, &key), 3);
+
+    BOOST_CHECK(sl_list_remove_front(list) == &items[0]);
+    BOOST_CHECK(sl_list_remove_after(list, sl_list_first(list)) ==
+                &items[2]);
+    BOOST_CHECK(sl_list_remove_after(list, sl_list_last(list)) == NULL);
+    BOOST_CHECK_EQUAL(sl_list_length(list), 4);
+    BOOST_CHECK(sl_list_first(list) == &items[1].link);
+    BOOST_CHECK(sl_list_next(sl_list_first(list)) == &items[3].link);
+
+    sl_list_delete_at(list, 0);
+    BOOST_CHECK_EQUAL(items[1].value, 10);
+    BOOST_CHECK_EQUAL(sl_list_length(list), 3);
+
+    sl_list_free(list);
+    BOOST_CHECK_EQUAL(items[5].value, 50);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
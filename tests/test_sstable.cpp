@@ -0,0 +1,153 @@
+/*
+ *  test_sstable.cpp
+ *  ================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for sorted string table file.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static const char * test_file = "test_sstable.sst";
+
+static const void * int_bytes(const void * value, size_t * len) {
+    *len = sizeof(int);
+    return value;
+}
+
+static void collect_keys(const char * key, const void * value,
+                         size_t len, void * arg) {
+    (void) value;
+    (void) len;
+    std::vector<std::string> * keys = (std::vector<std::string> *) arg;
+    keys->push_back(key);
+}
+
+BOOST_AUTO_TEST_SUITE(sstable_suite)
+
+BOOST_AUTO_TEST_CASE(sstable_search_test) {
+    bst_map map = bst_map_init();
+    char key[32];
+
+    /*  Enough keys to span many blocks  */
+
+    for ( int i = 0; i < 5000; ++i ) {
+        std::sprintf(key, "key%05d", i * 2);
+        bst_map_insert(map, key, cds_new_int(i * 2));
+    }
+
+    BOOST_REQUIRE_EQUAL(bst_map_write_sstable(map, test_file, int_bytes), 0);
+    bst_map_free(map);
+
+    sstable table = sstable_open(test_file);
+    BOOST_REQUIRE(table);
+    BOOST_CHECK_EQUAL(sstable_length(table), 5000);
+    BOOST_CHECK(sstable_isempty(table) == false);
+
+    for ( int i = 0; i < 10000; ++i ) {
+        std::sprintf(key, "key%05d", i);
+        size_t len = 0;
+        const void * value = sstable_search_data(table, key, &len);
+        if ( i % 2 == 0 ) {
+            BOOST_REQUIRE(value);
+            BOOST_CHECK_EQUAL(len, sizeof(int));
+            int n;
+            std::memcpy(&n, value, sizeof(n));
+            BOOST_CHECK_EQUAL(n, i);
+        } else {
+            BOOST_CHECK(value == NULL);
+        }
+    }
+
+    BOOST_CHECK(sstable_search(table, "a") == false);
+    BOOST_CHECK(sstable_search(table, "key") == false);
+    BOOST_CHECK(sstable_search(table, "key099980") == false);
+    BOOST_CHECK(sstable_search(table, "zzz") == false);
+
+    sstable_close(table);
+    std::remove(test_file);
+}
+
+BOOST_AUTO_TEST_CASE(sstable_traverse_test) {
+    bst_map map = bst_map_init();
+    const char * keys[] = {"apple", "apricot", "banana", "blueberry",
+                           "blackberry", "cherry", "apple pie", ""};
+
+    for ( size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i ) {
+        bst_map_insert(map, keys[i], cds_new_string(keys[i]));
+    }
+
+    BOOST_REQUIRE_EQUAL(bst_map_write_sstable(map, test_file, NULL), 0);
+    bst_map_free(map);
+
+    sstable table = sstable_open(test_file);
+    BOOST_REQUIRE(table);
+
+    const char * value = (const char *) sstable_search_data(table,
+                                                            "cherry", NULL);
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(std::string(value), "cherry");
+    BOOST_CHECK(sstable_search(table, ""));
+
+    std::vector<std::string> found;
+    sstable_prefix_traverse(table, "ap", collect_keys, &found);
+    BOOST_REQUIRE_EQUAL(found.size(), 3);
+    BOOST_CHECK_EQUAL(found[0], "apple");
+    BOOST_CHECK_EQUAL(found[1], "apple pie");
+    BOOST_CHECK_EQUAL(found[2], "apricot");
+
+    found.clear();
+    sstable_range_traverse(table, "b", "blueberry", collect_keys, &found);
+    BOOST_REQUIRE_EQUAL(found.size(), 2);
+    BOOST_CHECK_EQUAL(found[0], "banana");
+    BOOST_CHECK_EQUAL(found[1], "blackberry");
+
+    found.clear();
+    sstable_range_traverse(table, NULL, NULL, collect_keys, &found);
+    BOOST_CHECK_EQUAL(found.size(), 8);
+
+    sstable_cursor cursor = sstable_cursor_seek(table, "bo");
+    const char * key;
+    size_t len;
+    BOOST_REQUIRE(sstable_cursor_next(cursor, &key, NULL, &len));
+    BOOST_CHECK_EQUAL(std::string(key), "cherry");
+    BOOST_CHECK_EQUAL(len, 7);
+    BOOST_CHECK(sstable_cursor_next(cursor, &key, NULL, NULL) == false);
+    sstable_cursor_free(cursor);
+
+    sstable_close(table);
+    std::remove(test_file);
+}
+
+BOOST_AUTO_TEST_CASE(sstable_empty_test) {
+    bst_map map = bst_map_init();
+    BOOST_REQUIRE_EQUAL(bst_map_write_sstable(map, test_file, NULL), 0);
+    bst_map_free(map);
+
+    sstable table = sstable_open(test_file);
+    BOOST_REQUIRE(table);
+    BOOST_CHECK(sstable_isempty(table));
+    BOOST_CHECK(sstable_search(table, "anything") == false);
+
+    sstable_cursor cursor = sstable_cursor_seek(table, NULL);
+    BOOST_CHECK(sstable_cursor_next(cursor, NULL, NULL, NULL) == false);
+    sstable_cursor_free(cursor);
+
+    sstable_close(table);
+    std::remove(test_file);
+
+    BOOST_CHECK(sstable_open("no_such_file.sst") == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+/*
+ *  test_ttl_map.cpp
+ *  ================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *  
+ *  Unit tests for expiring map.
+ *
+ *  Uses Boost unit testing framework.
+ *  
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdio>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static uint64_t test_now = 1000;
+
+static uint64_t test_clock(void) {
+    return test_now;
+}
+
+BOOST_AUTO_TEST_SUITE(ttl_map_suite)
+
+BOOST_AUTO_TEST_CASE(ttl_map_expiry_test) {
+    test_now = 1000;
+    ttl_map map = ttl_map_init(test_clock);
+
+    BOOST_CHECK(ttl_map_isempty(map));
+    BOOST_CHECK(ttl_map_insert(map, "short", cds_new_int(1), 10) == false);
+    ttl_map_insert(map, "long", cds_new_int(2), 100000);
+    ttl_map_insert(map, "medium", cds_new_int(3), 500);
+    BOOST_CHECK_EQUAL(ttl_map_length(map), 3);
+
+    test_now = 1009;
+    int * pval = (int *) ttl_map_search_data(map, "short");
+    BOOST_REQUIRE(pval);
+    BOOST_CHECK_EQUAL(*pval, 1);
+
+    /*  Expired keys miss before they are reaped  */
+
+    test_now = 1010;
+    BOOST_CHECK(ttl_map_search(map, "short") == false);
+    BOOST_CHECK_EQUAL(ttl_map_length(map), 3);
+    BOOST_CHECK_EQUAL(ttl_map_reap(map), 1);
+    BOOST_CHECK_EQUAL(ttl_map_length(map), 2);
+
+    /*  Reinserting resets the deadline  */
+
+    test_now = 1400;
+    BOOST_CHECK(ttl_map_insert(map, "medium", cds_new_int(4), 500));
+    test_now = 1600;
+    BOOST_CHECK_EQUAL(ttl_map_reap(map), 0);
+    pval = (int *) ttl_map_search_data(map, "medium");
+    BOOST_REQUIRE(pval);
+    BOOST_CHECK_EQUAL(*pval, 4);
+
+    test_now = 1900;
+    BOOST_CHECK(ttl_map_search(map, "medium") == false);
+    BOOST_CHECK(ttl_map_search(map, "long"));
+    BOOST_CHECK(ttl_map_delete(map, "medium") == false);
+    BOOST_CHECK_EQUAL(ttl_map_length(map), 1);
+
+    test_now = 101000;
+    BOOST_CHECK_EQUAL(ttl_map_reap(map), 1);
+    BOOST_CHECK(ttl_map_isempty(map));
+
+    ttl_map_insert(map, "gone", cds_new_int(5), 50);
+    BOOST_CHECK(ttl_map_delete(map, "gone"));
+    BOOST_CHECK(ttl_map_isempty(map));
+
+    ttl_map_free(map);
+}
+
+BOOST_AUTO_TEST_CASE(ttl_map_wheel_levels_test) {
+    test_now = 0;
+    ttl_map map = ttl_map_init(test_clock);
+    char key[32];
+
+    /*  Spread deadlines over every level of the wheel, and beyond it  */
+
+    const uint64_t ttls[] = {1, 63, 64, 65, 4095, 4096, 4097, 262143,
+                             262144, 262145, 16777215, 16777216,
+                             40000000};
+    const size_t num_ttls = sizeof(ttls) / sizeof(ttls[0]);
+
+    for ( size_t i = 0; i < num_ttls; ++i ) {
+        std::sprintf(key, "key%zu", i);
+        ttl_map_insert(map, key, cds_new_int(i), ttls[i]);
+    }
+
+    for ( size_t i = 0; i < num_ttls; ++i ) {
+        test_now = ttls[i] - 1;
+        BOOST_CHECK_EQUAL(ttl_map_reap(map), 0);
+        BOOST_CHECK_EQUAL(ttl_map_length(map), num_ttls - i);
+
+        test_now = ttls[i];
+        BOOST_CHECK_EQUAL(ttl_map_reap(map), 1);
+        std::sprintf(key, "key%zu", i);
+        BOOST_CHECK(ttl_map_search(map, key) == false);
+    }
+
+    BOOST_CHECK(ttl_map_isempty(map));
+
+    ttl_map_insert(map, "leftover", cds_new_int(1), 1000);
+    ttl_map_free(map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+/*
+ *  test_ul_list.cpp
+ *  ================
+ *  Copyright 2013 Paul Griffiths
+ *  Email: mail@paulgriffiths.net
+ *
+ *  Unit tests for unrolled linked list.
+ *
+ *  Uses Boost unit testing framework.
+ *
+ *  Distributed under the terms of the GNU General Public License.
+ *  http://www.gnu.org/licenses/
+ */
+
+#include <cstdlib>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../cdatastruct.h"
+
+static bool matches(ul_list list, const std::vector<int> & expected) {
+    if ( ul_list_length(list) != expected.size() ) {
+        return false;
+    }
+
+    size_t i = 0;
+    for ( ul_list_itr itr = ul_list_first(list); ul_list_itr_valid(itr);
+          itr = ul_list_next(itr) ) {
+        if ( *((int *) ul_list_itr_data(itr)) != expected[i++] ) {
+            return false;
+        }
+    }
+
+    for ( ul_list_itr itr = ul_list_last(list); ul_list_itr_valid(itr);
+          itr = ul_list_prev(itr) ) {
+        if ( *((int *) ul_list_itr_data(itr)) != expected[--i] ) {
+            return false;
+        }
+    }
+
+    return i == 0;
+}
+
+BOOST_AUTO_TEST_SUITE(ul_list_suite)
+
+BOOST_AUTO_TEST_CASE(ul_list_append_prepend_test) {
+    ul_list list = ul_list_init(cds_compare_int, NULL);
+    std::vector<int> expected;
+
+    BOOST_CHECK(ul_list_isempty(list));
+    BOOST_CHECK(!ul_list_itr_valid(ul_list_first(list)));
+    BOOST_CHECK(!ul_list_itr_valid(ul_list_last(list)));
+
+    for ( int i = 0; i < 100; ++i ) {
+        ul_list_append(list, cds_new_int(i));
+        expected.push_back(i);
+        ul_list_prepend(list, cds_new_int(-i - 1));
+        expected.insert(expected.begin(), -i - 1);
+    }
+
+    BOOST_CHECK(!ul_list_isempty(list));
+    BOOST_CHECK(matches(list, expected));
+    for ( size_t i = 0; i < expected.size(); ++i ) {
+        BOOST_CHECK_EQUAL(*((int *) ul_list_data(list, i)), expected[i]);
+    }
+    BOOST_CHECK(ul_list_data(list, expected.size()) == NULL);
+
+    ul_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(ul_list_insert_delete_test) {
+    ul_list list = ul_list_init(cds_compare_int, NULL);
+    std::vector<int> expected;
+    std::srand(42);
+
+    for ( int i = 0; i < 2000; ++i ) {
+        const size_t index = std::rand() % (expected.size() + 1);
+        BOOST_REQUIRE_EQUAL(ul_list_insert_at(list, index, cds_new_int(i)),
+                            0);
+        expected.insert(expected.begin() + index, i);
+
+        if ( i % 3 == 0 ) {
+            const size_t rm_index = std::rand() % expected.size();
+            BOOST_REQUIRE_EQUAL(ul_list_delete_at(list, rm_index), 0);
+            expected.erase(expected.begin() + rm_index);
+        }
+    }
+    BOOST_CHECK(matches(list, expected));
+
+    void * unused = cds_new_int(0);
+    BOOST_CHECK_EQUAL(ul_list_insert_at(list, expected.size() + 1, unused),
+                      CDSERR_OUTOFRANGE);
+    std::free(unused);
+    BOOST_CHECK_EQUAL(ul_list_delete_at(list, expected.size()),
+                      CDSERR_OUTOFRANGE);
+
+    while ( !expected.empty() ) {
+        const size_t rm_index = std::rand() % expected.size();
+        ul_list_delete_at(list, rm_index);
+        expected.erase(expected.begin() + rm_index);
+    }
+    BOOST_CHECK(ul_list_isempty(list));
+    BOOST_CHECK(matches(list, expected));
+
+    ul_list_free(list);
+}
+
+BOOST_AUTO_TEST_CASE(ul_list_find_insert_itr_test) {
+    ul_list list = ul_list_init(cds_compare_int, NULL);
+    std::vector<int> expected;
+    for ( int i = 0; i < 40; ++i ) {
+        ul_list_append(list, cds_new_int(i * 10));
+        expected.push_back(i * 10);
+    }
+
+    int value = 250;
+    BOOST_CHECK_EQUAL(ul_list_find_index(list, &value), 25);
+    ul_list_itr itr = ul_list_find_itr(list, &value);
+    BOOST_REQUIRE(ul_list_itr_valid(itr));
+    BOOST_CHECK_EQUAL(*((int *) ul_list_itr_data(itr)), 250);
+
+    BOOST_CHECK_EQUAL(ul_list_insert_after(list, itr, cds_new_int(255)), 0);
+    expected.insert(expected.begin() + 26, 255);
+    itr = ul_list_find_itr(list, &value);
+    BOOST_CHECK_EQUAL(ul_list_insert_before(list, itr, cds_new_int(245)), 0);
+    expected.insert(expected.begin() + 25, 245);
+    BOOST_CHECK(matches(list, expected));
+
+    value = 7;
+    BOOST_CHECK_EQUAL(ul_list_find_index(list, &value), CDSERR_NOTFOUND);
+    itr = ul_list_find_itr(list, &value);
+    BOOST_CHECK(!ul_list_itr_valid(itr));
+    BOOST_CHECK_EQUAL(ul_list_insert_after(list, itr, NULL),
+                      CDSERR_BADITERATOR);
+    BOOST_CHECK_EQUAL(ul_list_insert_before(list, itr, NULL),
+                      CDSERR_BADITERATOR);
+
+    ul_list_free(list);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
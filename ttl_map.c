@@ -0,0 +1,519 @@
+/*!
+ * \file            ttl_map.c
+ * \brief           Implementation of expiring map data structure.
+ * \details         Entries are indexed by key in a binary search tree, and
+ * scheduled for expiry in a hierarchical timer wheel of four levels of 64
+ * slots, each slot being a doubly linked list whose nodes are embedded in
+ * the entries. Level 0 slots hold entries due within 64 ticks of the
+ * wheel's current tick, and each higher level covers 64 times the span
+ * of the one below it. As the wheel turns, the slots of higher levels
+ * are cascaded down into lower ones, and the entries in each level 0 slot
+ * are reaped as its tick passes, so each entry is touched a bounded
+ * number of times however many entries there are. A tick is one unit of
+ * the map's clock, a millisecond by default.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+/*!
+ * \brief           Enable POSIX library.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "cds_ttl_map.h"
+#include "bs_tree.h"
+#include "dl_list.h"
+
+
+/*!
+ * \brief           Number of bits of the tick indexing each wheel level.
+ */
+
+#define WHEEL_BITS 6
+
+
+/*!
+ * \brief           Number of slots in each wheel level.
+ */
+
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+
+
+/*!
+ * \brief           Mask for slot index within a wheel level.
+ */
+
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+
+
+/*!
+ * \brief           Number of wheel levels.
+ */
+
+#define WHEEL_LEVELS 4
+
+
+/*!
+ * \brief           Struct to contain an expiring map.
+ */
+
+typedef struct ttl_map_t {
+    bs_tree index;                              /*!< Entries ordered by key */
+    dl_list wheel[WHEEL_LEVELS][WHEEL_SLOTS];   /*!< Timer wheel slots */
+    size_t level_count[WHEEL_LEVELS];           /*!< Entries in each level */
+    uint64_t current;                           /*!< Next tick to process */
+    uint64_t (*clock_func)(void);               /*!< Pointer to clock */
+} ttl_map_t;
+
+
+/*!
+ * \brief           Expiring map entry struct.
+ */
+
+typedef struct ttl_entry_t {
+    dl_list_node_t node;        /*!< Timer wheel slot node */
+    dl_list slot;               /*!< Timer wheel slot holding entry */
+    int level;                  /*!< Timer wheel level holding entry */
+    uint64_t deadline;          /*!< Tick at which entry expires */
+    void * value;               /*!< Pointer to data */
+    char key[];                 /*!< Key string */
+} ttl_entry_t;
+
+
+/*!
+ * \brief           Typedef for expiring map entry pointer.
+ */
+
+typedef struct ttl_entry_t * ttl_entry;
+
+
+/*!
+ * \brief           Returns the default clock.
+ * \returns         The monotonic time in milliseconds.
+ */
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+
+/*!
+ * \brief           Frees resources used by an entry.
+ * \param entry     A pointer to the entry to free.
+ */
+
+static void free_entry(void * entry) {
+    free(((ttl_entry) entry)->value);
+    free(entry);
+}
+
+
+/*!
+ * \brief           Compare the keys of two entries.
+ * \param data      `void` pointer to entry to be compared.
+ * \param cmp       `void` pointer to comparison entry.
+ * \returns         Less than zero, zero or greater than zero if the key
+ * of data is less than, equal to or greater than the key of cmp.
+ */
+
+static int compare_entry(const void * data, const void * cmp) {
+    return strcmp(((const ttl_entry_t *) data)->key,
+                  ((const ttl_entry_t *) cmp)->key);
+}
+
+
+/*!
+ * \brief           Searches a map for a key.
+ * \details         Expired entries which have not yet been reaped are
+ * still found.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the entry for the key, or `NULL` if the
+ * key was not found.
+ */
+
+static ttl_entry search_entry(const ttl_map map, const char * key) {
+    bs_tree_node node = map->index->root;
+
+    while ( node ) {
+        const int compare = strcmp(key, ((ttl_entry) node->data)->key);
+
+        if ( compare == 0 ) {
+            return node->data;
+        } else if ( compare < 0 ) {
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!
+ * \brief           Schedules an entry in the timer wheel.
+ * \details         The entry goes in the lowest level whose span covers
+ * its deadline, in the slot which that level will reach at its deadline.
+ * Deadlines beyond the span of the whole wheel are parked in the top
+ * level's furthest slot, and rescheduled when that slot is cascaded.
+ * \param map       A pointer to the map.
+ * \param entry     A pointer to the entry.
+ */
+
+static void schedule_entry(ttl_map map, ttl_entry entry) {
+    uint64_t deadline = entry->deadline;
+    if ( deadline < map->current ) {
+        deadline = map->current;
+    }
+
+    const uint64_t diff = deadline - map->current;
+    int level = 0;
+    while ( level < WHEEL_LEVELS - 1 &&
+            diff >> (WHEEL_BITS * (level + 1)) ) {
+        ++level;
+    }
+
+    if ( diff >> (WHEEL_BITS * WHEEL_LEVELS) ) {
+        deadline = map->current +
+                   (UINT64_C(1) << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    }
+
+    const size_t slot = (deadline >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    entry->slot = map->wheel[level][slot];
+    entry->level = level;
+    dl_list_insert_node_back(entry->slot, &entry->node);
+    ++map->level_count[level];
+}
+
+
+/*!
+ * \brief           Removes an entry from the timer wheel.
+ * \param map       A pointer to the map.
+ * \param entry     A pointer to the entry.
+ */
+
+static void unschedule_entry(ttl_map map, ttl_entry entry) {
+    dl_list_remove_node(entry->slot, &entry->node);
+    --map->level_count[entry->level];
+}
+
+
+/*!
+ * \brief           Reschedules every entry in a timer wheel slot.
+ * \param map       A pointer to the map.
+ * \param level     The level of the slot.
+ * \param slot      The index of the slot.
+ */
+
+static void cascade_slot(ttl_map map, const int level, const size_t slot) {
+    dl_list_node node;
+
+    while ( (node = dl_list_remove_node_front(map->wheel[level][slot])) ) {
+        --map->level_count[level];
+        schedule_entry(map, node->data);
+    }
+}
+
+
+/*!
+ * \brief           Reaps every entry in the current level 0 slot.
+ * \param map       A pointer to the map.
+ * \returns         The number of entries reaped.
+ */
+
+static size_t expire_slot(ttl_map map) {
+    dl_list slot = map->wheel[0][map->current & WHEEL_MASK];
+    dl_list_node node;
+    size_t reaped = 0;
+
+    while ( (node = dl_list_remove_node_front(slot)) ) {
+        --map->level_count[0];
+        free(bs_tree_remove(map->index, node->data));
+        free_entry(node->data);
+        ++reaped;
+    }
+
+    return reaped;
+}
+
+
+/*!
+ * \brief           Turns the timer wheel up to a specified tick.
+ * \details         Runs of ticks with nothing due in level 0 are skipped
+ * up to the next point at which a higher level must be cascaded, so an
+ * idle map catches up quickly.
+ * \param map       A pointer to the map.
+ * \param now       The tick to turn the wheel up to, inclusive.
+ * \returns         The number of entries reaped.
+ */
+
+static size_t advance_wheel(ttl_map map, const uint64_t now) {
+    size_t reaped = 0;
+
+    while ( map->current <= now ) {
+        if ( bs_tree_isempty(map->index) ) {
+            map->current = now + 1;
+            break;
+        }
+
+        for ( int level = WHEEL_LEVELS - 1; level > 0; --level ) {
+            const uint64_t span = UINT64_C(1) << (WHEEL_BITS * level);
+            if ( (map->current & (span - 1)) == 0 ) {
+                cascade_slot(map, level, (map->current / span) & WHEEL_MASK);
+            }
+        }
+
+        reaped += expire_slot(map);
+
+        if ( map->level_count[0] ) {
+            ++map->current;
+        } else {
+            const uint64_t next = (map->current | WHEEL_MASK) + 1;
+            map->current = (next <= now) ? next : now + 1;
+        }
+    }
+
+    return reaped;
+}
+
+
+/*!
+ * \brief           Initializes a new expiring map.
+ * \param clock_func    A pointer to a function returning the current
+ * time, in whatever units the map's time-to-live values are to be given.
+ * The time must never go backwards. If this is `NULL`, the monotonic
+ * system clock in milliseconds is used.
+ * \returns         A pointer to the new map.
+ */
+
+ttl_map ttl_map_init(uint64_t (*clock_func)(void)) {
+    ttl_map new_map = term_malloc(sizeof(*new_map));
+    new_map->index = bs_tree_init(compare_entry, free_entry);
+    new_map->clock_func = clock_func ? clock_func : monotonic_ms;
+    new_map->current = new_map->clock_func();
+
+    for ( int level = 0; level < WHEEL_LEVELS; ++level ) {
+        new_map->level_count[level] = 0;
+        for ( size_t slot = 0; slot < WHEEL_SLOTS; ++slot ) {
+            new_map->wheel[level][slot] = dl_list_init_circular(NULL, NULL);
+        }
+    }
+
+    return new_map;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with an expiring map.
+ * \param map       A pointer to the map to free.
+ */
+
+void ttl_map_free(ttl_map map) {
+
+    /*  Slot nodes are embedded in the entries, so unlink them all
+     *  before the slots are freed, and free the entries with the tree.  */
+
+    for ( int level = 0; level < WHEEL_LEVELS; ++level ) {
+        for ( size_t slot = 0; slot < WHEEL_SLOTS; ++slot ) {
+            while ( dl_list_remove_node_front(map->wheel[level][slot]) ) {
+                ;
+            }
+            dl_list_free(map->wheel[level][slot]);
+        }
+    }
+
+    bs_tree_free(map->index);
+    free(map);
+}
+
+
+/*!
+ * \brief           Returns the number of elements in an expiring map.
+ * \details         Expired elements which have not yet been reaped are
+ * included in the count. Call ttl_map_reap() first for an exact count.
+ * \param map       A pointer to the map.
+ * \returns         The number of elements in the map.
+ */
+
+size_t ttl_map_length(const ttl_map map) {
+    return bs_tree_length(map->index);
+}
+
+
+/*!
+ * \brief           Checks if an expiring map is empty.
+ * \details         Expired elements which have not yet been reaped are
+ * included, as for ttl_map_length().
+ * \param map       A pointer to the map.
+ * \returns         `true` if the map is empty, otherwise `false`.
+ */
+
+bool ttl_map_isempty(const ttl_map map) {
+    return bs_tree_isempty(map->index);
+}
+
+
+/*!
+ * \brief           Inserts a key-value pair into an expiring map.
+ * \details         Any expired elements due are reaped first. The value
+ * is replaced if the key is already found in the map, and its deadline
+ * is reset. Any memory consumed by the old value is automatically
+ * `free()`d.
+ * \param map       A pointer to the map.
+ * \param key       The key of the new value to insert.
+ * \param value     A pointer to the new value to insert.
+ * \param ttl       The time, in units of the map's clock, after which
+ * the element expires.
+ * \returns         `true` if the key was already in the map and the
+ * value has been replaced, `false` if the key was not present.
+ */
+
+bool ttl_map_insert(ttl_map map, const char * key,
+                    void * value, const uint64_t ttl) {
+    const uint64_t now = map->clock_func();
+    const uint64_t deadline = (ttl > UINT64_MAX - now) ? UINT64_MAX
+                                                       : now + ttl;
+    advance_wheel(map, now);
+
+    bs_tree_node * p_node = &map->index->root;
+
+    while ( *p_node ) {
+        ttl_entry entry = (*p_node)->data;
+        const int compare = strcmp(key, entry->key);
+
+        if ( compare == 0 ) {
+            free(entry->value);
+            entry->value = value;
+            unschedule_entry(map, entry);
+            entry->deadline = deadline;
+            schedule_entry(map, entry);
+            return true;
+        } else if ( compare < 0 ) {
+            p_node = &(*p_node)->left;
+        } else {
+            p_node = &(*p_node)->right;
+        }
+    }
+
+    const size_t key_size = strlen(key) + 1;
+    ttl_entry new_entry = term_malloc(sizeof(*new_entry) + key_size);
+    new_entry->node.data = new_entry;
+    new_entry->node.next = NULL;
+    new_entry->node.prev = NULL;
+    new_entry->deadline = deadline;
+    new_entry->value = value;
+    memcpy(new_entry->key, key, key_size);
+
+    *p_node = bs_tree_new_node(new_entry);
+    ++map->index->length;
+    bs_tree_filter_add(map->index, new_entry);
+    schedule_entry(map, new_entry);
+
+    return false;
+}
+
+
+/*!
+ * \brief           Deletes a key and its value from an expiring map.
+ * \details         Any expired elements due are reaped first.
+ * \param map       A pointer to the map.
+ * \param key       The key to delete.
+ * \returns         `true` if the key was found and deleted, `false` if
+ * the key was not present or had expired.
+ */
+
+bool ttl_map_delete(ttl_map map, const char * key) {
+    advance_wheel(map, map->clock_func());
+
+    ttl_entry entry = search_entry(map, key);
+    if ( entry == NULL ) {
+        return false;
+    }
+
+    unschedule_entry(map, entry);
+    free(bs_tree_remove(map->index, entry));
+    free_entry(entry);
+    return true;
+}
+
+
+/*!
+ * \brief           Determines if an unexpired key is in an expiring map.
+ * \details         An expired key is reported as missing even if it has
+ * not yet been reaped.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         `true` is the key is found, `false` otherwise.
+ */
+
+bool ttl_map_search(const ttl_map map, const char * key) {
+    return ttl_map_search_data(map, key) ? true : false;
+}
+
+
+/*!
+ * \brief           Searches an expiring map for an unexpired value
+ * matching a key and returns it.
+ * \details         An expired key is reported as missing even if it has
+ * not yet been reaped.
+ * \param map       A pointer to the map.
+ * \param key       The key for which to search.
+ * \returns         A pointer to the value if found, `NULL` otherwise.
+ */
+
+void * ttl_map_search_data(const ttl_map map, const char * key) {
+    ttl_entry entry = search_entry(map, key);
+
+    if ( entry == NULL || map->clock_func() >= entry->deadline ) {
+        return NULL;
+    }
+
+    return entry->value;
+}
+
+
+/*!
+ * \brief           Reaps all expired elements from an expiring map.
+ * \details         Elements are also reaped as a side effect of
+ * ttl_map_insert() and ttl_map_delete(), so this need only be called to
+ * release memory from a map which is otherwise idle.
+ * \param map       A pointer to the map.
+ * \returns         The number of elements reaped.
+ */
+
+size_t ttl_map_reap(ttl_map map) {
+    return advance_wheel(map, map->clock_func());
+}
+
+
+/*!
+ * \brief           Locks an expiring map's mutex.
+ * \param map       A pointer to the map.
+ */
+
+void ttl_map_lock(ttl_map map) {
+    bs_tree_lock(map->index);
+}
+
+
+/*!
+ * \brief           Unlocks an expiring map's mutex.
+ * \param map       A pointer to the map.
+ */
+
+void ttl_map_unlock(ttl_map map) {
+    bs_tree_unlock(map->index);
+}
@@ -0,0 +1,674 @@
+/*!
+ * \file            ul_list.c
+ * \brief           Implementation of unrolled linked list data structure.
+ * \details         Each node holds an array of up to
+ * `UL_LIST_NODE_CAPACITY` data pointers, rather than a single one, so a
+ * scan reads one node, two cache lines, for every dozen or so elements,
+ * and node overhead is shared between them.
+ *
+ * Inserting into a full node moves its upper half to a new node, except
+ * at either end of the node, where the element spills into a neighbour
+ * with room or into a new node of its own, so that a list built by
+ * appending or prepending has full nodes. Deleting from a node which
+ * falls below half full takes an element from the next node, or merges
+ * the two if they fit in one, so that nodes other than the last stay at
+ * least half full.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <paulgrif/chelpers.h>
+#include "cds_common.h"
+#include "ul_list.h"
+
+
+#ifdef CDS_THREAD_SUPPORT
+  #include <pthread.h>
+#endif
+
+
+/*!
+ * \brief           Returns an iterator which refers to no element.
+ * \returns         The iterator.
+ */
+
+static ul_list_itr null_itr(void) {
+    ul_list_itr itr = {NULL, 0};
+    return itr;
+}
+
+
+/*!
+ * \brief           Creates and links in a new empty node.
+ * \param list      A pointer to the list.
+ * \param after     A pointer to the node after which to link the new
+ * node, or `NULL` to link it at the front of the list.
+ * \returns         A pointer to the new node.
+ */
+
+static ul_list_node link_new_node(ul_list list, ul_list_node after) {
+    ul_list_node new_node = term_malloc(sizeof(*new_node));
+    new_node->count = 0;
+    new_node->prev = after;
+
+    if ( after ) {
+        new_node->next = after->next;
+        after->next = new_node;
+    } else {
+        new_node->next = list->front;
+        list->front = new_node;
+    }
+
+    if ( new_node->next ) {
+        new_node->next->prev = new_node;
+    } else {
+        list->back = new_node;
+    }
+
+    return new_node;
+}
+
+
+/*!
+ * \brief           Unlinks and frees a node, but not its data.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ */
+
+static void unlink_node(ul_list list, ul_list_node node) {
+    if ( node->prev ) {
+        node->prev->next = node->next;
+    } else {
+        list->front = node->next;
+    }
+
+    if ( node->next ) {
+        node->next->prev = node->prev;
+    } else {
+        list->back = node->prev;
+    }
+
+    free(node);
+}
+
+
+/*!
+ * \brief           Initializes a new unrolled linked list.
+ * \param cfunc     A pointer to a compare function. The function should
+ * return `int` and accept two parameters of type `void *`. It should
+ * return less than 1 if the first parameter is less than the second,
+ * greater than 1 if the first parameter is greater than the second,
+ * and zero if the parameters are equal.
+ * \param free_func A pointer to a function to free an element. The
+ * function should return no value, and accept a `void` pointer to the
+ * element. If `NULL` is specified, the standard `free()` function is used.
+ * \returns         A pointer to the new list.
+ */
+
+ul_list ul_list_init(int (*cfunc)(const void *, const void *),
+                     void (*free_func)(void *)) {
+    ul_list new_list = term_malloc(sizeof(*new_list));
+
+    new_list->front = NULL;
+    new_list->back = NULL;
+    new_list->length = 0;
+    new_list->cfunc = cfunc;
+
+    if ( free_func ) {
+        new_list->free_func = free_func;
+    } else {
+        new_list->free_func = free;
+    }
+
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_init(&new_list->mutex, NULL);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't initialize mutex", stderr);
+        exit(EXIT_FAILURE);
+    }
+#endif
+
+    return new_list;
+}
+
+
+/*!
+ * \brief           Frees the resources associated with a list.
+ * \param list      A pointer to the list to free.
+ */
+
+void ul_list_free(ul_list list) {
+    ul_list_node node = list->front;
+
+    while ( node ) {
+        ul_list_node next = node->next;
+        for ( size_t i = 0; i < node->count; ++i ) {
+            list->free_func(node->data[i]);
+        }
+        free(node);
+        node = next;
+    }
+
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_destroy(&list->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't destroy mutex", stderr);
+    }
+#endif
+
+    free(list);
+}
+
+
+/*!
+ * \brief           Returns the number of elements in a list.
+ * \param list      A pointer to the list.
+ * \returns         The number of elements in the list.
+ */
+
+size_t ul_list_length(const ul_list list) {
+    return list->length;
+}
+
+
+/*!
+ * \brief           Checks if a list is empty.
+ * \param list      A pointer to the list.
+ * \returns         `true` if the list is empty, otherwise `false`.
+ */
+
+bool ul_list_isempty(const ul_list list) {
+    return ( list->front ) ? false : true;
+}
+
+
+/*!
+ * \brief           Inserts an element at the beginning of a list.
+ * \param list      A pointer to the list.
+ * \param data      A pointer to the data to add. The memory pointed
+ * to by this parameter must be dynamically allocated, as an attempt
+ * will be made to `free()` it when deleting the list.
+ */
+
+void ul_list_prepend(ul_list list, void * data) {
+    if ( list->front ) {
+        ul_list_insert_in_node(list, list->front, 0, data);
+    } else {
+        ul_list_append(list, data);
+    }
+}
+
+
+/*!
+ * \brief           Inserts an element at the end of a list.
+ * \param list      A pointer to the list.
+ * \param data      A pointer to the data to add. The memory pointed
+ * to by this parameter must be dynamically allocated, as an attempt
+ * will be made to `free()` it when deleting the list.
+ */
+
+void ul_list_append(ul_list list, void * data) {
+    if ( list->back ) {
+        ul_list_insert_in_node(list, list->back, list->back->count, data);
+    } else {
+        ul_list_node new_node = link_new_node(list, NULL);
+        new_node->data[new_node->count++] = data;
+        ++list->length;
+    }
+}
+
+
+/*!
+ * \brief           Inserts an element before a provided iterator.
+ * \details         Iterators to elements after the insertion point in the
+ * same node, or in a node which is split, are invalidated.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator before which to insert.
+ * \param data      A pointer to the data to add. The memory pointed
+ * to by this parameter must be dynamically allocated, as an attempt
+ * will be made to `free()` it when deleting the list.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` refers to
+ * no element.
+ */
+
+int ul_list_insert_before(ul_list list, const ul_list_itr itr, void * data) {
+    if ( itr.node == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
+
+    ul_list_insert_in_node(list, itr.node, itr.slot, data);
+    return 0;
+}
+
+
+/*!
+ * \brief           Inserts an element at the specified index of a list.
+ * \param list      A pointer to the list.
+ * \param index     The index at which to insert. Setting this equal
+ * to the length of the list (i.e. to one element past the zero-based
+ * index of the last element) inserts the element at the end of the list.
+ * \param data      A pointer to the data to add. The memory pointed
+ * to by this parameter must be dynamically allocated, as an attempt
+ * will be made to `free()` it when deleting the list.
+ * \returns         0 on success, CDSERR_OUTOFRANGE if `index` exceeds
+ * the length of the list.
+ */
+
+int ul_list_insert_at(ul_list list, const size_t index, void * data) {
+    if ( index > list->length ) {
+        return CDSERR_OUTOFRANGE;
+    }
+
+    if ( index == list->length ) {
+        ul_list_append(list, data);
+    } else {
+        ul_list_itr itr = ul_list_itr_from_index(list, index);
+        ul_list_insert_in_node(list, itr.node, itr.slot, data);
+    }
+
+    return 0;
+}
+
+
+/*!
+ * \brief           Inserts an element after a provided iterator.
+ * \details         Iterators to elements after the insertion point in the
+ * same node, or in a node which is split, are invalidated.
+ * \param list      A pointer to the list.
+ * \param itr       The iterator after which to insert.
+ * \param data      A pointer to the data to add. The memory pointed
+ * to by this parameter must be dynamically allocated, as an attempt
+ * will be made to `free()` it when deleting the list.
+ * \returns         0 on success, CDSERR_BADITERATOR if `itr` refers to
+ * no element.
+ */
+
+int ul_list_insert_after(ul_list list, const ul_list_itr itr, void * data) {
+    if ( itr.node == NULL ) {
+        return CDSERR_BADITERATOR;
+    }
+
+    ul_list_insert_in_node(list, itr.node, itr.slot + 1, data);
+    return 0;
+}
+
+
+/*!
+ * \brief           Deletes a list element at a specified index.
+ * \details         Iterators to the element's node and the node after it
+ * are invalidated.
+ * \param list      A pointer to the list.
+ * \param index     The index of the element to delete.
+ * \returns         0 on success, CDSERR_OUTOFRANGE if the the index
+ * is out of range.
+ */
+
+int ul_list_delete_at(ul_list list, const size_t index) {
+    if ( index >= list->length ) {
+        return CDSERR_OUTOFRANGE;
+    }
+
+    ul_list_itr itr = ul_list_itr_from_index(list, index);
+    list->free_func(ul_list_remove_in_node(list, itr.node, itr.slot));
+    return 0;
+}
+
+
+/*!
+ * \brief           Gets an index to the specified data in a list.
+ * \param list      A pointer to the list.
+ * \param data      A pointer to the data to find.
+ * \returns         The index of the found element, or CDSERR_NOTFOUND
+ * if the element is not in the list.
+ */
+
+int ul_list_find_index(const ul_list list, const void * data) {
+    int index;
+    ul_list_find(list, data, NULL, &index);
+    return index;
+}
+
+
+/*!
+ * \brief           Gets an iterator to the specified data in a list.
+ * \param list      A pointer to the list.
+ * \param data      A pointer to the data to find.
+ * \returns         An iterator to the found element, which refers to no
+ * element if the data is not in the list.
+ */
+
+ul_list_itr ul_list_find_itr(const ul_list list, const void * data) {
+    ul_list_itr itr;
+    ul_list_find(list, data, &itr, NULL);
+    return itr;
+}
+
+
+/*!
+ * \brief           Returns a pointer to the data at a specified index.
+ * \param list      A pointer to the list.
+ * \param index     The index of the data.
+ * \returns         A pointer to the data, or NULL if the index is out
+ * of range.
+ */
+
+void * ul_list_data(const ul_list list, const size_t index) {
+    ul_list_itr itr = ul_list_itr_from_index(list, index);
+    return itr.node ? itr.node->data[itr.slot] : NULL;
+}
+
+
+/*!
+ * \brief           Returns an iterator to the first element of a list.
+ * \param list      A pointer to the list.
+ * \returns         An iterator to the first element.
+ */
+
+ul_list_itr ul_list_first(const ul_list list) {
+    ul_list_itr itr = {list->front, 0};
+    return itr;
+}
+
+
+/*!
+ * \brief           Returns an iterator to the last element of a list.
+ * \param list      A pointer to the list.
+ * \returns         An iterator to the last element.
+ */
+
+ul_list_itr ul_list_last(const ul_list list) {
+    if ( list->back == NULL ) {
+        return null_itr();
+    }
+
+    ul_list_itr itr = {list->back, list->back->count - 1};
+    return itr;
+}
+
+
+/*!
+ * \brief           Advances a list iterator by one element.
+ * \param itr       The iterator to advance.
+ * \returns         The advanced iterator.
+ */
+
+ul_list_itr ul_list_next(const ul_list_itr itr) {
+    ul_list_itr next = itr;
+
+    if ( ++next.slot == next.node->count ) {
+        next.node = next.node->next;
+        next.slot = 0;
+    }
+
+    return next;
+}
+
+
+/*!
+ * \brief           Moves a list iterator back by one element.
+ * \param itr       The iterator to move.
+ * \returns         The moved iterator.
+ */
+
+ul_list_itr ul_list_prev(const ul_list_itr itr) {
+    ul_list_itr prev = itr;
+
+    if ( prev.slot > 0 ) {
+        --prev.slot;
+    } else {
+        prev.node = prev.node->prev;
+        prev.slot = prev.node ? prev.node->count - 1 : 0;
+    }
+
+    return prev;
+}
+
+
+/*!
+ * \brief           Return an iterator to a specified element of a list.
+ * \details         Nodes are counted from whichever end of the list is
+ * nearer the index.
+ * \param list      A pointer to the list.
+ * \param index     The specified index.
+ * \returns         The iterator, which refers to no element if `index`
+ * is out of range.
+ */
+
+ul_list_itr ul_list_itr_from_index(const ul_list list, const size_t index) {
+    if ( index >= list->length ) {
+        return null_itr();
+    }
+
+    ul_list_itr itr;
+
+    if ( index <= list->length / 2 ) {
+
+        /*  Find indexed element from front  */
+
+        size_t i = index;
+        ul_list_node node = list->front;
+        while ( i >= node->count ) {
+            i -= node->count;
+            node = node->next;
+        }
+        itr.node = node;
+        itr.slot = i;
+    } else {
+
+        /*  Find indexed element from back  */
+
+        size_t after = list->length - 1 - index;
+        ul_list_node node = list->back;
+        while ( after >= node->count ) {
+            after -= node->count;
+            node = node->prev;
+        }
+        itr.node = node;
+        itr.slot = node->count - 1 - after;
+    }
+
+    return itr;
+}
+
+
+/*!
+ * \brief           Checks if an iterator refers to an element.
+ * \param itr       The iterator.
+ * \returns         `true` if the iterator refers to an element, `false`
+ * if it has moved past either end of the list.
+ */
+
+bool ul_list_itr_valid(const ul_list_itr itr) {
+    return itr.node ? true : false;
+}
+
+
+/*!
+ * \brief           Returns a pointer to the data an iterator refers to.
+ * \param itr       The iterator, which must refer to an element.
+ * \returns         A pointer to the data.
+ */
+
+void * ul_list_itr_data(const ul_list_itr itr) {
+    return itr.node->data[itr.slot];
+}
+
+
+/*!
+ * \brief           Inserts an element at a position in a node.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ * \param slot      The position in the node, up to and including its
+ * number of elements.
+ * \param data      A pointer to the data to add.
+ */
+
+void ul_list_insert_in_node(ul_list list, ul_list_node node,
+                            size_t slot, void * data) {
+    if ( node->count == UL_LIST_NODE_CAPACITY ) {
+        if ( slot == UL_LIST_NODE_CAPACITY ) {
+
+            /*  Spill onto the front of the next node, or a new one  */
+
+            if ( node->next &&
+                 node->next->count < UL_LIST_NODE_CAPACITY ) {
+                ul_list_insert_in_node(list, node->next, 0, data);
+                return;
+            }
+            node = link_new_node(list, node);
+            slot = 0;
+        } else if ( slot == 0 ) {
+
+            /*  Spill onto the back of the previous node, or a new one  */
+
+            if ( node->prev &&
+                 node->prev->count < UL_LIST_NODE_CAPACITY ) {
+                ul_list_insert_in_node(list, node->prev,
+                                       node->prev->count, data);
+                return;
+            }
+            node = link_new_node(list, node->prev);
+        } else {
+
+            /*  Move the upper half of the node to a new node  */
+
+            ul_list_node new_node = link_new_node(list, node);
+            const size_t keep = UL_LIST_NODE_CAPACITY / 2 + 1;
+            new_node->count = UL_LIST_NODE_CAPACITY - keep;
+            memcpy(new_node->data, node->data + keep,
+                   sizeof(*node->data) * new_node->count);
+            node->count = keep;
+
+            if ( slot > keep ) {
+                slot -= keep;
+                node = new_node;
+            }
+        }
+    }
+
+    memmove(node->data + slot + 1, node->data + slot,
+            sizeof(*node->data) * (node->count - slot));
+    node->data[slot] = data;
+    ++node->count;
+    ++list->length;
+}
+
+
+/*!
+ * \brief           Removes, but does not delete, an element from a node.
+ * \details         A node left empty is freed, and a node left less than
+ * half full is refilled from the next node.
+ * \param list      A pointer to the list.
+ * \param node      A pointer to the node.
+ * \param slot      The position of the element in the node.
+ * \returns         A pointer to the element's data, which should be
+ * `free()`d by the caller if necessary.
+ */
+
+void * ul_list_remove_in_node(ul_list list, ul_list_node node,
+                              const size_t slot) {
+    void * data = node->data[slot];
+
+    memmove(node->data + slot, node->data + slot + 1,
+            sizeof(*node->data) * (node->count - slot - 1));
+    --node->count;
+    --list->length;
+
+    ul_list_node next = node->next;
+
+    if ( node->count == 0 ) {
+        unlink_node(list, node);
+    } else if ( node->count < UL_LIST_NODE_CAPACITY / 2 && next ) {
+        if ( node->count + next->count <= UL_LIST_NODE_CAPACITY ) {
+            memcpy(node->data + node->count, next->data,
+                   sizeof(*node->data) * next->count);
+            node->count += next->count;
+            unlink_node(list, next);
+        } else {
+            node->data[node->count++] = next->data[0];
+            memmove(next->data, next->data + 1,
+                    sizeof(*next->data) * --next->count);
+        }
+    }
+
+    return data;
+}
+
+
+/*!
+ * \brief           Gets an index and iterator to a specified piece of data.
+ * \param list      A pointer to the list.
+ * \param data      A pointer to the data to find.
+ * \param p_itr     A pointer to an iterator to populate with the result.
+ * This parameter is ignored if set to NULL.
+ * \param p_index   A pointer to an integer index to populate with the result.
+ * This parameter is ignored if set to NULL.
+ */
+
+void ul_list_find(const ul_list list, const void * data,
+                  ul_list_itr * p_itr, int * p_index) {
+    ul_list_itr itr = null_itr();
+    int index = 0;
+
+    for ( ul_list_node node = list->front;
+          node && !itr.node; node = node->next ) {
+        for ( size_t i = 0; i < node->count; ++i ) {
+            if ( list->cfunc(node->data[i], data) == 0 ) {
+                itr.node = node;
+                itr.slot = i;
+                break;
+            }
+            ++index;
+        }
+    }
+
+    if ( p_itr ) {
+        *p_itr = itr;
+    }
+
+    if ( p_index ) {
+        *p_index = itr.node ? index : CDSERR_NOTFOUND;
+    }
+}
+
+
+/*!
+ * \brief           Locks a list's mutex.
+ * \param list      A pointer to the list.
+ */
+
+void ul_list_lock(ul_list list) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_lock(&list->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't lock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) list;        /*  Avoid unused parameter warning  */
+#endif
+}
+
+
+/*!
+ * \brief           Unlocks a list's mutex.
+ * \param list      A pointer to the list.
+ */
+
+void ul_list_unlock(ul_list list) {
+#ifdef CDS_THREAD_SUPPORT
+    int status = pthread_mutex_unlock(&list->mutex);
+    if ( status != 0 ) {
+        fputs("cdatastruct error: couldn't unlock mutex.", stderr);
+        exit(EXIT_FAILURE);
+    }
+#else
+    (void) list;        /*  Avoid unused parameter warning  */
+#endif
+}
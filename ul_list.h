@@ -0,0 +1,71 @@
+/*!
+ * \file            ul_list.h
+ * \brief           Developer interface to unrolled linked list data
+ * structure.
+ * \author          Paul Griffiths
+ * \copyright       Copyright 2013 Paul Griffiths. Distributed under the terms
+ * of the GNU General Public License. <http://www.gnu.org/licenses/>
+ */
+
+
+#ifndef PG_CDS_UNROLLED_LINKED_LIST_DEV_H
+#define PG_CDS_UNROLLED_LINKED_LIST_DEV_H
+
+#include <stddef.h>
+#include "cds_ul_list.h"
+
+
+#ifdef CDS_THREAD_SUPPORT
+
+  /*!
+   * \brief         Enable POSIX library.
+   */
+
+  #define _POSIX_C_SOURCE 200809L
+  #include <pthread.h>
+#endif
+
+
+/*!
+ * \brief           Struct to contain a list.
+ */
+
+typedef struct ul_list_t {
+#ifdef CDS_THREAD_SUPPORT
+    pthread_mutex_t mutex;              /*!< Mutex */
+#endif
+    struct ul_list_node_t * front;      /*!< Pointer to first node */
+    struct ul_list_node_t * back;       /*!< Pointer to last node */
+    size_t length;                      /*!< Length of list */
+    int (*cfunc)();                     /*!< Pointer to compare function */
+    void (*free_func)();                /*!< Pointer to free function */
+} ul_list_t;
+
+
+/*!
+ * \brief           Typedef for list node.
+ */
+
+typedef struct ul_list_node_t * ul_list_node;
+
+
+/*  Function declarations  */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ul_list_insert_in_node(ul_list list, ul_list_node node,
+                            size_t slot, void * data);
+void * ul_list_remove_in_node(ul_list list, ul_list_node node,
+                              const size_t slot);
+
+void ul_list_find(const ul_list list, const void * data,
+                  ul_list_itr * p_itr, int * p_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif          /*  PG_CDS_UNROLLED_LINKED_LIST_DEV_H  */